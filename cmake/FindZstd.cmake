@@ -0,0 +1,48 @@
+# FindZstd.cmake
+#
+# Finds the Zstandard library.
+#
+# This will define the following variables
+#
+#    Zstd_FOUND
+#    Zstd_INCLUDE_DIRS
+#    Zstd_LIBRARIES
+#    Zstd_VERSION
+#
+# and the following imported targets
+#
+#    Zstd::Zstd
+#
+
+if (PC_Zstd_INCLUDEDIR AND PC_Zstd_LIBDIR)
+    set(Zstd_FIND_QUIETLY TRUE)
+endif ()
+
+find_package(PkgConfig REQUIRED)
+pkg_check_modules(PC_Zstd REQUIRED libzstd)
+
+set(Zstd_VERSION ${PC_Zstd_VERSION})
+
+find_path(Zstd_INCLUDE_DIR zstd.h HINTS ${PC_Zstd_INCLUDEDIR})
+find_library(Zstd_LIBRARY zstd HINTS ${PC_Zstd_LIBDIR})
+
+mark_as_advanced(Zstd_INCLUDE_DIR Zstd_LIBRARY)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Zstd
+        REQUIRED_VARS Zstd_INCLUDE_DIR Zstd_LIBRARY
+        VERSION_VAR Zstd_VERSION
+        )
+
+if (Zstd_FOUND)
+    set(Zstd_INCLUDE_DIRS ${Zstd_INCLUDE_DIR})
+    set(Zstd_LIBRARIES ${Zstd_LIBRARY})
+endif ()
+
+if (Zstd_FOUND AND NOT TARGET Zstd::Zstd)
+    add_library(Zstd::Zstd INTERFACE IMPORTED)
+    set_target_properties(Zstd::Zstd PROPERTIES
+            INTERFACE_INCLUDE_DIRECTORIES "${Zstd_INCLUDE_DIRS}"
+            INTERFACE_LINK_LIBRARIES "${Zstd_LIBRARIES}"
+            )
+endif ()
@@ -0,0 +1,81 @@
+#ifndef LOAM_MAPPER__BLOCK_DECODER_HPP_
+#define LOAM_MAPPER__BLOCK_DECODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace loam_mapper::points_provider::block_decoder
+{
+constexpr std::size_t count_channels_block = 32;
+// A data point is a little endian uint16 distance in sensor units followed by a reflectivity byte.
+constexpr std::size_t size_data_point = 3;
+
+// Points closer than 2 m or further than 60 m are dropped.
+constexpr std::uint32_t millimeters_range_min = 2000;
+constexpr std::uint32_t millimeters_range_max = 60000;
+
+// Fixed terms of the channels of a block, computed once the sensor model and its calibration are
+// known. With d the measured distance, v the vertical angle and a the azimuth of a channel:
+//   xy = d * cos_vertical + offset_xy, z = d * sin_vertical + offset_z
+//   x = xy * sin(a) - offset_horizontal * cos(a), y = xy * cos(a) + offset_horizontal * sin(a)
+// The offsets fold in the distance, vertical and horizontal offsets of the laser, in meters.
+struct ChannelTable
+{
+  alignas(32) float cos_vertical[count_channels_block];
+  alignas(32) float sin_vertical[count_channels_block];
+  alignas(32) float offset_xy[count_channels_block];
+  alignas(32) float offset_z[count_channels_block];
+  alignas(32) float offset_horizontal[count_channels_block];
+  std::uint32_t millimeters_per_distance_unit;
+  // Range gate, in distance units
+  std::uint32_t distance_min;
+  std::uint32_t distance_max;
+};
+
+// Azimuth advance of each channel's firing since the first firing of its block, plus the azimuth
+// offset of its laser. Computed once per packet from the rotation speed.
+struct FiringOffsets
+{
+  alignas(32) float angle_deg[count_channels_block];
+  alignas(32) float sin[count_channels_block];
+  alignas(32) float cos[count_channels_block];
+};
+
+struct DecodedBlock
+{
+  alignas(32) float x[count_channels_block];
+  alignas(32) float y[count_channels_block];
+  alignas(32) float z[count_channels_block];
+  // In [0, 360)
+  alignas(32) float angle_deg_azimuth[count_channels_block];
+  // Bit i is set if channel i is within the range gate
+  std::uint32_t mask_valid;
+};
+
+// Decodes the 32 data points of a block. x/y/z are only meaningful for valid channels.
+// data_points must be readable for one byte past the block, which always holds within a packet.
+using DecodeBlockFunction = void (*)(
+  const std::uint8_t * data_points,
+  std::uint16_t azimuth_multiplied_by_100_deg,
+  const ChannelTable & channel_table,
+  const FiringOffsets & firing_offsets,
+  DecodedBlock & decoded_block);
+
+enum class Isa { Scalar, Avx2, Neon };
+
+// All implementations produce bit identical results, the file is compiled without floating
+// point contraction and every product and sum is rounded separately.
+void decode_block_scalar(
+  const std::uint8_t * data_points,
+  std::uint16_t azimuth_multiplied_by_100_deg,
+  const ChannelTable & channel_table,
+  const FiringOffsets & firing_offsets,
+  DecodedBlock & decoded_block);
+
+// Picks the widest implementation the CPU supports.
+Isa detect_isa();
+DecodeBlockFunction get_decode_block(Isa isa);
+const char * get_name(Isa isa);
+}  // namespace loam_mapper::points_provider::block_decoder
+
+#endif  // LOAM_MAPPER__BLOCK_DECODER_HPP_
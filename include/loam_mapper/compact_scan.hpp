@@ -0,0 +1,46 @@
+#ifndef LOAM_MAPPER__COMPACT_SCAN_HPP_
+#define LOAM_MAPPER__COMPACT_SCAN_HPP_
+
+#include "loam_mapper/point_columns.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace loam_mapper::point_types
+{
+// Quantized copy of a scan in the sensor frame, for holding many scans in memory. A point takes
+// 14 bytes instead of 32:
+//   x, y, z         int16, 2 mm steps like the sensor's distances (+-65.5 m)
+//   intensity, ring uint8
+//   azimuth         uint16, hundredths of a degree like the data blocks
+//   time            uint32, nanoseconds since the earliest point of the scan (up to 4.29 s)
+// Coordinates are rounded to the nearest step, everything else is exact.
+class CompactScan
+{
+public:
+  static constexpr float meters_per_step = 0.002F;
+
+  // Whether the points of the scan span no more time than the time offsets can hold.
+  [[nodiscard]] static bool is_encodable(const PointColumnsXYZITRH & points);
+  // Throws std::range_error if the scan isn't encodable.
+  static CompactScan encode(const PointColumnsXYZITRH & points);
+  // Replaces the points with the decoded ones, reusing their capacity.
+  void decode(PointColumnsXYZITRH & points) const;
+
+  [[nodiscard]] std::size_t size() const { return x_.size(); }
+  [[nodiscard]] bool empty() const { return x_.empty(); }
+  [[nodiscard]] std::size_t get_size_bytes() const;
+
+private:
+  std::uint64_t stamp_unix_nanoseconds_start_{0U};
+  AlignedVector<std::int16_t> x_;
+  AlignedVector<std::int16_t> y_;
+  AlignedVector<std::int16_t> z_;
+  AlignedVector<std::uint8_t> intensity_;
+  AlignedVector<std::uint8_t> ring_;
+  AlignedVector<std::uint16_t> azimuth_multiplied_by_100_deg_;
+  AlignedVector<std::uint32_t> nanoseconds_since_start_;
+};
+}  // namespace loam_mapper::point_types
+
+#endif  // LOAM_MAPPER__COMPACT_SCAN_HPP_
@@ -1,8 +1,14 @@
 #ifndef LOAM_MAPPER__CONTINUOUS_PACKET_PARSER_HPP_
 #define LOAM_MAPPER__CONTINUOUS_PACKET_PARSER_HPP_
 
+#include "loam_mapper/block_decoder.hpp"
 #include "loam_mapper/date.h"
+#include "loam_mapper/packet_filter.hpp"
 #include "loam_mapper/point_types.hpp"
+#include "loam_mapper/scan_buffer_pool.hpp"
+#include "loam_mapper/scan_telemetry.hpp"
+#include "loam_mapper/velodyne_calibration.hpp"
+#include "loam_mapper/velodyne_model.hpp"
 
 #include <pcapplusplus/Packet.h>
 
@@ -19,13 +25,126 @@ class ContinuousPacketParser
 {
 public:
   using Point = point_types::PointXYZITRH;
-  using Points = std::vector<Point>;
+  using Points = scan_buffer_pool::Points;
+  using ScanLease = scan_buffer_pool::ScanLease;
 
   ContinuousPacketParser();
 
   void process_packet_into_cloud(
     const pcpp::RawPacket & rawPacket,
-    const std::function<void(const Points &)> & callback_cloud_surround_out);
+    const std::function<void(ScanLease)> & callback_cloud_surround_out);
+
+  // Same as above, for packet bytes that are owned elsewhere (e.g. a memory mapped pcap).
+  void process_packet_into_cloud(
+    const uint8_t * data_packet,
+    size_t length_packet,
+    const std::function<void(ScanLease)> & callback_cloud_surround_out);
+
+  // While priming, packets only advance the time, azimuth and scan cut state; no points are
+  // decoded. Used to bring a fresh parser to the state it would have mid-capture.
+  void set_is_priming(bool is_priming) { is_priming_ = is_priming; }
+
+  // Only points of data packets with a GPS time within [start, end] (unix nanoseconds) are
+  // decoded. Once a packet after the window is seen, is_past_time_window() turns true and
+  // following packets are ignored, so the caller can stop reading.
+  void set_time_window(
+    std::uint64_t stamp_unix_nanoseconds_start, std::uint64_t stamp_unix_nanoseconds_end);
+  [[nodiscard]] bool is_past_time_window() const { return is_past_time_window_; }
+
+  // Overrides the block decoder picked for this CPU, e.g. to compare against the scalar one.
+  void set_block_decoder_isa(block_decoder::Isa isa)
+  {
+    decode_block_ = block_decoder::get_decode_block(isa);
+  }
+
+  // Which returns of a dual return capture are decoded. Returns that are reported twice, because
+  // the strongest one is also the last one, are only decoded once. Single return captures aren't
+  // affected.
+  enum class DualReturnPolicy { Strongest, Last, Both };
+  void set_dual_return_policy(DualReturnPolicy dual_return_policy)
+  {
+    dual_return_policy_ = dual_return_policy;
+  }
+  // Accepts "strongest", "last" or "both".
+  static DualReturnPolicy parse_dual_return_policy(const std::string & name);
+
+  // Replaces the nominal laser angles of the model with the calibration of the sensor unit. Has to
+  // be set before the first data packet, models without nominal angles (VLS-128) require it.
+  void set_calibration(const velodyne_calibration::Calibration & calibration)
+  {
+    calibration_ = calibration;
+  }
+
+  // A scan starts with the first firing whose azimuth is at or past the cut azimuth, in [0, 360)
+  // degrees. Any rotation speed works, and a cut is found even if the packets around it are lost.
+  void set_angle_deg_cut(float angle_deg_cut);
+
+  // Whether finish() hands out the points after the last cut as a partial scan.
+  void set_is_emitting_partial_scan_last(bool is_emitting_partial_scan_last)
+  {
+    is_emitting_partial_scan_last_ = is_emitting_partial_scan_last;
+  }
+  [[nodiscard]] bool is_emitting_partial_scan_last() const
+  {
+    return is_emitting_partial_scan_last_;
+  }
+  // Called once the last packet is processed.
+  void finish(const std::function<void(ScanLease)> & callback_cloud_surround_out);
+
+  // Packets rejected by the filter are dropped before they are parsed.
+  void set_packet_filter(const packet_filter::PacketFilter & packet_filter)
+  {
+    packet_filter_ = packet_filter;
+  }
+
+  // True once a valid position packet and enough data packets after it have been seen for the
+  // parser state to no longer depend on where decoding started.
+  [[nodiscard]] bool is_bootstrapped() const
+  {
+    return has_received_valid_position_package_ && count_data_packets_processed_ >= 2;
+  }
+
+  // Whether the packet is a position packet of this parser's sensor with an active receiver, which
+  // decoding can be bootstrapped from. Only reads the headers and the receiver status.
+  [[nodiscard]] bool is_valid_position_packet(const uint8_t * packet, size_t length_packet) const
+  {
+    return packet_filter_.classify(packet, length_packet) ==
+             packet_filter::PacketFilter::Kind::Position &&
+           is_receiver_active(packet);
+  }
+
+  static constexpr size_t size_data_packet = packet_filter::PacketFilter::size_data_packet;
+  static constexpr size_t size_position_packet =
+    packet_filter::PacketFilter::size_position_packet;
+
+  // Extracts the UTC hour from the GPRMC sentence of a position packet. Returns false if the
+  // receiver status is not active.
+  static bool parse_hours_since_epoch(
+    const uint8_t * position_packet_bytes, date::sys_time<std::chrono::hours> & tp_hours);
+  // Reads only the receiver status of the GPRMC sentence, true if it is active.
+  static bool is_receiver_active(const uint8_t * position_packet_bytes);
+
+  // Header level accessors that don't decode the packet. The ToH (top of the hour) timestamp
+  // is read from data and position packets, the azimuth from the first block of a data packet.
+  static uint32_t read_microseconds_toh(const uint8_t * data_packet, size_t length_packet);
+  static std::uint16_t read_azimuth_multiplied_by_100_deg(const uint8_t * data_packet);
+
+  // Points collected since the last published scan, with their telemetry.
+  [[nodiscard]] const Points & get_partial_cloud() const { return cloud_; }
+  void discard_partial_cloud()
+  {
+    cloud_.clear();
+    telemetry_ = scan_telemetry::ScanTelemetry();
+  }
+  ScanLease take_partial_cloud();
+
+  // Completed scans are handed to the callback in buffers of this pool. It is shared by the
+  // copies of the parser.
+  [[nodiscard]] const std::shared_ptr<scan_buffer_pool::ScanBufferPool> & get_scan_buffer_pool()
+    const
+  {
+    return scan_buffer_pool_;
+  }
 
 private:
   using uint8_t = std::uint8_t;
@@ -67,15 +186,7 @@ private:
   std::map<uint8_t, ReturnMode> map_byte_to_return_mode_;
   std::map<ReturnMode, std::string> map_return_mode_to_string_;
 
-  enum class VelodyneModel
-  {
-    HDL32E,
-    VLP16orPuckLITE,
-    PuckHiRes,
-    VLP32CorVLP32MR,
-    Velarray,
-    VLS128
-  };
+  using VelodyneModel = velodyne_model::VelodyneModel;
 
 
   struct PositionPacket
@@ -106,17 +217,76 @@ private:
   std::map<uint8_t, VelodyneModel> map_byte_to_velodyne_model_;
   std::map<VelodyneModel, std::string> map_velodyne_model_to_string_;
 
-  std::vector<float> channel_to_angle_vertical_;
-  std::vector<float> channel_mod_8_to_azimuth_offsets_;
-  std::vector<size_t> ind_block_to_first_channel_;
+  // Laser geometry of the channels of a bank's blocks
+  struct BankGeometry
+  {
+    block_decoder::ChannelTable channel_table;
+    float angle_deg_azimuth_offset[block_decoder::count_channels_block];
+    float sin_azimuth_offset[block_decoder::count_channels_block];
+    float cos_azimuth_offset[block_decoder::count_channels_block];
+  };
+
+  // Decodes the blocks of a data packet into cloud_, the scan is handed to the callback at the cut.
+  using DecodeDataPacketFunction = void (ContinuousPacketParser::*)(
+    const DataPacket & data_packet, bool is_decoding_points,
+    const std::function<void(ScanLease)> & callback_cloud_surround_out);
+
+  velodyne_calibration::Calibration calibration_;
+  // Set from the factory bytes of the first data packet
+  std::vector<BankGeometry> banks_;
+  DecodeDataPacketFunction decode_data_packet_;
+  // Picked at construction by the instruction sets the CPU supports
+  block_decoder::DecodeBlockFunction decode_block_;
+  DualReturnPolicy dual_return_policy_;
+
+  packet_filter::PacketFilter packet_filter_;
 
   bool has_processed_a_packet_;
+  bool is_priming_;
+  size_t count_data_packets_processed_;
+
+  bool has_time_window_;
+  bool is_past_time_window_;
+  std::uint64_t stamp_unix_nanoseconds_window_start_;
+  std::uint64_t stamp_unix_nanoseconds_window_end_;
   float angle_deg_azimuth_last_packet_;
   uint32_t microseconds_last_packet_;
+  // Time between the first firings of consecutive data packets
+  uint32_t nanoseconds_data_packet_;
+  double speed_deg_per_microseconds_last_packet_;
 
+  std::shared_ptr<scan_buffer_pool::ScanBufferPool> scan_buffer_pool_;
+  // The scan being assembled, its buffer is swapped with an empty one from the pool once complete
   Points cloud_;
-  bool can_publish_again_;
+  scan_telemetry::ScanTelemetry telemetry_;
   float angle_deg_cut_;
+  // Set once a firing at least a quarter turn away from the cut is seen, so that jitter around the
+  // cut azimuth can't cut twice.
+  bool is_cut_armed_;
+  bool has_firing_last_;
+  // Azimuth of the last firing of the previous block past the cut azimuth, in [0, 360)
+  float angle_deg_relative_firing_last_;
+  bool is_emitting_partial_scan_last_;
+
+  // Counts the gaps between the previous data packet and this one into telemetry_. Has to be
+  // called before the packet is decoded.
+  void update_telemetry(const DataPacket & data_packet);
+  // Ends the scan at the firing at stamp_unix_nanoseconds_cut, which is angle_deg_cut_in_packet
+  // past the first firing of its packet, and starts the next one there.
+  void cut_scan(
+    std::uint64_t stamp_unix_nanoseconds_cut, float angle_deg_cut_in_packet,
+    bool is_decoding_points, const std::function<void(ScanLease)> & callback_cloud_surround_out);
+
+  void select_model(VelodyneModel velodyne_model, ReturnMode return_mode);
+  // Instantiated for every supported model, so the decoding loops are unrolled for its layout.
+  template <typename Traits>
+  void select_model(bool is_dual_return);
+  // In dual return mode (CountReturns = 2) the blocks come in pairs of the same firings, the
+  // last returns followed by the strongest ones.
+  template <typename Traits, size_t CountReturns>
+  void decode_data_packet(
+    const DataPacket & data_packet, bool is_decoding_points,
+    const std::function<void(ScanLease)> & callback_cloud_surround_out);
 };
 
 
@@ -20,6 +20,7 @@ namespace fs = boost::filesystem;
 using PointCloud2 = sensor_msgs::msg::PointCloud2;
 using Point = points_provider::PointsProviderBase::Point;
 using Points = points_provider::PointsProviderBase::Points;
+using PointColumns = points_provider::PointsProviderBase::PointColumns;
 
 struct smoothness_t
 {
@@ -43,9 +44,9 @@ public:
 
   explicit FeatureExtraction();
 
-  Points extractedCloud;
-  Points cornerCloud;
-  Points surfaceCloud;
+  PointColumns extractedCloud;
+  PointColumns cornerCloud;
+  PointColumns surfaceCloud;
 
   std::vector<smoothness_t> cloudSmoothness;
   float * cloudCurvature;
@@ -53,7 +54,8 @@ public:
   int * cloudLabel;
 
   void initializationValue();
-  void laserCloudInfoHandler(const Points & deskewed_cloud, utils::Utils::CloudInfo & cloudInfo);
+  void laserCloudInfoHandler(
+    const PointColumns & deskewed_cloud, utils::Utils::CloudInfo & cloudInfo);
   void calculateSmoothness(utils::Utils::CloudInfo & cloudInfo);
   void markOccludedPoints(utils::Utils::CloudInfo & cloudInfo);
   void extractFeatures(
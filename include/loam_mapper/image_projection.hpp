@@ -24,6 +24,7 @@ namespace loam_mapper::image_projection
 using PointCloud2 = sensor_msgs::msg::PointCloud2;
 using Point = points_provider::PointsProviderBase::Point;
 using Points = points_provider::PointsProviderBase::Points;
+using PointColumns = points_provider::PointsProviderBase::PointColumns;
 
 const int queueLength = 2000;
 
@@ -44,9 +45,9 @@ public:
 
   std::deque<sensor_msgs::msg::Imu> imuQueue;
   std::deque<nav_msgs::msg::Odometry> odomQueue;
-  std::deque<Points> cloudQueue;
+  std::deque<PointColumns> cloudQueue;
 
-  Points currentCloudMsg;
+  PointColumns currentCloudMsg;
 
 //  double * imuTime = new double[queueLength];
 //  double * imuRotX = new double[queueLength];
@@ -57,8 +58,8 @@ public:
 //  bool firstPointFlag{};
   Eigen::Affine3f transStartInverse;
 
-  Points fullCloud;
-  Points extractedCloud;
+  PointColumns fullCloud;
+  PointColumns extractedCloud;
 
 //  int deskewFlag{};
   cv::Mat rangeMat;
@@ -80,17 +81,17 @@ public:
 
   void imuHandler(const sensor_msgs::msg::Imu imuMsg);
   void odomHandler(const nav_msgs::msg::Odometry odometryMsg);
-  void cloudHandler(Points & laserCloudMsg);
+  void cloudHandler(PointColumns & laserCloudMsg);
 
-  void cachePointCloud(Points & laserCloudMsg);
+  void cachePointCloud(PointColumns & laserCloudMsg);
   //  bool deskewInfo();
   //  void imuDeskewInfo();
   //  void odomDeskewInfo();
   //  void findRotation(double pointTime, float * rotXCur, float * rotYCur, float * rotZCur);
   //  void findPosition(double relTime, float * posXCur, float * posYCur, float * posZCur);
   //  PointType deskewPoint(PointType * point, double relTime);
-  void projectPointCloud(Points & laserCloudMsg);
-  void cloudExtraction(Points & laserCloudMsg);
+  void projectPointCloud(PointColumns & laserCloudMsg);
+  void cloudExtraction(PointColumns & laserCloudMsg);
 //  void publishClouds();
   void resetParameters();
 };
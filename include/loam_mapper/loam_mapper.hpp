@@ -1,8 +1,11 @@
 
+#include "loam_mapper/compact_scan.hpp"
 #include "loam_mapper/points_provider.hpp"
+#include "loam_mapper/transform_chain.hpp"
 #include "loam_mapper/transform_provider.hpp"
 #include "loam_mapper/image_projection.hpp"
 #include "loam_mapper/feature_extraction.hpp"
+#include "loam_mapper/Occtree.h"
 #include <rclcpp/rclcpp.hpp>
 #include <memory>
 #include <sensor_msgs/msg/point_cloud2.hpp>
@@ -23,6 +26,8 @@ public:
   using ConstSharedPtr = const std::shared_ptr<LoamMapper>;
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using Points = points_provider::PointsProviderBase::Points;
+  using PointColumns = points_provider::PointsProviderBase::PointColumns;
+  using ScanLease = points_provider::PointsProvider::ScanLease;
 
 
 
@@ -44,12 +49,39 @@ public:
   bool enable_ned2enu_;
   double voxel_resolution_;
   bool save_pcd_;
+  bool enable_streaming_;
+  int64_t count_threads_decode_;
+  int64_t prefetch_size_mb_;
+  std::string lidar_ip_;
+  int64_t lidar_port_data_;
+  int64_t lidar_port_position_;
+  std::string dual_return_policy_;
+  std::string calibration_path_;
+  bool skip_broken_scans_;
+  double scan_cut_azimuth_;
+  bool emit_partial_scan_last_;
+  std::vector<std::string> sensor_names_;
+  double time_window_start_;
+  double time_window_end_;
+  bool enable_trajectory_time_window_;
 
   void process();
 
-  std::vector<points_provider::PointsProvider::Points> clouds;
+  // Scans kept until process() when not streaming, quantized to hold more of them in memory
+  std::vector<point_types::CompactScan> clouds;
+  // Sensor of each cloud in clouds
+  std::vector<size_t> indices_sensor_clouds_;
 
 private:
+  // Sensor to map transform of each sensor, indexed like sensor_names_
+  std::vector<transform_provider::transform_chain::TransformChain> transform_chains_;
+
+  // Summed over every scan handed out by the points provider
+  points_provider::scan_telemetry::ScanTelemetry telemetry_scans_;
+  size_t count_scans_{0U};
+  // Scans that aren't one intact revolution
+  size_t count_scans_broken_{0U};
+
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_ptr_basic_cloud_current_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_ptr_corner_cloud_current_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_ptr_surface_cloud_current_;
@@ -61,9 +93,17 @@ private:
   image_projection::ImageProjection::SharedPtr image_projection;
   feature_extraction::FeatureExtraction::SharedPtr feature_extraction;
 
-  PointCloud2::SharedPtr points_to_cloud(const Points & points_bad, const std::string & frame_id);
+  Occtree::Ptr occ_cloud_;
+  Occtree::Ptr occ_cloud_corner_;
+  Occtree::Ptr occ_cloud_surface_;
+
+  PointCloud2::SharedPtr points_to_cloud(
+    const PointColumns & points_bad, const std::string & frame_id);
 
-  void callback_cloud_surround_out(const Points & points_surround);
+  void callback_cloud_surround_out(ScanLease scan_surround);
+  void callback_cloud_surround_out_of_sensor(ScanLease scan_surround, size_t index_sensor);
+  void process_cloud(const PointColumns & cloud, size_t index_sensor);
+  void save_pcds();
   sensor_msgs::msg::Image createImageFromRangeMat(const cv::Mat & rangeMat);
   void clear_cloudInfo(utils::Utils::CloudInfo & cloudInfo);
 
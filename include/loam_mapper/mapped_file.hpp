@@ -0,0 +1,35 @@
+#ifndef LOAM_MAPPER__MAPPED_FILE_HPP_
+#define LOAM_MAPPER__MAPPED_FILE_HPP_
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+
+namespace loam_mapper::mapped_file
+{
+namespace fs = boost::filesystem;
+
+// Maps a whole file read-only. Throws std::runtime_error if it cannot be opened, is empty or
+// cannot be mapped.
+class MappedFile
+{
+public:
+  explicit MappedFile(const fs::path & path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  // Tells the kernel the whole file will be read soon, so it starts reading it ahead.
+  void advise_will_need() const;
+
+  [[nodiscard]] const char * data() const { return data_; }
+  [[nodiscard]] std::size_t size() const { return size_; }
+
+private:
+  const char * data_{nullptr};
+  std::size_t size_{0U};
+};
+}  // namespace loam_mapper::mapped_file
+
+#endif  // LOAM_MAPPER__MAPPED_FILE_HPP_
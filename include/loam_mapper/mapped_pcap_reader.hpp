@@ -0,0 +1,72 @@
+#ifndef LOAM_MAPPER__MAPPED_PCAP_READER_HPP_
+#define LOAM_MAPPER__MAPPED_PCAP_READER_HPP_
+
+#include "loam_mapper/mapped_file.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace loam_mapper::points_provider::mapped_pcap_reader
+{
+namespace fs = boost::filesystem;
+
+// Non-owning view of a single pcap record, pointing straight into the mapped file.
+struct PacketView
+{
+  const std::uint8_t * data{nullptr};
+  std::uint32_t length_captured{0U};
+  std::uint32_t length_original{0U};
+  std::uint32_t stamp_seconds{0U};
+  std::uint32_t stamp_microseconds{0U};
+  std::size_t offset_record{0U};  // offset of the record header within the file
+};
+
+// Walks the records of a classic libpcap file in place, without copying packet bytes.
+// The whole file is mapped read-only and the kernel is told we read it sequentially, so
+// readahead keeps the device busy while the parser consumes the previous pages.
+class MappedPcapReader
+{
+public:
+  explicit MappedPcapReader(const fs::path & path_pcap);
+
+  MappedPcapReader(const MappedPcapReader &) = delete;
+  MappedPcapReader & operator=(const MappedPcapReader &) = delete;
+
+  // Returns false once the end of the file (or a truncated trailing record) is reached.
+  bool get_next_packet(PacketView & packet);
+
+  // Reads the record starting at offset and advances offset past it, without touching the
+  // internal cursor, so that several threads can walk disjoint parts of the same mapping.
+  bool get_packet_at(std::size_t & offset, PacketView & packet) const;
+
+  // Returns the offset of the first record header at or after offset_hint, or size() if there
+  // is none. A candidate is only accepted if the records following it chain up plausibly.
+  [[nodiscard]] std::size_t find_record_boundary(std::size_t offset_hint) const;
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] std::size_t offset() const { return offset_; }
+
+  static constexpr std::size_t size_global_header = 24;
+  static constexpr std::size_t size_record_header = 16;
+
+private:
+  fs::path path_pcap_;
+  mapped_file::MappedFile file_;
+  const std::uint8_t * data_;
+  std::size_t size_;
+  std::size_t offset_;
+
+  bool is_byte_swapped_;
+  bool is_nanosecond_resolution_;
+  std::uint32_t snap_length_;
+  std::uint32_t stamp_seconds_first_;
+
+  [[nodiscard]] std::uint32_t read_u32(std::size_t offset) const;
+  [[nodiscard]] bool is_plausible_record_header(std::size_t offset) const;
+};
+}  // namespace loam_mapper::points_provider::mapped_pcap_reader
+
+#endif  // LOAM_MAPPER__MAPPED_PCAP_READER_HPP_
@@ -0,0 +1,75 @@
+#ifndef LOAM_MAPPER__PACKET_FILTER_HPP_
+#define LOAM_MAPPER__PACKET_FILTER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace loam_mapper::points_provider::packet_filter
+{
+// Classifies captured Ethernet frames as Velodyne data or position packets by looking only at
+// their IPv4/UDP headers, so unrelated traffic on a shared tap is dropped before it is parsed,
+// and foreign frames that happen to have the same length aren't misparsed.
+struct PacketFilter
+{
+  enum class Kind { Data, Position, Other };
+
+  std::uint16_t port_data{2368U};
+  std::uint16_t port_position{8308U};
+  // IPv4 source address in host byte order, 0 accepts packets from any sensor.
+  std::uint32_t address_source{0U};
+
+  static constexpr std::size_t size_data_packet = 1248;
+  static constexpr std::size_t size_position_packet = 554;
+
+  [[nodiscard]] Kind classify(const std::uint8_t * frame, std::size_t length_frame) const
+  {
+    if (length_frame != size_data_packet && length_frame != size_position_packet) {
+      return Kind::Other;
+    }
+    // Untagged Ethernet II, IPv4 without options and UDP, so the payload starts at byte 42.
+    constexpr std::size_t offset_ether_type = 12;
+    constexpr std::size_t offset_ip = 14;
+    constexpr std::size_t offset_ip_protocol = offset_ip + 9;
+    constexpr std::size_t offset_ip_source = offset_ip + 12;
+    constexpr std::size_t offset_udp_port_destination = offset_ip + 20 + 2;
+    constexpr std::uint8_t ip_protocol_udp = 17U;
+    if (
+      frame[offset_ether_type] != 0x08U || frame[offset_ether_type + 1] != 0x00U ||
+      frame[offset_ip] != 0x45U || frame[offset_ip_protocol] != ip_protocol_udp) {
+      return Kind::Other;
+    }
+    if (address_source != 0U && read_u32_big_endian(frame + offset_ip_source) != address_source) {
+      return Kind::Other;
+    }
+    const std::uint16_t port_destination = static_cast<std::uint16_t>(
+      (frame[offset_udp_port_destination] << 8U) | frame[offset_udp_port_destination + 1]);
+    if (length_frame == size_data_packet && port_destination == port_data) {
+      return Kind::Data;
+    }
+    if (length_frame == size_position_packet && port_destination == port_position) {
+      return Kind::Position;
+    }
+    return Kind::Other;
+  }
+
+  // Parses a dotted IPv4 address, an empty string means any source.
+  static std::uint32_t parse_address(const std::string & address);
+
+  bool operator==(const PacketFilter & other) const
+  {
+    return port_data == other.port_data && port_position == other.port_position &&
+           address_source == other.address_source;
+  }
+
+private:
+  static std::uint32_t read_u32_big_endian(const std::uint8_t * bytes)
+  {
+    return (static_cast<std::uint32_t>(bytes[0]) << 24U) |
+           (static_cast<std::uint32_t>(bytes[1]) << 16U) |
+           (static_cast<std::uint32_t>(bytes[2]) << 8U) | static_cast<std::uint32_t>(bytes[3]);
+  }
+};
+}  // namespace loam_mapper::points_provider::packet_filter
+
+#endif  // LOAM_MAPPER__PACKET_FILTER_HPP_
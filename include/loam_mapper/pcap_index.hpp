@@ -0,0 +1,75 @@
+#ifndef LOAM_MAPPER__PCAP_INDEX_HPP_
+#define LOAM_MAPPER__PCAP_INDEX_HPP_
+
+#include "loam_mapper/mapped_pcap_reader.hpp"
+#include "loam_mapper/packet_filter.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace loam_mapper::points_provider::pcap_index
+{
+namespace fs = boost::filesystem;
+
+struct IndexEntry
+{
+  enum class Type : std::uint8_t { Data, Position, PositionInvalid };
+
+  std::uint64_t offset_record{0U};
+  std::uint32_t stamp_pcap_seconds{0U};
+  std::uint32_t stamp_pcap_microseconds{0U};
+  // Top of the hour GPS timestamp of the packet
+  std::uint32_t microseconds_toh{0U};
+  // Hour the ToH timestamp refers to, 0 if no valid position packet was seen yet
+  std::uint32_t hours_since_epoch{0U};
+  // Azimuth of the first block, only set for data packets
+  std::uint16_t azimuth_multiplied_by_100_deg{0U};
+  Type type{Type::Data};
+  std::uint8_t reserved{0U};
+
+  [[nodiscard]] bool has_stamp() const { return hours_since_epoch != 0U; }
+  [[nodiscard]] std::uint64_t get_stamp_unix_nanoseconds() const
+  {
+    return (static_cast<std::uint64_t>(hours_since_epoch) * 3600000000ULL + microseconds_toh) *
+           1000ULL;
+  }
+} __attribute__((packed));
+
+// Sidecar index of a pcap file (stored next to it as <name>.pcap.idx), recording every Nth data
+// packet and every position packet, so decoding can start close to a requested GPS time.
+class PcapIndex
+{
+public:
+  // Loads the sidecar index of path_pcap if it matches the file and the packet filter,
+  // otherwise builds and saves it.
+  static PcapIndex load_or_build(
+    const fs::path & path_pcap,
+    const mapped_pcap_reader::MappedPcapReader & reader,
+    std::uint32_t stride_data_packets,
+    const packet_filter::PacketFilter & packet_filter);
+
+  static PcapIndex build(
+    const mapped_pcap_reader::MappedPcapReader & reader,
+    std::uint32_t stride_data_packets,
+    const packet_filter::PacketFilter & packet_filter);
+
+  void save(const fs::path & path_index) const;
+  static bool load(const fs::path & path_index, PcapIndex & index);
+
+  static fs::path get_path_index(const fs::path & path_pcap);
+
+  [[nodiscard]] const std::vector<IndexEntry> & get_entries() const { return entries_; }
+
+private:
+  std::uint32_t stride_data_packets_{0U};
+  std::uint64_t size_pcap_{0U};
+  std::int64_t time_last_write_pcap_{0};
+  packet_filter::PacketFilter packet_filter_;
+  std::vector<IndexEntry> entries_;
+};
+}  // namespace loam_mapper::points_provider::pcap_index
+
+#endif  // LOAM_MAPPER__PCAP_INDEX_HPP_
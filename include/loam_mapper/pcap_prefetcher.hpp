@@ -0,0 +1,59 @@
+#ifndef LOAM_MAPPER__PCAP_PREFETCHER_HPP_
+#define LOAM_MAPPER__PCAP_PREFETCHER_HPP_
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+
+namespace loam_mapper::points_provider::pcap_prefetcher
+{
+namespace fs = boost::filesystem;
+
+// Where the time went while reading a single capture
+struct FileIoStats
+{
+  fs::path path;
+  std::uint64_t count_bytes{0U};
+  // Blocked on the read ahead of this file
+  double milliseconds_prefetch_wait{0.0};
+  double milliseconds_open{0.0};
+  // Reading and decoding the packets, without the scan callbacks
+  double milliseconds_decode{0.0};
+  // Spent in the callbacks the scans of this file were handed to, e.g. the mapping pipeline
+  double milliseconds_callbacks{0.0};
+  // Page faults of the decoding thread which had to wait for the storage
+  std::int64_t count_major_page_faults{0};
+};
+
+// Reads the beginning of the upcoming capture on a background thread while the current one is
+// being decoded, so the page cache is warm when it is opened. This hides the cold start latency
+// of every file boundary, which is especially long on network mounted storage.
+class PcapPrefetcher
+{
+public:
+  // 0 disables prefetching.
+  explicit PcapPrefetcher(std::size_t size_bytes_prefetch);
+  ~PcapPrefetcher();
+
+  PcapPrefetcher(const PcapPrefetcher &) = delete;
+  PcapPrefetcher & operator=(const PcapPrefetcher &) = delete;
+
+  // Starts warming the first size_bytes_prefetch bytes of path_pcap, after waiting for the
+  // previous request.
+  void prefetch(const fs::path & path_pcap);
+
+  // Blocks until the read ahead of path_pcap is done, returns the milliseconds spent waiting.
+  double wait(const fs::path & path_pcap);
+
+private:
+  std::size_t size_bytes_prefetch_;
+  fs::path path_pending_;
+  std::future<void> future_pending_;
+
+  static void warm(const fs::path & path_pcap, std::size_t size_bytes);
+};
+}  // namespace loam_mapper::points_provider::pcap_prefetcher
+
+#endif  // LOAM_MAPPER__PCAP_PREFETCHER_HPP_
@@ -0,0 +1,97 @@
+#ifndef LOAM_MAPPER__PCAP_STREAM_READER_HPP_
+#define LOAM_MAPPER__PCAP_STREAM_READER_HPP_
+
+#include "loam_mapper/mapped_pcap_reader.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace loam_mapper::points_provider::pcap_stream_reader
+{
+namespace fs = boost::filesystem;
+
+// Sequentially reads classic pcap and pcapng captures, optionally gzip (.gz) or zstd (.zst)
+// compressed, without decompressing them to disk. Reading and decompression run on a
+// background thread which fills a small ring of chunks, so it overlaps with packet decoding.
+class PcapStreamReader
+{
+public:
+  explicit PcapStreamReader(const fs::path & path_capture);
+  ~PcapStreamReader();
+
+  PcapStreamReader(const PcapStreamReader &) = delete;
+  PcapStreamReader & operator=(const PcapStreamReader &) = delete;
+
+  // The packet data stays valid until the next call.
+  bool get_next_packet(mapped_pcap_reader::PacketView & packet);
+
+  // True for .pcap and .pcapng files, optionally with a .gz or .zst suffix.
+  static bool is_supported(const fs::path & path_capture);
+
+private:
+  enum class Compression { None, Gzip, Zstd };
+  enum class Format { Pcap, Pcapng };
+
+  struct Interface
+  {
+    std::uint16_t link_type;
+    std::uint32_t snap_length;
+    // Timestamp units per second
+    std::uint64_t units_per_second;
+  };
+
+  fs::path path_capture_;
+  Compression compression_;
+  Format format_;
+
+  // Producer side, runs on thread_decompression_
+  std::thread thread_decompression_;
+  std::mutex mutex_chunks_;
+  std::condition_variable cv_chunks_;
+  std::deque<std::vector<std::uint8_t>> chunks_filled_;
+  std::deque<std::vector<std::uint8_t>> chunks_free_;
+  bool is_producer_done_;
+  bool is_stopping_;
+  std::exception_ptr exception_producer_;
+
+  void run_decompression();
+  void read_uncompressed();
+  void read_gzip();
+  void read_zstd();
+  // Blocks until a free chunk is available, returns false if the reader is being destroyed.
+  bool acquire_chunk_free(std::vector<std::uint8_t> & chunk);
+  void push_chunk_filled(std::vector<std::uint8_t> && chunk);
+
+  // Consumer side
+  std::vector<std::uint8_t> chunk_current_;
+  std::size_t offset_chunk_current_;
+  // Holds records which straddle two chunks
+  std::vector<std::uint8_t> bytes_staging_;
+  std::size_t offset_stream_;
+
+  bool is_byte_swapped_;
+  bool is_nanosecond_resolution_;
+  std::vector<Interface> interfaces_;
+
+  bool pull_chunk();
+  // Returns a pointer to the next count bytes and consumes them, nullptr at the end of stream.
+  const std::uint8_t * read_bytes(std::size_t count);
+  [[nodiscard]] std::uint32_t to_u32(const std::uint8_t * bytes) const;
+  [[nodiscard]] std::uint16_t to_u16(const std::uint8_t * bytes) const;
+
+  void read_file_header();
+  bool get_next_packet_pcap(mapped_pcap_reader::PacketView & packet);
+  bool get_next_packet_pcapng(mapped_pcap_reader::PacketView & packet);
+  void read_interface_description(const std::uint8_t * body, std::size_t size_body);
+};
+}  // namespace loam_mapper::points_provider::pcap_stream_reader
+
+#endif  // LOAM_MAPPER__PCAP_STREAM_READER_HPP_
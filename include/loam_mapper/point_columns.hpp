@@ -0,0 +1,241 @@
+#ifndef LOAM_MAPPER__POINT_COLUMNS_HPP_
+#define LOAM_MAPPER__POINT_COLUMNS_HPP_
+
+#include "loam_mapper/point_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <vector>
+
+namespace loam_mapper::point_types
+{
+// Allocates on Alignment byte boundaries, so that columns can be read with aligned SIMD loads.
+template <typename T, std::size_t Alignment = 32>
+struct AlignedAllocator
+{
+  using value_type = T;
+  template <typename U>
+  struct rebind
+  {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() = default;
+  template <typename U>
+  explicit AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept
+  {
+  }
+
+  T * allocate(std::size_t count)
+  {
+    return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+  }
+  void deallocate(T * data, std::size_t) noexcept
+  {
+    ::operator delete(data, std::align_val_t{Alignment});
+  }
+
+  friend bool operator==(const AlignedAllocator &, const AlignedAllocator &) { return true; }
+  friend bool operator!=(const AlignedAllocator &, const AlignedAllocator &) { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Structure of arrays counterpart of PointXYZITRH. Every field is stored in its own column, so a
+// loop reading only some fields doesn't pull the others through the cache. The columns always
+// have the same size.
+class PointColumnsXYZITRH
+{
+public:
+  AlignedVector<float> x;
+  AlignedVector<float> y;
+  AlignedVector<float> z;
+  AlignedVector<std::uint32_t> intensity;
+  AlignedVector<std::uint64_t> stamp_unix_nanoseconds;
+  AlignedVector<std::uint32_t> ring;
+  AlignedVector<float> horizontal_angle;
+
+  [[nodiscard]] std::size_t size() const { return x.size(); }
+  [[nodiscard]] bool empty() const { return x.empty(); }
+  [[nodiscard]] std::size_t capacity() const { return x.capacity(); }
+
+  void clear()
+  {
+    x.clear();
+    y.clear();
+    z.clear();
+    intensity.clear();
+    stamp_unix_nanoseconds.clear();
+    ring.clear();
+    horizontal_angle.clear();
+  }
+
+  void reserve(std::size_t count_points)
+  {
+    x.reserve(count_points);
+    y.reserve(count_points);
+    z.reserve(count_points);
+    intensity.reserve(count_points);
+    stamp_unix_nanoseconds.reserve(count_points);
+    ring.reserve(count_points);
+    horizontal_angle.reserve(count_points);
+  }
+
+  void resize(std::size_t count_points)
+  {
+    x.resize(count_points);
+    y.resize(count_points);
+    z.resize(count_points);
+    intensity.resize(count_points);
+    stamp_unix_nanoseconds.resize(count_points);
+    ring.resize(count_points);
+    horizontal_angle.resize(count_points);
+  }
+
+  void push_back(const PointXYZITRH & point)
+  {
+    x.push_back(point.x);
+    y.push_back(point.y);
+    z.push_back(point.z);
+    intensity.push_back(point.intensity);
+    stamp_unix_nanoseconds.push_back(point.stamp_unix_nanoseconds);
+    ring.push_back(point.ring);
+    horizontal_angle.push_back(point.horizontal_angle);
+  }
+
+  // Appends the points of other after the points of this.
+  void append(const PointColumnsXYZITRH & other)
+  {
+    x.insert(x.end(), other.x.begin(), other.x.end());
+    y.insert(y.end(), other.y.begin(), other.y.end());
+    z.insert(z.end(), other.z.begin(), other.z.end());
+    intensity.insert(intensity.end(), other.intensity.begin(), other.intensity.end());
+    stamp_unix_nanoseconds.insert(
+      stamp_unix_nanoseconds.end(), other.stamp_unix_nanoseconds.begin(),
+      other.stamp_unix_nanoseconds.end());
+    ring.insert(ring.end(), other.ring.begin(), other.ring.end());
+    horizontal_angle.insert(
+      horizontal_angle.end(), other.horizontal_angle.begin(), other.horizontal_angle.end());
+  }
+
+  [[nodiscard]] PointXYZITRH get_point(std::size_t index) const
+  {
+    PointXYZITRH point;
+    point.x = x[index];
+    point.y = y[index];
+    point.z = z[index];
+    point.intensity = intensity[index];
+    point.stamp_unix_nanoseconds = stamp_unix_nanoseconds[index];
+    point.ring = ring[index];
+    point.horizontal_angle = horizontal_angle[index];
+    return point;
+  }
+
+  // Read only view of the points as PointXYZITRH, each one is assembled when it is accessed.
+  // For the ROS and PCL interfaces that expect an array of structs.
+  class View
+  {
+  public:
+    class Iterator
+    {
+    public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = PointXYZITRH;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = PointXYZITRH;
+
+      Iterator() = default;
+      Iterator(const PointColumnsXYZITRH * columns, std::size_t index)
+      : columns_{columns}, index_{index}
+      {
+      }
+
+      reference operator*() const { return columns_->get_point(index_); }
+      reference operator[](difference_type offset) const { return *(*this + offset); }
+
+      Iterator & operator++()
+      {
+        ++index_;
+        return *this;
+      }
+      Iterator operator++(int)
+      {
+        Iterator iterator = *this;
+        ++index_;
+        return iterator;
+      }
+      Iterator & operator--()
+      {
+        --index_;
+        return *this;
+      }
+      Iterator operator--(int)
+      {
+        Iterator iterator = *this;
+        --index_;
+        return iterator;
+      }
+      Iterator & operator+=(difference_type offset)
+      {
+        index_ = static_cast<std::size_t>(static_cast<difference_type>(index_) + offset);
+        return *this;
+      }
+      Iterator & operator-=(difference_type offset) { return *this += -offset; }
+      friend Iterator operator+(Iterator iterator, difference_type offset)
+      {
+        return iterator += offset;
+      }
+      friend Iterator operator+(difference_type offset, Iterator iterator)
+      {
+        return iterator += offset;
+      }
+      friend Iterator operator-(Iterator iterator, difference_type offset)
+      {
+        return iterator -= offset;
+      }
+      friend difference_type operator-(const Iterator & lhs, const Iterator & rhs)
+      {
+        return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+      }
+      friend bool operator==(const Iterator & lhs, const Iterator & rhs)
+      {
+        return lhs.index_ == rhs.index_;
+      }
+      friend bool operator!=(const Iterator & lhs, const Iterator & rhs)
+      {
+        return lhs.index_ != rhs.index_;
+      }
+      friend bool operator<(const Iterator & lhs, const Iterator & rhs)
+      {
+        return lhs.index_ < rhs.index_;
+      }
+      friend bool operator>(const Iterator & lhs, const Iterator & rhs) { return rhs < lhs; }
+      friend bool operator<=(const Iterator & lhs, const Iterator & rhs) { return !(rhs < lhs); }
+      friend bool operator>=(const Iterator & lhs, const Iterator & rhs) { return !(lhs < rhs); }
+
+    private:
+      const PointColumnsXYZITRH * columns_{nullptr};
+      std::size_t index_{0U};
+    };
+
+    explicit View(const PointColumnsXYZITRH & columns) : columns_{&columns} {}
+
+    [[nodiscard]] std::size_t size() const { return columns_->size(); }
+    [[nodiscard]] bool empty() const { return columns_->empty(); }
+    PointXYZITRH operator[](std::size_t index) const { return columns_->get_point(index); }
+    [[nodiscard]] Iterator begin() const { return Iterator(columns_, 0U); }
+    [[nodiscard]] Iterator end() const { return Iterator(columns_, columns_->size()); }
+
+  private:
+    const PointColumnsXYZITRH * columns_;
+  };
+
+  [[nodiscard]] View get_view() const { return View(*this); }
+};
+}  // namespace loam_mapper::point_types
+
+#endif  // LOAM_MAPPER__POINT_COLUMNS_HPP_
@@ -3,6 +3,7 @@
 
 #include <boost/math/special_functions/relative_difference.hpp>
 
+#include <cstdint>
 #include <limits>
 #include <numeric>
 
@@ -29,15 +30,13 @@ struct PointXYZIT
   float y{0.0F};
   float z{0.0F};
   uint32_t intensity{0U};
-  uint32_t stamp_unix_seconds{0U};
-  uint32_t stamp_nanoseconds{0U};
+  uint64_t stamp_unix_nanoseconds{0U};
   friend bool operator==(const PointXYZIT & p1, const PointXYZIT & p2)
   {
     using boost::math::epsilon_difference;
     return epsilon_difference(p1.x, p2.x) == 0.0F && epsilon_difference(p1.y, p2.y) == 0.0F &&
            epsilon_difference(p1.z, p2.z) == 0.0F && p1.intensity == p2.intensity &&
-           p1.stamp_unix_seconds == p2.stamp_unix_seconds &&
-           p1.stamp_nanoseconds == p2.stamp_nanoseconds;
+           p1.stamp_unix_nanoseconds == p2.stamp_unix_nanoseconds;
   }
 } __attribute__((packed));
 
@@ -47,8 +46,7 @@ struct PointXYZITRH
   float y{0.0F};
   float z{0.0F};
   uint32_t intensity{0U};
-  uint32_t stamp_unix_seconds{0U};
-  uint32_t stamp_nanoseconds{0U};
+  uint64_t stamp_unix_nanoseconds{0U};
   uint32_t ring{0U};
   float horizontal_angle{0.0F};
   friend bool operator==(const PointXYZITRH & p1, const PointXYZITRH & p2)
@@ -56,8 +54,7 @@ struct PointXYZITRH
     using boost::math::epsilon_difference;
     return epsilon_difference(p1.x, p2.x) == 0.0F && epsilon_difference(p1.y, p2.y) == 0.0F &&
            epsilon_difference(p1.z, p2.z) == 0.0F && p1.intensity == p2.intensity &&
-           p1.stamp_unix_seconds == p2.stamp_unix_seconds &&
-           p1.stamp_nanoseconds == p2.stamp_nanoseconds && p1.ring == p2.ring;
+           p1.stamp_unix_nanoseconds == p2.stamp_unix_nanoseconds && p1.ring == p2.ring;
   }
 } __attribute__((packed));
 }  // namespace loam_mapper::point_types
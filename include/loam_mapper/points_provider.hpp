@@ -10,6 +10,10 @@
 #include "point_types.hpp"
 #include "date.h"
 #include "continuous_packet_parser.hpp"
+#include "packet_filter.hpp"
+#include "pcap_prefetcher.hpp"
+#include "scan_buffer_pool.hpp"
+#include "velodyne_calibration.hpp"
 
 namespace loam_mapper::points_provider
 {
@@ -19,25 +23,117 @@ class PointsProvider : public virtual PointsProviderBase
 public:
   using SharedPtr = std::shared_ptr<PointsProvider>;
   using ConstSharedPtr = const SharedPtr;
+  // Scans are handed to the callbacks by ownership, their buffers are recycled once released.
+  using ScanLease = scan_buffer_pool::ScanLease;
 
   explicit PointsProvider( std::string  path_folder_pcaps);
 
   void process() override;
 
+  // Accepts .pcap and .pcapng captures, optionally gzip (.gz) or zstd (.zst) compressed.
   void process_pcaps_into_clouds(
-    std::function<void(const Points &)> & callback_cloud_surround_out,
+    const std::function<void(ScanLease)> & callback_cloud_surround_out,
     size_t index_start,
     size_t count);
+
+  // Splits the pcaps into byte ranges at record boundaries and decodes them on count_threads
+  // workers (0 means one per hardware thread). Scans are passed to the callback on the calling
+  // thread, identical and in the same order as process_pcaps_into_clouds would produce them.
+  // Falls back to process_pcaps_into_clouds if any capture is compressed or pcapng.
+  void process_pcaps_into_clouds_parallel(
+    const std::function<void(ScanLease)> & callback_cloud_surround_out,
+    size_t index_start,
+    size_t count,
+    size_t count_threads);
+
+  // Decodes only the part of the pcaps around [stamp_start, stamp_end] (GPS time in unix
+  // nanoseconds). The sidecar index of each pcap is built on first use, then decoding starts at
+  // the indexed data packet preceding stamp_start and stops at the one following stamp_end.
+  // Compressed and pcapng captures aren't indexed, they are decoded from their beginning.
+  void process_pcaps_into_clouds_in_time_range(
+    const std::function<void(ScanLease)> & callback_cloud_surround_out,
+    size_t index_start,
+    size_t count,
+    uint64_t stamp_unix_nanoseconds_start,
+    uint64_t stamp_unix_nanoseconds_end);
+
+  // Decodes the packets of several sensors sharing the captures, selected by their packet
+  // filters. Every sensor has its own parser running on its own thread. The scans are passed to
+  // the callback on the calling thread with the index of their sensor, in the order of their
+  // first point's stamp.
+  void process_pcaps_into_clouds_multi_sensor(
+    const std::function<void(ScanLease, size_t index_sensor)> & callback_cloud_surround_out,
+    size_t index_start,
+    size_t count,
+    const std::vector<packet_filter::PacketFilter> & packet_filters);
+
   std::string info() override;
 
-  void process_pcap_into_clouds(
+  [[nodiscard]] size_t get_count_pcaps() const { return paths_pcaps_.size(); }
+
+  pcap_prefetcher::FileIoStats process_pcap_into_clouds(
     const fs::path & path_pcap,
-    const std::function<void(const Points &)>& callback_cloud_surround_out,
+    const std::function<void(ScanLease)> & callback_cloud_surround_out,
     continuous_packet_parser::ContinuousPacketParser& parser);
 
+  // Restricts decoding to points with a GPS time within [start, end] (unix nanoseconds).
+  // Reading stops as soon as a packet past the end of the window is seen.
+  void set_time_window(
+    uint64_t stamp_unix_nanoseconds_start, uint64_t stamp_unix_nanoseconds_end);
+
+  // Every stride_data_packets_index'th data packet is recorded in the sidecar index.
+  uint32_t stride_data_packets_index{100U};
+
+  // Selects the sensor's packets by UDP port and source address, everything else is dropped.
+  packet_filter::PacketFilter packet_filter;
+
+  // Returns kept from dual return captures.
+  continuous_packet_parser::ContinuousPacketParser::DualReturnPolicy dual_return_policy{
+    continuous_packet_parser::ContinuousPacketParser::DualReturnPolicy::Both};
+
+  // Per laser calibration of the sensor, the nominal laser angles of its model are used if empty.
+  velodyne_calibration::Calibration calibration;
+
+  // Scans start at the first firing at or past this azimuth, in [0, 360) degrees.
+  float angle_deg_cut{90.0F};
+
+  // Whether the points after the last cut are handed out as a partial scan once decoding ends.
+  bool is_emitting_partial_scan_last{false};
+
+  // How much of the next pcap is read ahead while the current one is decoded, 0 disables it.
+  size_t size_bytes_prefetch{64UL * 1024UL * 1024UL};
+
+  // One entry per pcap decoded by process_pcaps_into_clouds, in decoding order.
+  [[nodiscard]] const std::vector<pcap_prefetcher::FileIoStats> & get_io_stats() const
+  {
+    return io_stats_;
+  }
+
 private:
   fs::path path_folder_pcaps_;
 
   std::vector<fs::path> paths_pcaps_;
+
+  bool has_time_window_{false};
+  uint64_t stamp_unix_nanoseconds_window_start_{0U};
+  uint64_t stamp_unix_nanoseconds_window_end_{0U};
+
+  std::vector<pcap_prefetcher::FileIoStats> io_stats_;
+
+  [[nodiscard]] continuous_packet_parser::ContinuousPacketParser create_parser() const;
+
+  void process_pcaps_serially(
+    const std::function<void(ScanLease)> & callback_cloud_surround_out,
+    size_t index_start,
+    size_t count,
+    continuous_packet_parser::ContinuousPacketParser & parser);
+
+  // Calls read_pcap_into_parsers for each pcap in order, prefetching the next one, until
+  // is_done returns true.
+  void read_pcaps_serially(
+    size_t index_start,
+    size_t count,
+    const std::function<pcap_prefetcher::FileIoStats(const fs::path &)> & read_pcap_into_parsers,
+    const std::function<bool()> & is_done);
 };
 }  // namespace loam_mapper::points_provider
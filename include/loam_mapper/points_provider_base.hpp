@@ -9,6 +9,7 @@
 #include <vector>
 #include <string>
 #include "point_types.hpp"
+#include "point_columns.hpp"
 
 namespace loam_mapper::points_provider
 {
@@ -17,6 +18,8 @@ class PointsProviderBase
 public:
   using Point = point_types::PointXYZITRH;
   using Points = std::vector<Point>;
+  // How scans are stored, column wise
+  using PointColumns = point_types::PointColumnsXYZITRH;
   virtual void process() = 0;
   //  virtual bool get_next_cloud(std::vector<Points> & cloud_out) = 0;
   virtual std::string info() = 0;
@@ -0,0 +1,48 @@
+#ifndef LOAM_MAPPER__POSE_INTERPOLATION_HPP_
+#define LOAM_MAPPER__POSE_INTERPOLATION_HPP_
+
+#include "loam_mapper/point_columns.hpp"
+#include "loam_mapper/pose_lookup.hpp"
+#include "loam_mapper/pose_table.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace loam_mapper::transform_provider::pose_interpolation
+{
+// Positions and orientations at a batch of stamps, column wise
+struct PoseColumns
+{
+  point_types::AlignedVector<double> x;
+  point_types::AlignedVector<double> y;
+  point_types::AlignedVector<double> z;
+  point_types::AlignedVector<double> orientation_x;
+  point_types::AlignedVector<double> orientation_y;
+  point_types::AlignedVector<double> orientation_z;
+  point_types::AlignedVector<double> orientation_w;
+
+  [[nodiscard]] std::size_t size() const { return x.size(); }
+
+  void resize(std::size_t count_poses)
+  {
+    x.resize(count_poses);
+    y.resize(count_poses);
+    z.resize(count_poses);
+    orientation_x.resize(count_poses);
+    orientation_y.resize(count_poses);
+    orientation_z.resize(count_poses);
+    orientation_w.resize(count_poses);
+  }
+};
+
+// Writes the poses at count stamps to poses_interpolated, resized to count. Positions are blended
+// linearly and orientations with SLERP between the two poses around each stamp. The stamps are
+// split into chunks interpolated in parallel, each searching sequentially from its own cursor.
+// Stamps outside of the trajectory get its first or last pose. lookup must be built over poses.
+void interpolate(
+  const PoseTable & poses, const pose_lookup::PoseLookup & lookup,
+  const std::uint64_t * stamps_unix_nanoseconds, std::size_t count,
+  PoseColumns & poses_interpolated);
+}  // namespace loam_mapper::transform_provider::pose_interpolation
+
+#endif  // LOAM_MAPPER__POSE_INTERPOLATION_HPP_
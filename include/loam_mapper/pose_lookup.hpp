@@ -0,0 +1,65 @@
+#ifndef LOAM_MAPPER__POSE_LOOKUP_HPP_
+#define LOAM_MAPPER__POSE_LOOKUP_HPP_
+
+#include "loam_mapper/pose_table.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace loam_mapper::transform_provider::pose_lookup
+{
+// The two poses around a stamp and how far the stamp is from the first to the second, in [0, 1]
+struct Bracket
+{
+  std::size_t index_before{0U};
+  std::size_t index_after{0U};
+  double ratio{0.0};
+};
+
+// Finds poses by stamp in O(1). The time span of the trajectory is cut into buckets about a pose
+// period long, each knowing its first pose, so a stamp is a division and a step or two away from
+// its pose. The lookup doesn't change after it is built and can be shared by any number of
+// threads, each passing its own Cursor.
+class PoseLookup
+{
+public:
+  enum class Mode {
+    // For stamps that mostly go forward, like the points of a scan: the search walks on from the
+    // pose the cursor is at, and only goes through the buckets if the stamp is behind it or more
+    // than a few poses ahead.
+    Sequential,
+    // Every search goes through the buckets.
+    Random
+  };
+
+  // Where the last stamp of a caller was found
+  struct Cursor
+  {
+    Mode mode{Mode::Sequential};
+    std::size_t index{0U};
+  };
+
+  PoseLookup() = default;
+  // The stamps of poses should be sorted, poses must outlive the lookup.
+  explicit PoseLookup(const PoseTable & poses);
+
+  // Index of the first pose at or after the stamp, the count of poses if there is none
+  std::size_t find_index_at_or_after(std::uint64_t stamp_unix_nanoseconds, Cursor & cursor) const;
+
+  // Stamps before the first pose or after the last one get that pose. Throws std::length_error
+  // if there are no poses.
+  Bracket find_bracket(std::uint64_t stamp_unix_nanoseconds, Cursor & cursor) const;
+
+private:
+  const std::uint64_t * stamps_{nullptr};
+  std::size_t count_stamps_{0U};
+  std::uint64_t nanoseconds_bucket_{1U};
+  // Index of the first pose at or after the start of each bucket
+  std::vector<std::uint32_t> indices_first_pose_;
+
+  [[nodiscard]] std::size_t find_index_in_buckets(std::uint64_t stamp_unix_nanoseconds) const;
+};
+}  // namespace loam_mapper::transform_provider::pose_lookup
+
+#endif  // LOAM_MAPPER__POSE_LOOKUP_HPP_
@@ -0,0 +1,117 @@
+#ifndef LOAM_MAPPER__POSE_TABLE_HPP_
+#define LOAM_MAPPER__POSE_TABLE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace loam_mapper::transform_provider
+{
+// Poses of a trajectory sorted by stamp, stored column wise. The columns either belong to the
+// table or point into a mapped trajectory cache, which the table then keeps mapped.
+class PoseTable
+{
+public:
+  enum Column : std::size_t {
+    column_x,  // in meters from the map origin
+    column_y,
+    column_z,
+    column_orientation_x,
+    column_orientation_y,
+    column_orientation_z,
+    column_orientation_w,
+    // Diagonal of the covariance of the pose
+    column_variance_x,
+    column_variance_y,
+    column_variance_z,
+    column_variance_roll,
+    column_variance_pitch,
+    column_variance_yaw,
+    count_columns
+  };
+  using Values = std::array<double, count_columns>;
+
+  PoseTable() = default;
+
+  // count_poses zeroed poses, filled with set()
+  explicit PoseTable(std::size_t count_poses)
+  : stamps_unix_nanoseconds_owned_(count_poses), size_{count_poses}
+  {
+    stamps_unix_nanoseconds_ = stamps_unix_nanoseconds_owned_.data();
+    for (std::size_t i = 0; i < count_columns; ++i) {
+      columns_owned_[i].resize(count_poses);
+      columns_[i] = columns_owned_[i].data();
+    }
+  }
+
+  // Columns of count_poses elements laid out back to back from data, the stamps first, then
+  // the values in Column order. storage keeps them valid for the life of the table.
+  PoseTable(std::size_t count_poses, const void * data, std::shared_ptr<const void> storage)
+  : storage_{std::move(storage)}, size_{count_poses}
+  {
+    stamps_unix_nanoseconds_ = static_cast<const std::uint64_t *>(data);
+    const auto * values = reinterpret_cast<const double *>(stamps_unix_nanoseconds_ + size_);
+    for (std::size_t i = 0; i < count_columns; ++i) {
+      columns_[i] = values + i * size_;
+    }
+  }
+
+  // The column pointers would point into the copied from table.
+  PoseTable(const PoseTable &) = delete;
+  PoseTable & operator=(const PoseTable &) = delete;
+  PoseTable(PoseTable &&) noexcept = default;
+  PoseTable & operator=(PoseTable &&) noexcept = default;
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  [[nodiscard]] bool is_mapped() const { return storage_ != nullptr; }
+
+  [[nodiscard]] const std::uint64_t * get_stamps_unix_nanoseconds() const
+  {
+    return stamps_unix_nanoseconds_;
+  }
+  [[nodiscard]] const double * get_column(Column column) const { return columns_[column]; }
+
+  [[nodiscard]] Values get_values(std::size_t index) const
+  {
+    Values values;
+    for (std::size_t i = 0; i < count_columns; ++i) {
+      values[i] = columns_[i][index];
+    }
+    return values;
+  }
+
+  // Only for tables that own their columns, different indices can be set from different threads.
+  void set(std::size_t index, std::uint64_t stamp_unix_nanoseconds, const Values & values)
+  {
+    stamps_unix_nanoseconds_owned_[index] = stamp_unix_nanoseconds;
+    for (std::size_t i = 0; i < count_columns; ++i) {
+      columns_owned_[i][index] = values[i];
+    }
+  }
+
+  // Drops the poses from count_poses on, only for tables that own their columns.
+  void truncate(std::size_t count_poses)
+  {
+    // Shrinking keeps the buffers, so the column pointers stay valid.
+    stamps_unix_nanoseconds_owned_.resize(count_poses);
+    for (auto & column : columns_owned_) {
+      column.resize(count_poses);
+    }
+    size_ = count_poses;
+  }
+
+private:
+  std::vector<std::uint64_t> stamps_unix_nanoseconds_owned_;
+  std::array<std::vector<double>, count_columns> columns_owned_;
+  std::shared_ptr<const void> storage_;
+
+  std::size_t size_{0U};
+  const std::uint64_t * stamps_unix_nanoseconds_{nullptr};
+  std::array<const double *, count_columns> columns_{};
+};
+}  // namespace loam_mapper::transform_provider
+
+#endif  // LOAM_MAPPER__POSE_TABLE_HPP_
@@ -0,0 +1,85 @@
+#ifndef LOAM_MAPPER__SCAN_BUFFER_POOL_HPP_
+#define LOAM_MAPPER__SCAN_BUFFER_POOL_HPP_
+
+#include "loam_mapper/point_columns.hpp"
+#include "loam_mapper/scan_telemetry.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace loam_mapper::points_provider::scan_buffer_pool
+{
+// Scans are stored column wise, get_view() gives access to them as PointXYZITRH.
+using Points = point_types::PointColumnsXYZITRH;
+
+class ScanBufferPool;
+
+// Move only handle to a scan whose buffer is borrowed from a ScanBufferPool. The buffer goes back
+// to the pool, keeping its capacity, when the lease is destroyed. The scan's telemetry travels
+// with it.
+class ScanLease
+{
+public:
+  ScanLease() = default;
+  ScanLease(Points && points, std::shared_ptr<ScanBufferPool> pool);
+  ~ScanLease();
+
+  ScanLease(ScanLease && other) noexcept = default;
+  ScanLease & operator=(ScanLease && other) noexcept;
+  ScanLease(const ScanLease &) = delete;
+  ScanLease & operator=(const ScanLease &) = delete;
+
+  [[nodiscard]] const Points & get_points() const { return points_; }
+  Points & get_points() { return points_; }
+  const Points & operator*() const { return points_; }
+  const Points * operator->() const { return &points_; }
+
+  [[nodiscard]] const scan_telemetry::ScanTelemetry & get_telemetry() const { return telemetry_; }
+  scan_telemetry::ScanTelemetry & get_telemetry() { return telemetry_; }
+
+  // Takes the points out of the pool, their buffer won't be recycled.
+  Points release();
+
+private:
+  Points points_;
+  std::shared_ptr<ScanBufferPool> pool_;
+  scan_telemetry::ScanTelemetry telemetry_;
+
+  void give_back();
+};
+
+// Recycles scan buffers so that assembling scans doesn't allocate once enough buffers are in
+// circulation. Leases may be released on any thread and may outlive the parser that made them.
+class ScanBufferPool : public std::enable_shared_from_this<ScanBufferPool>
+{
+public:
+  // Every buffer is allocated with room for count_points_reserved points.
+  static std::shared_ptr<ScanBufferPool> create(std::size_t count_points_reserved);
+
+  ScanBufferPool(const ScanBufferPool &) = delete;
+  ScanBufferPool & operator=(const ScanBufferPool &) = delete;
+
+  // Hands out an empty buffer, a new one is only allocated if none is free.
+  ScanLease acquire();
+
+  // Buffers handed out from now on have room for at least count_points_reserved points.
+  void reserve(std::size_t count_points_reserved);
+  [[nodiscard]] std::size_t get_count_buffers_allocated() const;
+
+private:
+  friend class ScanLease;
+
+  explicit ScanBufferPool(std::size_t count_points_reserved);
+
+  mutable std::mutex mutex_;
+  std::size_t count_points_reserved_;
+  std::vector<Points> buffers_free_;
+  std::size_t count_buffers_allocated_;
+
+  void give_back(Points && points);
+};
+}  // namespace loam_mapper::points_provider::scan_buffer_pool
+
+#endif  // LOAM_MAPPER__SCAN_BUFFER_POOL_HPP_
@@ -0,0 +1,70 @@
+#ifndef LOAM_MAPPER__SCAN_TELEMETRY_HPP_
+#define LOAM_MAPPER__SCAN_TELEMETRY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace loam_mapper::points_provider::scan_telemetry
+{
+// Integrity counters of a scan, collected by the parser from the packets the scan was assembled
+// from. Events are counted for the scan of the packet they are detected in.
+struct ScanTelemetry
+{
+  // A scan is cut at the first firing past the cut azimuth, so a complete revolution spans 360
+  // degrees give or take the advance between two firings and the azimuth jitter of the blocks.
+  static constexpr float angle_deg_span_tolerance = 2.0F;
+
+  // Time of the firing the scan starts with, the cut one or else the first one decoded
+  std::uint64_t stamp_unix_nanoseconds_start{0U};
+  // Time of the cut firing that starts the next scan, or the last firing of a partial scan
+  std::uint64_t stamp_unix_nanoseconds_end{0U};
+
+  std::size_t count_data_packets{0U};
+  // Estimated from the ToH gaps that are longer than the packet period
+  std::size_t count_data_packets_dropped{0U};
+  // Packets whose azimuth advance doesn't match their ToH advance at the previous rotation speed
+  std::size_t count_azimuth_jumps{0U};
+  // ToH timestamps that went back, taken as the start of the next hour
+  std::size_t count_toh_rollovers{0U};
+  // Position packets whose GPRMC receiver status isn't active
+  std::size_t count_position_packets_inactive{0U};
+  // Azimuth covered by the packets of the scan
+  float angle_deg_span{0.0F};
+
+  // The first and the last scan of a capture are short, a missed cut makes a long one.
+  [[nodiscard]] bool is_short() const
+  {
+    return angle_deg_span < 360.0F - angle_deg_span_tolerance;
+  }
+  [[nodiscard]] bool is_long() const
+  {
+    return angle_deg_span > 360.0F + angle_deg_span_tolerance;
+  }
+  // One full revolution without dropped packets or azimuth jumps
+  [[nodiscard]] bool is_intact() const
+  {
+    return count_data_packets_dropped == 0U && count_azimuth_jumps == 0U && !is_short() &&
+           !is_long();
+  }
+
+  // Adds the counters of the packets of other, which follow this scan's, e.g. when a scan is
+  // stitched from two parts.
+  void merge(const ScanTelemetry & other)
+  {
+    if (stamp_unix_nanoseconds_start == 0U) {
+      stamp_unix_nanoseconds_start = other.stamp_unix_nanoseconds_start;
+    }
+    if (other.stamp_unix_nanoseconds_end != 0U) {
+      stamp_unix_nanoseconds_end = other.stamp_unix_nanoseconds_end;
+    }
+    count_data_packets += other.count_data_packets;
+    count_data_packets_dropped += other.count_data_packets_dropped;
+    count_azimuth_jumps += other.count_azimuth_jumps;
+    count_toh_rollovers += other.count_toh_rollovers;
+    count_position_packets_inactive += other.count_position_packets_inactive;
+    angle_deg_span += other.angle_deg_span;
+  }
+};
+}  // namespace loam_mapper::points_provider::scan_telemetry
+
+#endif  // LOAM_MAPPER__SCAN_TELEMETRY_HPP_
@@ -0,0 +1,107 @@
+#ifndef LOAM_MAPPER__SENSOR_DEMULTIPLEXER_HPP_
+#define LOAM_MAPPER__SENSOR_DEMULTIPLEXER_HPP_
+
+#include "loam_mapper/continuous_packet_parser.hpp"
+#include "loam_mapper/packet_filter.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace loam_mapper::points_provider::sensor_demultiplexer
+{
+// Splits the packets of several sensors sharing a capture by their packet filters and decodes
+// the packets of every sensor with its own parser on its own worker thread. The scans of all
+// sensors are passed to the callback on the thread pushing the packets, ordered by the stamp of
+// their first point. A scan is only emitted once no sensor can queue an earlier one. If a sensor
+// holds the others back for too long, its pending packets are decoded right away, or its
+// partial scan is handed out if its packets stopped mid scan.
+class SensorDemultiplexer
+{
+public:
+  using ScanLease = continuous_packet_parser::ContinuousPacketParser::ScanLease;
+  using CallbackScan = std::function<void(ScanLease, std::size_t index_sensor)>;
+
+  SensorDemultiplexer(
+    const std::vector<continuous_packet_parser::ContinuousPacketParser> & parsers,
+    const std::vector<packet_filter::PacketFilter> & packet_filters,
+    CallbackScan callback_scan);
+  // Stops the workers without emitting the remaining scans.
+  ~SensorDemultiplexer();
+
+  SensorDemultiplexer(const SensorDemultiplexer &) = delete;
+  SensorDemultiplexer & operator=(const SensorDemultiplexer &) = delete;
+
+  // Copies the packet into the batch of the first sensor whose filter accepts it, packets of no
+  // sensor are dropped. Returns false once every sensor is past its time window.
+  bool push_packet(const std::uint8_t * data, std::size_t length);
+
+  // Decodes the packets pushed so far and emits all remaining scans.
+  void finish();
+
+private:
+  struct PacketBatch
+  {
+    std::vector<std::uint8_t> bytes;
+    std::vector<std::uint32_t> lengths;
+  };
+
+  struct ScanStamped
+  {
+    std::uint64_t stamp_unix_nanoseconds;
+    ScanLease scan;
+  };
+
+  struct Sensor
+  {
+    continuous_packet_parser::ContinuousPacketParser parser;
+    packet_filter::PacketFilter packet_filter;
+    // Only touched by the pushing thread
+    PacketBatch batch_pending;
+    // Guarded by mutex_
+    std::deque<PacketBatch> batches_filled;
+    std::deque<PacketBatch> batches_free;
+    std::deque<ScanStamped> scans;
+    // A batch was taken by the worker and isn't decoded yet
+    bool is_decoding{false};
+    // First stamp of the points decoded since the last queued scan, if any
+    bool has_partial_scan{false};
+    std::uint64_t stamp_unix_nanoseconds_partial_first{0U};
+    // Asks the worker to queue its partial scan
+    bool is_partial_scan_requested{false};
+    bool is_done{false};
+    std::atomic<bool> is_past_time_window{false};
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Sensor>> sensors_;
+  CallbackScan callback_scan_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool is_input_closed_;
+  bool is_stopping_;
+  std::exception_ptr exception_;
+
+  void run_sensor(Sensor & sensor);
+  // Queues the points decoded since the last scan as a scan of their own.
+  static void hand_out_partial_scan(
+    Sensor & sensor, const std::function<void(ScanLease)> & callback_collect);
+  void flush_batch(Sensor & sensor);
+  // Emits scans as long as no sensor can queue an earlier one, all of them once every worker is
+  // done.
+  void emit_ready_scans();
+  void stop();
+};
+}  // namespace loam_mapper::points_provider::sensor_demultiplexer
+
+#endif  // LOAM_MAPPER__SENSOR_DEMULTIPLEXER_HPP_
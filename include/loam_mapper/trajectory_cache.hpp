@@ -0,0 +1,46 @@
+#ifndef LOAM_MAPPER__TRAJECTORY_CACHE_HPP_
+#define LOAM_MAPPER__TRAJECTORY_CACHE_HPP_
+
+#include "loam_mapper/pose_table.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+
+namespace loam_mapper::transform_provider::trajectory_cache
+{
+namespace fs = boost::filesystem;
+
+// What a cache was built from: the trajectory export and the map origin of its positions
+struct CacheKey
+{
+  std::uint64_t size_source{0U};
+  std::int64_t time_last_write_source{0};
+  // Of the size and the first and last 64 KiB of the export, so that making the key takes the
+  // same time for any length while a re-export within the same second is still told apart.
+  std::uint64_t hash_source{0U};
+  double origin_x{0.0};
+  double origin_y{0.0};
+  double origin_z{0.0};
+
+  static CacheKey make(
+    const fs::path & path_source, double origin_x, double origin_y, double origin_z);
+
+  bool operator==(const CacheKey & other) const;
+  bool operator!=(const CacheKey & other) const { return !(*this == other); }
+};
+
+// Binary copy of the pose table of a trajectory, stored next to it as <name>.cache. Loading maps
+// the file and points the columns of the table into it, so it takes the same time for any length.
+class TrajectoryCache
+{
+public:
+  // Returns false if there is no usable cache at path_cache for key.
+  static bool load(const fs::path & path_cache, const CacheKey & key, PoseTable & poses);
+  static void save(const fs::path & path_cache, const CacheKey & key, const PoseTable & poses);
+
+  static fs::path get_path_cache(const fs::path & path_source);
+};
+}  // namespace loam_mapper::transform_provider::trajectory_cache
+
+#endif  // LOAM_MAPPER__TRAJECTORY_CACHE_HPP_
@@ -0,0 +1,37 @@
+#ifndef LOAM_MAPPER__TRANSFORM_CHAIN_HPP_
+#define LOAM_MAPPER__TRANSFORM_CHAIN_HPP_
+
+#include "loam_mapper/point_columns.hpp"
+#include "loam_mapper/pose_interpolation.hpp"
+
+#include <array>
+
+namespace loam_mapper::transform_provider::transform_chain
+{
+// Sensor to map transform of one sensor. The static part, the IMU to LiDAR extrinsic followed by
+// the optional NED to ENU flip, is composed into one rotation on construction, so a point only
+// costs composing it with its pose and one matrix vector product.
+class TransformChain
+{
+public:
+  // Extrinsic angles in degrees, rotated about z, y, x in that order
+  TransformChain(double roll_deg, double pitch_deg, double yaw_deg, bool is_converting_ned2enu);
+
+  // Writes the x, y, z of cloud in the map frame to cloud_trans, which must be as large. Every
+  // point is placed with the pose of the same index in poses, e.g. interpolated at its stamp.
+  void apply(
+    const point_types::PointColumnsXYZITRH & cloud, const pose_interpolation::PoseColumns & poses,
+    point_types::PointColumnsXYZITRH & cloud_trans) const;
+
+  // Row major
+  [[nodiscard]] const std::array<double, 9> & get_rotation_static() const
+  {
+    return rotation_static_;
+  }
+
+private:
+  std::array<double, 9> rotation_static_{};
+};
+}  // namespace loam_mapper::transform_provider::transform_chain
+
+#endif  // LOAM_MAPPER__TRANSFORM_CHAIN_HPP_
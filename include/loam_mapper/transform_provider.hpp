@@ -2,7 +2,9 @@
 #ifndef BUILD_TRANSFORM_PROVIDER_HPP
 #define BUILD_TRANSFORM_PROVIDER_HPP
 
-#include "csv.hpp"
+#include "loam_mapper/pose_interpolation.hpp"
+#include "loam_mapper/pose_lookup.hpp"
+#include "loam_mapper/pose_table.hpp"
 
 #include <geometry_msgs/msg/pose_with_covariance.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
@@ -22,6 +24,9 @@ public:
 
   explicit TransformProvider(const std::string & path_file_ascii_output);
 
+  // Maps the poses from the trajectory cache next to the export if it was built from the same
+  // export and origin, otherwise parses the export and saves the cache. The const member functions
+  // can be called from any number of threads afterwards.
   void process(double origin_x, double origin_y, double origin_z);
 
   struct Pose
@@ -31,18 +36,36 @@ public:
     geometry_msgs::msg::PoseWithCovariance pose_with_covariance;
   };
 
-  std::vector<Pose> poses_;
-
+  // First pose at or after the stamp, the last pose for stamps past it.
   Pose get_pose_at(
     uint32_t stamp_unix_seconds,
-    uint32_t stamp_nanoseconds);
+    uint32_t stamp_nanoseconds) const;
+
+  Pose get_pose_at(uint64_t stamp_unix_nanoseconds) const;
+
+  // Poses at count stamps, blended from the two poses around each: the position linearly, the
+  // orientation with SLERP. Stamps outside of the trajectory get its first or last pose. Chunks of
+  // the stamps are interpolated in parallel and the blending is vectorized over the stamps.
+  void get_poses_interpolated_at(
+    const uint64_t * stamps_unix_nanoseconds, size_t count,
+    pose_interpolation::PoseColumns & poses) const;
+
+  [[nodiscard]] Pose get_pose(size_t index) const;
+  [[nodiscard]] const PoseTable & get_poses() const { return poses_; }
+  [[nodiscard]] const pose_lookup::PoseLookup & get_lookup() const { return lookup_; }
+
+  // Time span covered by poses_, in unix nanoseconds.
+  [[nodiscard]] uint64_t get_stamp_unix_nanoseconds_first() const;
+  [[nodiscard]] uint64_t get_stamp_unix_nanoseconds_last() const;
 
 private:
   fs::path path_file_ascii_output_;
-  std::string header_line_string;
-  std::string time_string;
-  int data_line_number;
-  std::string mission_date;
+  PoseTable poses_;
+  pose_lookup::PoseLookup lookup_;
+
+  // Loads the poses of an Applanix ASCII export in one pass over the mapped file, its data lines
+  // are parsed on all hardware threads.
+  void parse_ascii_output(double origin_x, double origin_y, double origin_z);
 };
 }  // loam_mapper::transform_provider
 
@@ -0,0 +1,56 @@
+#ifndef LOAM_MAPPER__VELODYNE_CALIBRATION_HPP_
+#define LOAM_MAPPER__VELODYNE_CALIBRATION_HPP_
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+#include <istream>
+#include <map>
+#include <vector>
+
+namespace loam_mapper::points_provider::velodyne_calibration
+{
+namespace fs = boost::filesystem;
+
+// Intrinsic corrections of one laser
+struct LaserCorrection
+{
+  float angle_deg_vertical{0.0F};
+  // Added to the azimuth of the laser's firings
+  float angle_deg_azimuth_offset{0.0F};
+  // Added to the measured distance
+  float meters_distance_offset{0.0F};
+  // Position of the laser's origin, along the rotation axis and perpendicular to its beam
+  float meters_vertical_offset{0.0F};
+  float meters_horizontal_offset{0.0F};
+};
+
+// Per laser calibration of a sensor unit, indexed by laser id (the channel order of the data
+// blocks).
+class Calibration
+{
+public:
+  // Reads a VeloView db.xml, or a .yaml calibration of the velodyne_pointcloud ROS driver.
+  static Calibration load(const fs::path & path);
+
+  // db.xml angles are in degrees and distances in centimeters.
+  static Calibration parse_db_xml(std::istream & stream);
+  // YAML angles are in radians and distances in meters.
+  static Calibration parse_yaml(std::istream & stream);
+
+  [[nodiscard]] bool empty() const { return lasers_.empty(); }
+  [[nodiscard]] std::size_t get_count_lasers() const { return lasers_.size(); }
+  [[nodiscard]] const LaserCorrection & get_laser(std::size_t laser) const
+  {
+    return lasers_.at(laser);
+  }
+
+private:
+  std::vector<LaserCorrection> lasers_;
+
+  // Every laser id below the highest one has to be present.
+  static Calibration from_lasers(const std::map<std::size_t, LaserCorrection> & lasers);
+};
+}  // namespace loam_mapper::points_provider::velodyne_calibration
+
+#endif  // LOAM_MAPPER__VELODYNE_CALIBRATION_HPP_
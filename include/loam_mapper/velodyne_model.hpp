@@ -0,0 +1,217 @@
+#ifndef LOAM_MAPPER__VELODYNE_MODEL_HPP_
+#define LOAM_MAPPER__VELODYNE_MODEL_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace loam_mapper::points_provider::velodyne_model
+{
+enum class VelodyneModel { HDL32E, VLP16orPuckLITE, PuckHiRes, VLP32CorVLP32MR, Velarray, VLS128 };
+
+constexpr std::size_t count_blocks_data_packet = 12;
+constexpr std::size_t count_channels_block = 32;
+constexpr std::size_t count_points_data_packet = count_blocks_data_packet * count_channels_block;
+
+// Static description of a sensor model: the laser geometry, which laser each channel of a data
+// block holds and when it fires. One specialization per supported model, the decoder is
+// instantiated for each of them.
+//
+// Consecutive blocks of a bank cycle hold different lasers of the same firing sequence, e.g. the
+// 4 blocks of a VLS-128 sequence carry lasers 0-31, 32-63, 64-95 and 96-127.
+template <VelodyneModel Model>
+struct ModelTraits;
+
+template <>
+struct ModelTraits<VelodyneModel::VLP16orPuckLITE>
+{
+  static constexpr const char * name = "VLP16orPuckLITE";
+  static constexpr std::size_t count_lasers = 16;
+  static constexpr std::size_t count_banks = 1;
+  static constexpr std::uint32_t millimeters_per_distance_unit = 2;
+  // In single return mode, at 5 Hz, the slowest rotation
+  static constexpr std::size_t count_data_packets_per_second = 754;
+  static constexpr std::size_t count_revolutions_per_second_min = 5;
+  static constexpr bool has_built_in_geometry = true;
+
+  static constexpr std::array<float, count_lasers> angles_deg_vertical{
+    -15.0F, 1.0F, -13.0F, 3.0F, -11.0F, 5.0F, -9.0F, 7.0F,
+    -7.0F,  9.0F, -5.0F,  11.0F, -3.0F, 13.0F, -1.0F, 15.0F};
+  static constexpr std::array<float, count_lasers> angles_deg_azimuth_offset{};
+
+  // A block holds two firing sequences of the 16 lasers
+  static constexpr std::size_t get_laser(std::size_t, std::size_t ind_channel)
+  {
+    return ind_channel % 16;
+  }
+
+  // Every channel fires on its own, 2.304 us apart, the second sequence starts after 55.296 us.
+  static constexpr std::size_t count_firing_groups = 32;
+  static constexpr std::size_t get_firing_group(std::size_t, std::size_t ind_channel)
+  {
+    return ind_channel;
+  }
+  // Since the first firing of the block
+  static constexpr std::int64_t get_nanoseconds_firing_group(std::size_t ind_firing_group)
+  {
+    return static_cast<std::int64_t>(ind_firing_group / 16) * 55296 +
+           static_cast<std::int64_t>(ind_firing_group % 16) * 2304;
+  }
+  // First firing of the block since the ToH of the packet
+  static constexpr std::int64_t get_nanoseconds_block(std::size_t ind_block)
+  {
+    return static_cast<std::int64_t>(ind_block) * 110592;
+  }
+};
+
+template <>
+struct ModelTraits<VelodyneModel::HDL32E>
+{
+  static constexpr const char * name = "HDL32E";
+  static constexpr std::size_t count_lasers = 32;
+  static constexpr std::size_t count_banks = 1;
+  static constexpr std::uint32_t millimeters_per_distance_unit = 2;
+  static constexpr std::size_t count_data_packets_per_second = 1808;
+  static constexpr std::size_t count_revolutions_per_second_min = 5;
+  static constexpr bool has_built_in_geometry = true;
+
+  static constexpr std::array<float, count_lasers> angles_deg_vertical{
+    -30.67F, -9.33F, -29.33F, -8.0F,  -28.0F, -6.67F, -26.67F, -5.33F,
+    -25.33F, -4.0F,  -24.0F,  -2.67F, -22.67F, -1.33F, -21.33F, 0.0F,
+    -20.0F,  1.33F,  -18.67F, 2.67F,  -17.33F, 4.0F,  -16.0F,  5.33F,
+    -14.67F, 6.67F,  -13.33F, 8.0F,   -12.0F,  9.33F, -10.67F, 10.67F};
+  static constexpr std::array<float, count_lasers> angles_deg_azimuth_offset{};
+
+  static constexpr std::size_t get_laser(std::size_t, std::size_t ind_channel)
+  {
+    return ind_channel;
+  }
+
+  // The lasers fire one after the other 1.152 us apart, a sequence lasts 46.08 us.
+  static constexpr std::size_t count_firing_groups = 32;
+  static constexpr std::size_t get_firing_group(std::size_t, std::size_t ind_channel)
+  {
+    return ind_channel;
+  }
+  static constexpr std::int64_t get_nanoseconds_firing_group(std::size_t ind_firing_group)
+  {
+    return static_cast<std::int64_t>(ind_firing_group) * 1152;
+  }
+  static constexpr std::int64_t get_nanoseconds_block(std::size_t ind_block)
+  {
+    return static_cast<std::int64_t>(ind_block) * 46080;
+  }
+};
+
+template <>
+struct ModelTraits<VelodyneModel::VLP32CorVLP32MR>
+{
+  static constexpr const char * name = "VLP32CorVLP32MR";
+  static constexpr std::size_t count_lasers = 32;
+  static constexpr std::size_t count_banks = 1;
+  static constexpr std::uint32_t millimeters_per_distance_unit = 4;
+  static constexpr std::size_t count_data_packets_per_second = 1507;
+  static constexpr std::size_t count_revolutions_per_second_min = 5;
+  static constexpr bool has_built_in_geometry = true;
+
+  static constexpr std::array<float, count_lasers> angles_deg_vertical{
+    -25.0F,  -1.0F,   -1.667F, -15.639F, -11.31F, 0.0F,    -0.667F, -8.843F,
+    -7.254F, 0.333F,  -0.333F, -6.148F,  -5.333F, 1.333F,  0.667F,  -4.0F,
+    -4.667F, 1.667F,  1.0F,    -3.667F,  -3.333F, 3.333F,  2.333F,  -2.667F,
+    -3.0F,   7.0F,    4.667F,  -2.333F,  -2.0F,   15.0F,   10.333F, -1.333F};
+  static constexpr std::array<float, count_lasers> angles_deg_azimuth_offset{
+    1.4F, -4.2F, 1.4F, -1.4F, 1.4F, -1.4F, 4.2F, -1.4F, 1.4F, -4.2F, 1.4F,
+    -1.4F, 4.2F, -1.4F, 4.2F, -1.4F, 1.4F, -4.2F, 1.4F, -4.2F, 4.2F, -1.4F,
+    1.4F, -1.4F, 1.4F, -1.4F, 1.4F, -4.2F, 4.2F, -1.4F, 1.4F, -1.4F};
+
+  static constexpr std::size_t get_laser(std::size_t, std::size_t ind_channel)
+  {
+    return ind_channel;
+  }
+
+  // The lasers fire in pairs 2.304 us apart, a sequence lasts 55.296 us.
+  static constexpr std::size_t count_firing_groups = 16;
+  static constexpr std::size_t get_firing_group(std::size_t, std::size_t ind_channel)
+  {
+    return ind_channel / 2;
+  }
+  static constexpr std::int64_t get_nanoseconds_firing_group(std::size_t ind_firing_group)
+  {
+    return static_cast<std::int64_t>(ind_firing_group) * 2304;
+  }
+  static constexpr std::int64_t get_nanoseconds_block(std::size_t ind_block)
+  {
+    return static_cast<std::int64_t>(ind_block) * 55296;
+  }
+};
+
+// The laser angles of the VLS-128 differ between units, they have to come from its calibration.
+template <>
+struct ModelTraits<VelodyneModel::VLS128>
+{
+  static constexpr const char * name = "VLS128";
+  static constexpr std::size_t count_lasers = 128;
+  static constexpr std::size_t count_banks = 4;
+  static constexpr std::uint32_t millimeters_per_distance_unit = 4;
+  static constexpr std::size_t count_data_packets_per_second = 6254;
+  static constexpr std::size_t count_revolutions_per_second_min = 5;
+  static constexpr bool has_built_in_geometry = false;
+
+  static constexpr std::array<float, count_lasers> angles_deg_vertical{};
+  static constexpr std::array<float, count_lasers> angles_deg_azimuth_offset{};
+
+  static constexpr std::size_t get_laser(std::size_t ind_bank, std::size_t ind_channel)
+  {
+    return ind_bank * count_channels_block + ind_channel;
+  }
+
+  // 8 lasers fire at once, 2.665 us apart, with a maintenance slot after the first 8 groups. A
+  // sequence lasts 53.3 us and the ToH is taken 8.7 us into the first sequence of the packet.
+  static constexpr std::size_t count_firing_groups = 17;
+  static constexpr std::size_t get_firing_group(std::size_t ind_bank, std::size_t ind_channel)
+  {
+    const std::size_t laser = get_laser(ind_bank, ind_channel);
+    return laser / 8 + laser / 64;
+  }
+  static constexpr std::int64_t get_nanoseconds_firing_group(std::size_t ind_firing_group)
+  {
+    return static_cast<std::int64_t>(ind_firing_group) * 2665;
+  }
+  static constexpr std::int64_t get_nanoseconds_block(std::size_t ind_block)
+  {
+    return static_cast<std::int64_t>(ind_block / count_banks) * 53300 - 8700;
+  }
+};
+
+// Time of every firing of a data packet since its ToH, by block and channel.
+using TableNanosecondsFiring =
+  std::array<std::array<std::int64_t, count_channels_block>, count_blocks_data_packet>;
+
+// In dual return mode each firing is reported in CountReturns consecutive blocks, which share
+// its time.
+template <typename Traits, std::size_t CountReturns = 1>
+constexpr TableNanosecondsFiring make_table_nanoseconds_firing()
+{
+  TableNanosecondsFiring table{};
+  for (std::size_t ind_block = 0; ind_block < count_blocks_data_packet; ++ind_block) {
+    const std::size_t ind_block_firing = ind_block / CountReturns;
+    const std::size_t ind_bank = ind_block_firing % Traits::count_banks;
+    for (std::size_t ind_channel = 0; ind_channel < count_channels_block; ++ind_channel) {
+      table[ind_block][ind_channel] =
+        Traits::get_nanoseconds_block(ind_block_firing) +
+        Traits::get_nanoseconds_firing_group(Traits::get_firing_group(ind_bank, ind_channel));
+    }
+  }
+  return table;
+}
+
+// The packet rate grows with the number of returns, the rotation speed doesn't.
+template <typename Traits, std::size_t CountReturns = 1>
+constexpr std::size_t get_count_points_scan_max()
+{
+  return CountReturns * Traits::count_data_packets_per_second * count_points_data_packet /
+         Traits::count_revolutions_per_second_min;
+}
+}  // namespace loam_mapper::points_provider::velodyne_model
+
+#endif  // LOAM_MAPPER__VELODYNE_MODEL_HPP_
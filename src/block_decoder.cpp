@@ -0,0 +1,310 @@
+#include "loam_mapper/block_decoder.hpp"
+
+#include "loam_mapper/utils.hpp"
+
+// Bit identical results across implementations require every product and sum to be rounded on
+// its own, so the compiler must not fuse them into FMAs. CMake compiles this file with
+// -ffp-contract=off.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace loam_mapper::points_provider::block_decoder
+{
+namespace
+{
+// Azimuths are reported in hundredths of a degree
+constexpr std::size_t count_azimuths = 36000;
+
+struct TableSinCosAzimuth
+{
+  std::array<float, count_azimuths> sin;
+  std::array<float, count_azimuths> cos;
+};
+
+TableSinCosAzimuth build_table_sin_cos_azimuth()
+{
+  TableSinCosAzimuth table;
+  for (std::size_t i = 0; i < count_azimuths; ++i) {
+    const double angle_rad = utils::Utils::deg_to_rad(static_cast<double>(i) / 100.0);
+    table.sin.at(i) = static_cast<float>(std::sin(angle_rad));
+    table.cos.at(i) = static_cast<float>(std::cos(angle_rad));
+  }
+  return table;
+}
+
+const TableSinCosAzimuth table_sin_cos_azimuth = build_table_sin_cos_azimuth();
+
+// Block level terms shared by all implementations
+struct BlockTerms
+{
+  float angle_deg_azimuth;
+  float sin_azimuth;
+  float cos_azimuth;
+};
+
+BlockTerms get_block_terms(std::uint16_t azimuth_multiplied_by_100_deg)
+{
+  std::size_t ind_azimuth = azimuth_multiplied_by_100_deg;
+  if (ind_azimuth >= count_azimuths) {
+    ind_azimuth %= count_azimuths;
+  }
+  return BlockTerms{
+    static_cast<float>(azimuth_multiplied_by_100_deg) / 100.0f,
+    table_sin_cos_azimuth.sin[ind_azimuth], table_sin_cos_azimuth.cos[ind_azimuth]};
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) void decode_block_avx2(
+  const std::uint8_t * data_points,
+  std::uint16_t azimuth_multiplied_by_100_deg,
+  const ChannelTable & channel_table,
+  const FiringOffsets & firing_offsets,
+  DecodedBlock & decoded_block)
+{
+  const BlockTerms terms = get_block_terms(azimuth_multiplied_by_100_deg);
+  const __m256 angle_deg_azimuth_block = _mm256_set1_ps(terms.angle_deg_azimuth);
+  const __m256 sin_azimuth_block = _mm256_set1_ps(terms.sin_azimuth);
+  const __m256 cos_azimuth_block = _mm256_set1_ps(terms.cos_azimuth);
+  const __m256 angle_deg_full_turn = _mm256_set1_ps(360.0f);
+  const __m256 millimeters_per_meter = _mm256_set1_ps(1000.0f);
+  const __m256i mask_distance = _mm256_set1_epi32(0xFFFF);
+  const __m256i millimeters_per_distance_unit =
+    _mm256_set1_epi32(static_cast<int>(channel_table.millimeters_per_distance_unit));
+  const __m256i distance_below_min =
+    _mm256_set1_epi32(static_cast<int>(channel_table.distance_min) - 1);
+  const __m256i distance_above_max =
+    _mm256_set1_epi32(static_cast<int>(channel_table.distance_max) + 1);
+  // Byte offsets of 8 consecutive data points, each gather reads 1 byte past the last one.
+  const __m256i offsets_data_points = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+
+  std::uint32_t mask_valid = 0U;
+  for (std::size_t i = 0; i < count_channels_block; i += 8) {
+    const __m256i raw = _mm256_i32gather_epi32(
+      reinterpret_cast<const int *>(data_points + i * size_data_point), offsets_data_points, 1);
+    const __m256i distance = _mm256_and_si256(raw, mask_distance);
+
+    __m256 angle_deg_azimuth =
+      _mm256_add_ps(angle_deg_azimuth_block, _mm256_load_ps(firing_offsets.angle_deg + i));
+    const __m256 is_past_full_turn =
+      _mm256_cmp_ps(angle_deg_azimuth, angle_deg_full_turn, _CMP_GE_OQ);
+    angle_deg_azimuth = _mm256_sub_ps(
+      angle_deg_azimuth, _mm256_and_ps(is_past_full_turn, angle_deg_full_turn));
+    _mm256_store_ps(decoded_block.angle_deg_azimuth + i, angle_deg_azimuth);
+
+    const __m256i is_valid = _mm256_and_si256(
+      _mm256_cmpgt_epi32(distance, distance_below_min),
+      _mm256_cmpgt_epi32(distance_above_max, distance));
+    mask_valid |= static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(is_valid)))
+                  << i;
+
+    const __m256 dist_m = _mm256_div_ps(
+      _mm256_cvtepi32_ps(_mm256_mullo_epi32(distance, millimeters_per_distance_unit)),
+      millimeters_per_meter);
+    const __m256 dist_xy = _mm256_add_ps(
+      _mm256_mul_ps(dist_m, _mm256_load_ps(channel_table.cos_vertical + i)),
+      _mm256_load_ps(channel_table.offset_xy + i));
+    const __m256 offset_horizontal = _mm256_load_ps(channel_table.offset_horizontal + i);
+    const __m256 cos_firing_offset = _mm256_load_ps(firing_offsets.cos + i);
+    const __m256 sin_firing_offset = _mm256_load_ps(firing_offsets.sin + i);
+    const __m256 sin_azimuth = _mm256_add_ps(
+      _mm256_mul_ps(sin_azimuth_block, cos_firing_offset),
+      _mm256_mul_ps(cos_azimuth_block, sin_firing_offset));
+    const __m256 cos_azimuth = _mm256_sub_ps(
+      _mm256_mul_ps(cos_azimuth_block, cos_firing_offset),
+      _mm256_mul_ps(sin_azimuth_block, sin_firing_offset));
+
+    _mm256_store_ps(
+      decoded_block.x + i, _mm256_sub_ps(
+                             _mm256_mul_ps(dist_xy, sin_azimuth),
+                             _mm256_mul_ps(offset_horizontal, cos_azimuth)));
+    _mm256_store_ps(
+      decoded_block.y + i, _mm256_add_ps(
+                             _mm256_mul_ps(dist_xy, cos_azimuth),
+                             _mm256_mul_ps(offset_horizontal, sin_azimuth)));
+    _mm256_store_ps(
+      decoded_block.z + i, _mm256_add_ps(
+                             _mm256_mul_ps(dist_m, _mm256_load_ps(channel_table.sin_vertical + i)),
+                             _mm256_load_ps(channel_table.offset_z + i)));
+  }
+  decoded_block.mask_valid = mask_valid;
+}
+#endif
+
+#if defined(__aarch64__)
+void decode_block_neon(
+  const std::uint8_t * data_points,
+  std::uint16_t azimuth_multiplied_by_100_deg,
+  const ChannelTable & channel_table,
+  const FiringOffsets & firing_offsets,
+  DecodedBlock & decoded_block)
+{
+  const BlockTerms terms = get_block_terms(azimuth_multiplied_by_100_deg);
+  const float32x4_t angle_deg_azimuth_block = vdupq_n_f32(terms.angle_deg_azimuth);
+  const float32x4_t sin_azimuth_block = vdupq_n_f32(terms.sin_azimuth);
+  const float32x4_t cos_azimuth_block = vdupq_n_f32(terms.cos_azimuth);
+  const float32x4_t angle_deg_full_turn = vdupq_n_f32(360.0f);
+  const float32x4_t millimeters_per_meter = vdupq_n_f32(1000.0f);
+  const uint32x4_t distance_min = vdupq_n_u32(channel_table.distance_min);
+  const uint32x4_t distance_max = vdupq_n_u32(channel_table.distance_max);
+  const std::uint32_t bits_lanes[4] = {1U, 2U, 4U, 8U};
+  const uint32x4_t bit_of_lane = vld1q_u32(bits_lanes);
+
+  std::uint32_t mask_valid = 0U;
+  for (std::size_t ind_group = 0; ind_group < count_channels_block; ind_group += 16) {
+    // De-interleaves 16 data points into distance low bytes, high bytes and reflectivities.
+    const uint8x16x3_t raw = vld3q_u8(data_points + ind_group * size_data_point);
+    const uint16x8_t distances_low = vorrq_u16(
+      vmovl_u8(vget_low_u8(raw.val[0])), vshlq_n_u16(vmovl_u8(vget_low_u8(raw.val[1])), 8));
+    const uint16x8_t distances_high =
+      vorrq_u16(vmovl_high_u8(raw.val[0]), vshlq_n_u16(vmovl_high_u8(raw.val[1]), 8));
+    const uint32x4_t distances[4] = {
+      vmovl_u16(vget_low_u16(distances_low)), vmovl_high_u16(distances_low),
+      vmovl_u16(vget_low_u16(distances_high)), vmovl_high_u16(distances_high)};
+
+    for (std::size_t ind_quad = 0; ind_quad < 4; ++ind_quad) {
+      const std::size_t i = ind_group + ind_quad * 4;
+      const uint32x4_t distance = distances[ind_quad];
+
+      float32x4_t angle_deg_azimuth =
+        vaddq_f32(angle_deg_azimuth_block, vld1q_f32(firing_offsets.angle_deg + i));
+      const uint32x4_t is_past_full_turn = vcgeq_f32(angle_deg_azimuth, angle_deg_full_turn);
+      angle_deg_azimuth = vsubq_f32(
+        angle_deg_azimuth, vreinterpretq_f32_u32(vandq_u32(
+                             is_past_full_turn, vreinterpretq_u32_f32(angle_deg_full_turn))));
+      vst1q_f32(decoded_block.angle_deg_azimuth + i, angle_deg_azimuth);
+
+      const uint32x4_t is_valid = vandq_u32(
+        vcgeq_u32(distance, distance_min), vcleq_u32(distance, distance_max));
+      mask_valid |= vaddvq_u32(vandq_u32(is_valid, bit_of_lane)) << i;
+
+      const float32x4_t dist_m = vdivq_f32(
+        vcvtq_f32_u32(vmulq_n_u32(distance, channel_table.millimeters_per_distance_unit)),
+        millimeters_per_meter);
+      const float32x4_t dist_xy = vaddq_f32(
+        vmulq_f32(dist_m, vld1q_f32(channel_table.cos_vertical + i)),
+        vld1q_f32(channel_table.offset_xy + i));
+      const float32x4_t offset_horizontal = vld1q_f32(channel_table.offset_horizontal + i);
+      const float32x4_t cos_firing_offset = vld1q_f32(firing_offsets.cos + i);
+      const float32x4_t sin_firing_offset = vld1q_f32(firing_offsets.sin + i);
+      const float32x4_t sin_azimuth = vaddq_f32(
+        vmulq_f32(sin_azimuth_block, cos_firing_offset),
+        vmulq_f32(cos_azimuth_block, sin_firing_offset));
+      const float32x4_t cos_azimuth = vsubq_f32(
+        vmulq_f32(cos_azimuth_block, cos_firing_offset),
+        vmulq_f32(sin_azimuth_block, sin_firing_offset));
+
+      vst1q_f32(
+        decoded_block.x + i,
+        vsubq_f32(vmulq_f32(dist_xy, sin_azimuth), vmulq_f32(offset_horizontal, cos_azimuth)));
+      vst1q_f32(
+        decoded_block.y + i,
+        vaddq_f32(vmulq_f32(dist_xy, cos_azimuth), vmulq_f32(offset_horizontal, sin_azimuth)));
+      vst1q_f32(
+        decoded_block.z + i,
+        vaddq_f32(
+          vmulq_f32(dist_m, vld1q_f32(channel_table.sin_vertical + i)),
+          vld1q_f32(channel_table.offset_z + i)));
+    }
+  }
+  decoded_block.mask_valid = mask_valid;
+}
+#endif
+}  // namespace
+
+void decode_block_scalar(
+  const std::uint8_t * data_points,
+  std::uint16_t azimuth_multiplied_by_100_deg,
+  const ChannelTable & channel_table,
+  const FiringOffsets & firing_offsets,
+  DecodedBlock & decoded_block)
+{
+  const BlockTerms terms = get_block_terms(azimuth_multiplied_by_100_deg);
+  std::uint32_t mask_valid = 0U;
+  for (std::size_t i = 0; i < count_channels_block; ++i) {
+    const std::uint8_t * data_point = data_points + i * size_data_point;
+    const std::uint32_t distance =
+      static_cast<std::uint32_t>(data_point[0]) | (static_cast<std::uint32_t>(data_point[1]) << 8U);
+
+    float angle_deg_azimuth = terms.angle_deg_azimuth + firing_offsets.angle_deg[i];
+    if (angle_deg_azimuth >= 360.0f) {
+      angle_deg_azimuth -= 360.0f;
+    }
+    decoded_block.angle_deg_azimuth[i] = angle_deg_azimuth;
+
+    if (distance >= channel_table.distance_min && distance <= channel_table.distance_max) {
+      mask_valid |= 1U << i;
+    }
+
+    // sin(a + b) and cos(a + b) of the block azimuth a and the firing offset b
+    const float sin_azimuth = terms.sin_azimuth * firing_offsets.cos[i] +
+                              terms.cos_azimuth * firing_offsets.sin[i];
+    const float cos_azimuth = terms.cos_azimuth * firing_offsets.cos[i] -
+                              terms.sin_azimuth * firing_offsets.sin[i];
+
+    const float dist_m =
+      static_cast<float>(distance * channel_table.millimeters_per_distance_unit) / 1000.0f;
+    const float dist_xy = dist_m * channel_table.cos_vertical[i] + channel_table.offset_xy[i];
+    const float offset_horizontal = channel_table.offset_horizontal[i];
+    decoded_block.x[i] = dist_xy * sin_azimuth - offset_horizontal * cos_azimuth;
+    decoded_block.y[i] = dist_xy * cos_azimuth + offset_horizontal * sin_azimuth;
+    decoded_block.z[i] = dist_m * channel_table.sin_vertical[i] + channel_table.offset_z[i];
+  }
+  decoded_block.mask_valid = mask_valid;
+}
+
+Isa detect_isa()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("avx2")) {
+    return Isa::Avx2;
+  }
+#elif defined(__aarch64__)
+  return Isa::Neon;
+#endif
+  return Isa::Scalar;
+}
+
+DecodeBlockFunction get_decode_block(Isa isa)
+{
+  switch (isa) {
+    case Isa::Scalar:
+      return &decode_block_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    case Isa::Avx2:
+      return &decode_block_avx2;
+#endif
+#if defined(__aarch64__)
+    case Isa::Neon:
+      return &decode_block_neon;
+#endif
+    default:
+      throw std::invalid_argument(
+        std::string("block decoder isn't available on this platform: ") + get_name(isa));
+  }
+}
+
+const char * get_name(Isa isa)
+{
+  switch (isa) {
+    case Isa::Scalar:
+      return "Scalar";
+    case Isa::Avx2:
+      return "AVX2";
+    case Isa::Neon:
+      return "NEON";
+  }
+  return "Unknown";
+}
+}  // namespace loam_mapper::points_provider::block_decoder
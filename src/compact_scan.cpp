@@ -0,0 +1,122 @@
+#include "loam_mapper/compact_scan.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace loam_mapper::point_types
+{
+namespace
+{
+constexpr float steps_per_meter = 1.0F / CompactScan::meters_per_step;
+
+// The loops below are branch free over contiguous columns, so the compiler vectorizes them.
+void quantize_coordinates(const float * meters, std::int16_t * steps, std::size_t count)
+{
+  constexpr float step_min = std::numeric_limits<std::int16_t>::min();
+  constexpr float step_max = std::numeric_limits<std::int16_t>::max();
+  for (std::size_t i = 0; i < count; ++i) {
+    const float step = meters[i] * steps_per_meter;
+    // Rounds half away from zero, out of range values saturate.
+    const float step_rounded = step + (step < 0.0F ? -0.5F : 0.5F);
+    steps[i] = static_cast<std::int16_t>(std::clamp(step_rounded, step_min, step_max));
+  }
+}
+
+void dequantize_coordinates(const std::int16_t * steps, float * meters, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; ++i) {
+    meters[i] = static_cast<float>(steps[i]) * CompactScan::meters_per_step;
+  }
+}
+
+// Earliest and latest stamps of a scan with points
+std::pair<std::uint64_t, std::uint64_t> get_stamps_minmax(const PointColumnsXYZITRH & points)
+{
+  const auto stamps_minmax = std::minmax_element(
+    points.stamp_unix_nanoseconds.cbegin(), points.stamp_unix_nanoseconds.cend());
+  return {*stamps_minmax.first, *stamps_minmax.second};
+}
+}  // namespace
+
+bool CompactScan::is_encodable(const PointColumnsXYZITRH & points)
+{
+  if (points.empty()) {
+    return true;
+  }
+  const auto stamps_minmax = get_stamps_minmax(points);
+  return stamps_minmax.second - stamps_minmax.first <= std::numeric_limits<std::uint32_t>::max();
+}
+
+CompactScan CompactScan::encode(const PointColumnsXYZITRH & points)
+{
+  const std::size_t count = points.size();
+  CompactScan scan;
+  if (count == 0) {
+    return scan;
+  }
+
+  const auto stamps_minmax = get_stamps_minmax(points);
+  if (stamps_minmax.second - stamps_minmax.first > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::range_error(
+      "scan was expected to last less than 4.29 s but it lasts " +
+      std::to_string(stamps_minmax.second - stamps_minmax.first) + " ns");
+  }
+  scan.stamp_unix_nanoseconds_start_ = stamps_minmax.first;
+
+  scan.x_.resize(count);
+  scan.y_.resize(count);
+  scan.z_.resize(count);
+  scan.intensity_.resize(count);
+  scan.ring_.resize(count);
+  scan.azimuth_multiplied_by_100_deg_.resize(count);
+  scan.nanoseconds_since_start_.resize(count);
+
+  quantize_coordinates(points.x.data(), scan.x_.data(), count);
+  quantize_coordinates(points.y.data(), scan.y_.data(), count);
+  quantize_coordinates(points.z.data(), scan.z_.data(), count);
+  for (std::size_t i = 0; i < count; ++i) {
+    scan.intensity_[i] = static_cast<std::uint8_t>(points.intensity[i]);
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    scan.ring_[i] = static_cast<std::uint8_t>(points.ring[i]);
+  }
+  // Azimuths are in [0, 360)
+  for (std::size_t i = 0; i < count; ++i) {
+    scan.azimuth_multiplied_by_100_deg_[i] =
+      static_cast<std::uint16_t>(points.horizontal_angle[i] * 100.0F + 0.5F);
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    scan.nanoseconds_since_start_[i] = static_cast<std::uint32_t>(
+      points.stamp_unix_nanoseconds[i] - scan.stamp_unix_nanoseconds_start_);
+  }
+  return scan;
+}
+
+void CompactScan::decode(PointColumnsXYZITRH & points) const
+{
+  const std::size_t count = size();
+  points.resize(count);
+
+  dequantize_coordinates(x_.data(), points.x.data(), count);
+  dequantize_coordinates(y_.data(), points.y.data(), count);
+  dequantize_coordinates(z_.data(), points.z.data(), count);
+  std::copy(intensity_.cbegin(), intensity_.cend(), points.intensity.begin());
+  std::copy(ring_.cbegin(), ring_.cend(), points.ring.begin());
+  for (std::size_t i = 0; i < count; ++i) {
+    points.horizontal_angle[i] = static_cast<float>(azimuth_multiplied_by_100_deg_[i]) / 100.0F;
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    points.stamp_unix_nanoseconds[i] = stamp_unix_nanoseconds_start_ + nanoseconds_since_start_[i];
+  }
+}
+
+std::size_t CompactScan::get_size_bytes() const
+{
+  return sizeof(*this) +
+         size() * (3 * sizeof(std::int16_t) + 2 * sizeof(std::uint8_t) + sizeof(std::uint16_t) +
+                   sizeof(std::uint32_t));
+}
+}  // namespace loam_mapper::point_types
@@ -4,18 +4,95 @@
 
 #include <pcapplusplus/Packet.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 namespace loam_mapper::points_provider::continuous_packet_parser
 {
+namespace
+{
+using velodyne_model::ModelTraits;
+
+// Points of a data packet, collected so that they are appended to each column of the scan at once
+struct StagedPoints
+{
+  static constexpr size_t count_points_max = velodyne_model::count_points_data_packet;
+
+  float x[count_points_max];
+  float y[count_points_max];
+  float z[count_points_max];
+  uint32_t intensity[count_points_max];
+  uint64_t stamp_unix_nanoseconds[count_points_max];
+  uint32_t ring[count_points_max];
+  float horizontal_angle[count_points_max];
+  size_t count{0U};
+
+  // Appends the points [begin, end)
+  void append_to(point_types::PointColumnsXYZITRH & columns, size_t begin, size_t end) const
+  {
+    columns.x.insert(columns.x.end(), x + begin, x + end);
+    columns.y.insert(columns.y.end(), y + begin, y + end);
+    columns.z.insert(columns.z.end(), z + begin, z + end);
+    columns.intensity.insert(columns.intensity.end(), intensity + begin, intensity + end);
+    columns.stamp_unix_nanoseconds.insert(
+      columns.stamp_unix_nanoseconds.end(), stamp_unix_nanoseconds + begin,
+      stamp_unix_nanoseconds + end);
+    columns.ring.insert(columns.ring.end(), ring + begin, ring + end);
+    columns.horizontal_angle.insert(
+      columns.horizontal_angle.end(), horizontal_angle + begin, horizontal_angle + end);
+  }
+};
+
+// Relative change of the rotation speed between two packets above which an azimuth jump is counted
+constexpr double ratio_speed_change_azimuth_jump = 0.25;
+
+// Wraps an angle into [0, 360), for angles within a turn of it.
+float wrap_angle_deg(float angle_deg)
+{
+  if (angle_deg < 0.0f) {
+    return angle_deg + 360.0f;
+  }
+  if (angle_deg >= 360.0f) {
+    return angle_deg - 360.0f;
+  }
+  return angle_deg;
+}
+
+// Time of every firing of a data packet since its ToH
+template <typename Traits, size_t CountReturns>
+constexpr velodyne_model::TableNanosecondsFiring table_nanoseconds_firing =
+  velodyne_model::make_table_nanoseconds_firing<Traits, CountReturns>();
+}  // namespace
+
 ContinuousPacketParser::ContinuousPacketParser()
 : factory_bytes_are_read_at_least_once_{false},
   has_received_valid_position_package_{false},
+  decode_data_packet_{nullptr},
   has_processed_a_packet_{false},
+  is_priming_{false},
+  count_data_packets_processed_{0U},
+  has_time_window_{false},
+  is_past_time_window_{false},
+  stamp_unix_nanoseconds_window_start_{0U},
+  stamp_unix_nanoseconds_window_end_{std::numeric_limits<uint64_t>::max()},
   angle_deg_azimuth_last_packet_{0.0f},
   microseconds_last_packet_{0U},
-  can_publish_again_{true},
-  angle_deg_cut_{90.0f}
+  nanoseconds_data_packet_{0U},
+  speed_deg_per_microseconds_last_packet_{0.0},
+  scan_buffer_pool_{scan_buffer_pool::ScanBufferPool::create(0U)},
+  angle_deg_cut_{90.0f},
+  is_cut_armed_{true},
+  has_firing_last_{false},
+  angle_deg_relative_firing_last_{0.0f},
+  is_emitting_partial_scan_last_{false}
 {
   map_byte_to_return_mode_.insert(std::make_pair(55, ReturnMode::Strongest));
   map_byte_to_return_mode_.insert(std::make_pair(56, ReturnMode::LastReturn));
@@ -44,116 +121,81 @@ ContinuousPacketParser::ContinuousPacketParser()
   map_velodyne_model_to_string_.insert(std::make_pair(VelodyneModel::Velarray, "Velarray"));
   map_velodyne_model_to_string_.insert(std::make_pair(VelodyneModel::VLS128, "VLS128"));
 
-  channel_to_angle_vertical_ = std::vector<float>{
-    -15.0F, 1.0F,  -13.0F, 3.0F,  -11.0F, 5.0F,   -9.0F, 7.0F,   -7.0F, 9.0F,   -5.0F,
-    11.0F,  -3.0F, 13.0F,  -1.0F, 15.0F,  -15.0F, 1.0F,  -13.0F, 3.0F,  -11.0F, 5.0F,
-    -9.0F,  7.0F,  -7.0F,  9.0F,  -5.0F,  11.0F,  -3.0F, 13.0F,  -1.0F, 15.0F};
-  assert(channel_to_angle_vertical_.size() == 32);  //  VLP-16 has 32 channels in each data block
-
-  channel_mod_8_to_azimuth_offsets_ =
-    std::vector<float>{-6.354F, -4.548F, -2.732F, -0.911F, 0.911F, 2.732F, 4.548F, 6.354F};
-
-  std::vector<size_t> vec_counting_numbers(12);
-  std::iota(vec_counting_numbers.begin(), vec_counting_numbers.end(), 0);
-  ind_block_to_first_channel_.resize(12);
-  std::transform(
-    vec_counting_numbers.begin(), vec_counting_numbers.end(), ind_block_to_first_channel_.begin(),
-    [](size_t in) { return 32 * (in % 4); });
-//  std::cout << "vec_counting_numbers" << std::endl;
-  std::copy(
-    ind_block_to_first_channel_.begin(), ind_block_to_first_channel_.end(),
-    std::ostream_iterator<int>(std::cout, " "));
+  decode_block_ = block_decoder::get_decode_block(block_decoder::detect_isa());
+  dual_return_policy_ = DualReturnPolicy::Both;
 }
 
 void ContinuousPacketParser::process_packet_into_cloud(
   const pcpp::RawPacket & rawPacket,
-  const std::function<void(const Points &)> & callback_cloud_surround_out)
+  const std::function<void(ScanLease)> & callback_cloud_surround_out)
+{
+  process_packet_into_cloud(
+    rawPacket.getRawData(), rawPacket.getFrameLength(), callback_cloud_surround_out);
+}
+
+void ContinuousPacketParser::process_packet_into_cloud(
+  const uint8_t * data_packet,
+  size_t length_packet,
+  const std::function<void(ScanLease)> & callback_cloud_surround_out)
 {
-  switch (rawPacket.getFrameLength()) {
-    case 554: {
+  switch (packet_filter_.classify(data_packet, length_packet)) {
+    case packet_filter::PacketFilter::Kind::Position: {
       if (has_received_valid_position_package_) {
+        if (!is_receiver_active(data_packet)) {
+          telemetry_.count_position_packets_inactive++;
+        }
         break;
       }
 
-      auto * position_packet = reinterpret_cast<const PositionPacket *>(rawPacket.getRawData());
-
-      std::string nmea_sentence(position_packet->nmea_sentence);
-      auto segments_with_nullstuff = utils::Utils::string_to_vec_split_by(nmea_sentence, '\r');
-
-      auto segments_with_crc =
-        utils::Utils::string_to_vec_split_by(segments_with_nullstuff.front(), '*');
-      auto segments = utils::Utils::string_to_vec_split_by(segments_with_crc.front(), ',');
-
-      if (13 > segments.size() || 14 < segments.size()) {
-        throw std::length_error(
-          "nmea sentence should have 13 elements, it has " + std::to_string(segments.size()));
-      }
-
       // Receiver status: A= Active, V= Void
-      if (segments.at(2) != "A") {
+      if (!parse_hours_since_epoch(data_packet, tp_hours_since_epoch)) {
         std::cout << "Receiver Status != Active" << std::endl;
+        telemetry_.count_position_packets_inactive++;
         break;
       }
-      const auto & str_time = segments.at(1);
-      int hours_raw = std::stoi(str_time.substr(0, 2));
-
-      const auto & str_date = segments.at(9);
-      int days_raw = std::stoi(str_date.substr(0, 2));
-      int months_raw = std::stoi(str_date.substr(2, 2));
-      int years_raw = 2000 + std::stoi(str_date.substr(4, 2));
-
-      date::year_month_day date_current_ = date::year{years_raw} / months_raw / days_raw;
-      tp_hours_since_epoch = date::sys_days(date_current_) + std::chrono::hours(hours_raw);
-      uint32_t seconds_epoch_precision_of_hour =
-        std::chrono::seconds(tp_hours_since_epoch.time_since_epoch()).count();
 
       has_received_valid_position_package_ = true;
       break;
     }
-    case 1248: {
+    case packet_filter::PacketFilter::Kind::Data: {
       // Data Packet
       if (!has_received_valid_position_package_) {
         // Ignore until first valid Position Packet is received
         break;
       }
-      const auto * data_packet_with_header =
-        reinterpret_cast<const DataPacket *>(rawPacket.getRawData());
-
-      // TOH = Top Of the Hour
-      date::hh_mm_ss microseconds_since_toh =
-        date::make_time(std::chrono::microseconds(data_packet_with_header->microseconds_toh));
-      //          std::cout << "data_packet_with_header->timestamp_microseconds_since_hour: " <<
-      //            data_packet_with_header->timestamp_microseconds_since_hour << std::endl;
-      //          std::cout << "date_time.hours(): " << microseconds_since_toh.hours().count() <<
-      //          std::endl; std::cout << "date_time.minutes(): " <<
-      //          microseconds_since_toh.minutes().count() << std::endl; std::cout <<
-      //          "date_time.seconds(): " << microseconds_since_toh.seconds().count() <<
-      //          std::endl;
+      const auto * data_packet_with_header = reinterpret_cast<const DataPacket *>(data_packet);
+
+      // Gate on the packet time before touching the data blocks. Packets before the window
+      // still advance the azimuth and scan cut state, but no points are decoded from them.
+      bool is_before_time_window = false;
+      if (has_time_window_) {
+        auto tp_hours_packet = tp_hours_since_epoch;
+        if (
+          has_processed_a_packet_ &&
+          data_packet_with_header->microseconds_toh < microseconds_last_packet_) {
+          tp_hours_packet += std::chrono::hours(1);
+        }
+        const uint64_t stamp_unix_nanoseconds_packet =
+          static_cast<uint64_t>(
+            std::chrono::nanoseconds(tp_hours_packet.time_since_epoch()).count()) +
+          static_cast<uint64_t>(data_packet_with_header->microseconds_toh) * 1000U;
+        if (stamp_unix_nanoseconds_packet > stamp_unix_nanoseconds_window_end_) {
+          is_past_time_window_ = true;
+          break;
+        }
+        is_before_time_window =
+          stamp_unix_nanoseconds_packet < stamp_unix_nanoseconds_window_start_;
+      }
+      const bool is_decoding_points = !is_priming_ && !is_before_time_window;
 
       auto velodyne_model =
         map_byte_to_velodyne_model_.at(data_packet_with_header->factory_byte_product_id);
       auto return_mode =
         map_byte_to_return_mode_.at(data_packet_with_header->factory_byte_return_mode);
 
-      // I can only process Single Return Modes for now
-      if (return_mode != ReturnMode::Strongest && return_mode != ReturnMode::LastReturn) {
-        throw std::runtime_error(
-          "return_mode was expected to be either: " +
-          map_return_mode_to_string_.at(ReturnMode::Strongest) +
-          " or: " + map_return_mode_to_string_.at(ReturnMode::LastReturn) +
-          " but it was: " + map_return_mode_to_string_.at(return_mode));
-      }
-
-      // I can only process VLS128 data packets for now
-      if (velodyne_model != VelodyneModel::VLP16orPuckLITE) {
-        throw std::runtime_error(
-          "velodyne_model was expected to be: " +
-          map_velodyne_model_to_string_.at(VelodyneModel::VLP16orPuckLITE) +
-          " but it was: " + map_velodyne_model_to_string_.at(velodyne_model));
-      }
-
       // Once factory bytes are received, it is expected to be the same in every data packet.
       if (!factory_bytes_are_read_at_least_once_) {
+        select_model(velodyne_model, return_mode);
         velodyne_model_ = velodyne_model;
         return_mode_ = return_mode;
         factory_bytes_are_read_at_least_once_ = true;
@@ -171,119 +213,607 @@ void ContinuousPacketParser::process_packet_into_cloud(
         }
       }
 
-      // Iterate through 12 blocks
-      double speed_deg_per_microseconds_angle_azimuth;
-      float angle_deg_azimuth_last;
-      for (size_t ind_block = 0; ind_block < data_packet_with_header->get_size_data_blocks();
-           ind_block++) {
-        const auto & data_block = data_packet_with_header->data_blocks[ind_block];
-        float angle_deg_azimuth_of_block =
-          static_cast<float>(data_block.azimuth_multiplied_by_100_deg) / 100.0f;
-
-        if (!has_processed_a_packet_) {
-          angle_deg_azimuth_last_packet_ = angle_deg_azimuth_of_block;
-          microseconds_last_packet_ = data_packet_with_header->microseconds_toh;
-          has_processed_a_packet_ = true;
-          break;
-        } else if (ind_block == 0) {
-          // Compensate for azimuth angular rollover
-          float angle_deg_azimuth_increased = angle_deg_azimuth_of_block;
-          if (angle_deg_azimuth_of_block < angle_deg_azimuth_last_packet_) {
-            angle_deg_azimuth_increased += 360.0f;
-          }
-          float angle_deg_angle_delta =
-            angle_deg_azimuth_increased - angle_deg_azimuth_last_packet_;
+      count_data_packets_processed_++;
 
-          // Compensate for ToH microseconds rollover
+      if (!has_processed_a_packet_) {
+        // The rotation speed is only known from the second packet on.
+        angle_deg_azimuth_last_packet_ =
+          static_cast<float>(read_azimuth_multiplied_by_100_deg(data_packet)) / 100.0f;
+        microseconds_last_packet_ = data_packet_with_header->microseconds_toh;
+        has_processed_a_packet_ = true;
+        break;
+      }
 
-          uint32_t microseconds_toh_current_increased = data_packet_with_header->microseconds_toh;
-          if (data_packet_with_header->microseconds_toh < microseconds_last_packet_) {
-            microseconds_toh_current_increased += 3600000000U;
-            // Increase internal epoch hour time point
-            tp_hours_since_epoch += std::chrono::hours(1);
-          }
-          uint32_t microseconds_delta =
-            microseconds_toh_current_increased - microseconds_last_packet_;
+      update_telemetry(*data_packet_with_header);
+      (this->*decode_data_packet_)(
+        *data_packet_with_header, is_decoding_points, callback_cloud_surround_out);
+      break;
+    }
+    default: {
+      //          std::cerr << "Unknown package with length: " << length_packet <<
+      //          std::endl;
+      break;
+    }
+  }
+}
 
-          speed_deg_per_microseconds_angle_azimuth =
-            static_cast<double>(angle_deg_angle_delta) / microseconds_delta;
+void ContinuousPacketParser::select_model(VelodyneModel velodyne_model, ReturnMode return_mode)
+{
+  // The confidence bytes of the VLS-128 aren't decoded
+  if (return_mode == ReturnMode::DualReturnWithConfidence) {
+    throw std::runtime_error(
+      "return_mode is not supported: " + map_return_mode_to_string_.at(return_mode));
+  }
+  const bool is_dual_return = return_mode == ReturnMode::DualReturn;
 
-          angle_deg_azimuth_last_packet_ = angle_deg_azimuth_of_block;
-          microseconds_last_packet_ = data_packet_with_header->microseconds_toh;
-        }
+  switch (velodyne_model) {
+    case VelodyneModel::VLP16orPuckLITE:
+      select_model<ModelTraits<VelodyneModel::VLP16orPuckLITE>>(is_dual_return);
+      break;
+    case VelodyneModel::HDL32E:
+      select_model<ModelTraits<VelodyneModel::HDL32E>>(is_dual_return);
+      break;
+    case VelodyneModel::VLP32CorVLP32MR:
+      select_model<ModelTraits<VelodyneModel::VLP32CorVLP32MR>>(is_dual_return);
+      break;
+    case VelodyneModel::VLS128:
+      select_model<ModelTraits<VelodyneModel::VLS128>>(is_dual_return);
+      break;
+    default:
+      throw std::runtime_error(
+        "velodyne_model is not supported: " + map_velodyne_model_to_string_.at(velodyne_model));
+  }
+}
 
-        // Iterate through 32 points within a block
-        for (size_t ind_point = 0; ind_point < data_block.get_size_data_points(); ind_point++) {
-          const auto & data_point = data_block.data_points[ind_point];
+template <typename Traits>
+void ContinuousPacketParser::select_model(bool is_dual_return)
+{
+  if (!calibration_.empty()) {
+    if (calibration_.get_count_lasers() != Traits::count_lasers) {
+      throw std::runtime_error(
+        "calibration was expected to have " + std::to_string(Traits::count_lasers) +
+        " lasers for " + Traits::name + " but it has " +
+        std::to_string(calibration_.get_count_lasers()));
+    }
+  } else if (!Traits::has_built_in_geometry) {
+    throw std::runtime_error(
+      std::string("velodyne_model needs a calibration for its laser angles: ") + Traits::name);
+  }
+  // Only the layout of single bank models, which repeat every block, is known in dual mode.
+  if (is_dual_return && Traits::count_banks > 1) {
+    throw std::runtime_error(
+      std::string("velodyne_model is not supported in dual return mode: ") + Traits::name);
+  }
 
-          double timing_offset_from_first_firing;
-          if (ind_point > 15) {
-            timing_offset_from_first_firing = 18.432 + 2.304 * static_cast<int>(ind_point);
-          } else {
-            timing_offset_from_first_firing = 2.304 * static_cast<int>(ind_point);
-          }
-          float angle_deg_azimuth_point =
-            angle_deg_azimuth_of_block +
-            static_cast<float>(
-              speed_deg_per_microseconds_angle_azimuth * timing_offset_from_first_firing);
+  banks_.resize(Traits::count_banks);
+  for (size_t ind_bank = 0; ind_bank < Traits::count_banks; ++ind_bank) {
+    auto & bank = banks_.at(ind_bank);
+    bank.channel_table.millimeters_per_distance_unit = Traits::millimeters_per_distance_unit;
+    bank.channel_table.distance_min =
+      block_decoder::millimeters_range_min / Traits::millimeters_per_distance_unit;
+    bank.channel_table.distance_max =
+      block_decoder::millimeters_range_max / Traits::millimeters_per_distance_unit;
+    for (size_t ind_channel = 0; ind_channel < block_decoder::count_channels_block;
+         ++ind_channel) {
+      const size_t laser = Traits::get_laser(ind_bank, ind_channel);
+      velodyne_calibration::LaserCorrection laser_correction;
+      if (calibration_.empty()) {
+        laser_correction.angle_deg_vertical = Traits::angles_deg_vertical[laser];
+        laser_correction.angle_deg_azimuth_offset = Traits::angles_deg_azimuth_offset[laser];
+      } else {
+        laser_correction = calibration_.get_laser(laser);
+      }
 
-          if (angle_deg_azimuth_point >= 360.0f) {
-            angle_deg_azimuth_point -= 360.0f;
-          }
+      const double angle_rad_vertical =
+        utils::Utils::deg_to_rad(static_cast<double>(laser_correction.angle_deg_vertical));
+      const double cos_vertical = std::cos(angle_rad_vertical);
+      const double sin_vertical = std::sin(angle_rad_vertical);
+      const double meters_distance_offset = laser_correction.meters_distance_offset;
+      const double meters_vertical_offset = laser_correction.meters_vertical_offset;
+      bank.channel_table.cos_vertical[ind_channel] = static_cast<float>(cos_vertical);
+      bank.channel_table.sin_vertical[ind_channel] = static_cast<float>(sin_vertical);
+      bank.channel_table.offset_xy[ind_channel] = static_cast<float>(
+        meters_distance_offset * cos_vertical - meters_vertical_offset * sin_vertical);
+      bank.channel_table.offset_z[ind_channel] = static_cast<float>(
+        meters_distance_offset * sin_vertical + meters_vertical_offset * cos_vertical);
+      bank.channel_table.offset_horizontal[ind_channel] =
+        laser_correction.meters_horizontal_offset;
+
+      const float angle_deg_azimuth_offset = laser_correction.angle_deg_azimuth_offset;
+      const double angle_rad_azimuth_offset =
+        utils::Utils::deg_to_rad(static_cast<double>(angle_deg_azimuth_offset));
+      bank.angle_deg_azimuth_offset[ind_channel] = angle_deg_azimuth_offset;
+      bank.sin_azimuth_offset[ind_channel] = static_cast<float>(std::sin(angle_rad_azimuth_offset));
+      bank.cos_azimuth_offset[ind_channel] = static_cast<float>(std::cos(angle_rad_azimuth_offset));
+    }
+  }
 
-          angle_deg_azimuth_last = angle_deg_azimuth_point;
-          float angle_rad_azimuth_point = utils::Utils::deg_to_rad(angle_deg_azimuth_point);
-
-          float angle_deg_vertical = channel_to_angle_vertical_.at(ind_point);
-          float angle_rad_vertical = utils::Utils::deg_to_rad(angle_deg_vertical);
-          float dist_m = static_cast<float>(data_point.distance_divided_by_2mm * 2) / 1000.0f;
-          float dist_xy = dist_m * std::cos(angle_rad_vertical);
-          Point point;
-          point.x = dist_xy * std::sin(angle_rad_azimuth_point);
-          point.y = dist_xy * std::cos(angle_rad_azimuth_point);
-          point.z = dist_m * std::sin(angle_rad_vertical);
-          point.intensity = data_point.reflectivity;
-          point.ring = ind_point % 16 + 1;
-          point.horizontal_angle = angle_deg_azimuth_point;
-          point.stamp_unix_seconds =
-            std::chrono::seconds(
-              tp_hours_since_epoch.time_since_epoch() + microseconds_since_toh.minutes() +
-              microseconds_since_toh.seconds())
-              .count();
-          point.stamp_nanoseconds =
-            std::chrono::nanoseconds(microseconds_since_toh.subseconds()).count();
-
-          if (std::sqrt(std::pow(point.x, 2) + std::pow(point.y, 2) + std::pow(point.z, 2)) < 2.0) {
-            continue;
-          } else if (
-            std::sqrt(std::pow(point.x, 2) + std::pow(point.y, 2) + std::pow(point.z, 2)) > 60) {
-            continue;
-          }
+  const size_t count_firings_data_packet =
+    velodyne_model::count_blocks_data_packet / (is_dual_return ? 2 : 1);
+  nanoseconds_data_packet_ = static_cast<uint32_t>(
+    Traits::get_nanoseconds_block(count_firings_data_packet) - Traits::get_nanoseconds_block(0));
+
+  const size_t count_points_scan_max =
+    is_dual_return ? velodyne_model::get_count_points_scan_max<Traits, 2>()
+                   : velodyne_model::get_count_points_scan_max<Traits, 1>();
+  scan_buffer_pool_->reserve(count_points_scan_max);
+  cloud_.reserve(count_points_scan_max);
+  decode_data_packet_ = &ContinuousPacketParser::decode_data_packet<Traits, 1>;
+  if constexpr (Traits::count_banks == 1) {
+    if (is_dual_return) {
+      decode_data_packet_ = &ContinuousPacketParser::decode_data_packet<Traits, 2>;
+    }
+  }
+}
 
-          cloud_.push_back(point);
+template <typename Traits, size_t CountReturns>
+void ContinuousPacketParser::decode_data_packet(
+  const DataPacket & data_packet, bool is_decoding_points,
+  const std::function<void(ScanLease)> & callback_cloud_surround_out)
+{
+  using block_decoder::count_channels_block;
+
+  // Compensate for azimuth angular rollover
+  const float angle_deg_azimuth_of_packet =
+    static_cast<float>(data_packet.data_blocks[0].azimuth_multiplied_by_100_deg) / 100.0f;
+  float angle_deg_azimuth_increased = angle_deg_azimuth_of_packet;
+  if (angle_deg_azimuth_of_packet < angle_deg_azimuth_last_packet_) {
+    angle_deg_azimuth_increased += 360.0f;
+  }
+  float angle_deg_angle_delta = angle_deg_azimuth_increased - angle_deg_azimuth_last_packet_;
+
+  // Compensate for ToH microseconds rollover
+  uint32_t microseconds_toh_current_increased = data_packet.microseconds_toh;
+  if (data_packet.microseconds_toh < microseconds_last_packet_) {
+    microseconds_toh_current_increased += 3600000000U;
+    // Increase internal epoch hour time point
+    tp_hours_since_epoch += std::chrono::hours(1);
+  }
+  uint32_t microseconds_delta = microseconds_toh_current_increased - microseconds_last_packet_;
+
+  const double speed_deg_per_microseconds_angle_azimuth =
+    static_cast<double>(angle_deg_angle_delta) / microseconds_delta;
+
+  angle_deg_azimuth_last_packet_ = angle_deg_azimuth_of_packet;
+  microseconds_last_packet_ = data_packet.microseconds_toh;
+
+  // TOH = Top Of the Hour
+  const uint64_t stamp_unix_nanoseconds_packet =
+    static_cast<uint64_t>(
+      std::chrono::nanoseconds(tp_hours_since_epoch.time_since_epoch()).count()) +
+    static_cast<uint64_t>(data_packet.microseconds_toh) * 1000U;
+
+  // Azimuth advance of every firing group since the first firing of its block
+  std::array<float, Traits::count_firing_groups> angles_deg_firing_group;
+  std::array<float, Traits::count_firing_groups> sins_firing_group;
+  std::array<float, Traits::count_firing_groups> coss_firing_group;
+  for (size_t ind_firing_group = 0; ind_firing_group < Traits::count_firing_groups;
+       ++ind_firing_group) {
+    const double microseconds_firing_group =
+      static_cast<double>(Traits::get_nanoseconds_firing_group(ind_firing_group)) / 1000.0;
+    const float angle_deg_firing_group =
+      static_cast<float>(speed_deg_per_microseconds_angle_azimuth * microseconds_firing_group);
+    angles_deg_firing_group[ind_firing_group] = angle_deg_firing_group;
+    if (is_decoding_points) {
+      const float angle_rad_firing_group = utils::Utils::deg_to_rad(angle_deg_firing_group);
+      sins_firing_group[ind_firing_group] = std::sin(angle_rad_firing_group);
+      coss_firing_group[ind_firing_group] = std::cos(angle_rad_firing_group);
+    }
+  }
+
+  const auto & table_nanoseconds = table_nanoseconds_firing<Traits, CountReturns>;
+
+  // Finds the first firing past the cut azimuth, where the azimuth relative to the cut wraps
+  // around. The azimuth only advances within a block, so only its first and last firings are
+  // checked unless it wraps in between.
+  auto get_angle_deg_relative = [&](size_t ind_block, size_t ind_channel) {
+    const size_t ind_bank = ind_block / CountReturns % Traits::count_banks;
+    return wrap_angle_deg(
+      static_cast<float>(data_packet.data_blocks[ind_block].azimuth_multiplied_by_100_deg) /
+        100.0f +
+      angles_deg_firing_group[Traits::get_firing_group(ind_bank, ind_channel)] - angle_deg_cut_);
+  };
+  bool has_cut = false;
+  size_t ind_block_cut = 0;
+  size_t ind_channel_cut = 0;
+  for (size_t ind_block = 0; ind_block < velodyne_model::count_blocks_data_packet;
+       ind_block += CountReturns) {
+    const float angle_deg_relative_first = get_angle_deg_relative(ind_block, 0);
+    const float angle_deg_relative_last =
+      get_angle_deg_relative(ind_block, count_channels_block - 1);
+    if (!has_cut && is_cut_armed_) {
+      if (has_firing_last_ && angle_deg_relative_first < angle_deg_relative_firing_last_ - 180.0f) {
+        has_cut = true;
+        ind_block_cut = ind_block;
+        ind_channel_cut = 0;
+      } else if (angle_deg_relative_last < angle_deg_relative_first - 180.0f) {
+        has_cut = true;
+        ind_block_cut = ind_block;
+        ind_channel_cut = 1;
+        while (get_angle_deg_relative(ind_block, ind_channel_cut) >=
+               angle_deg_relative_first - 180.0f) {
+          ind_channel_cut++;
         }
       }
+      is_cut_armed_ = !has_cut;
+    }
+    if (angle_deg_relative_last >= 90.0f && angle_deg_relative_last < 270.0f) {
+      is_cut_armed_ = true;
+    }
+    angle_deg_relative_firing_last_ = angle_deg_relative_last;
+    has_firing_last_ = true;
+  }
+  uint64_t stamp_unix_nanoseconds_cut = 0U;
+  float angle_deg_cut_in_packet = 0.0f;
+  if (has_cut) {
+    stamp_unix_nanoseconds_cut =
+      stamp_unix_nanoseconds_packet +
+      static_cast<uint64_t>(table_nanoseconds[ind_block_cut][ind_channel_cut]);
+    const size_t ind_bank_cut = ind_block_cut / CountReturns % Traits::count_banks;
+    angle_deg_cut_in_packet =
+      wrap_angle_deg(
+        static_cast<float>(data_packet.data_blocks[ind_block_cut].azimuth_multiplied_by_100_deg) /
+          100.0f -
+        angle_deg_azimuth_of_packet + 180.0f) -
+      180.0f + angles_deg_firing_group[Traits::get_firing_group(ind_bank_cut, ind_channel_cut)];
+  }
 
-      bool is_close_to_cut_area = std::abs(angle_deg_azimuth_last - angle_deg_cut_) < 3.0f;
+  if (!is_decoding_points) {
+    if (has_cut) {
+      cut_scan(
+        stamp_unix_nanoseconds_cut, angle_deg_cut_in_packet, false, callback_cloud_surround_out);
+    }
+    return;
+  }
 
-      if (!is_close_to_cut_area) {
-        can_publish_again_ = true;
-      }
+  // Combined with the azimuth offsets of the lasers, sin(a + b) and cos(a + b)
+  std::array<block_decoder::FiringOffsets, Traits::count_banks> firing_offsets_banks;
+  for (size_t ind_bank = 0; ind_bank < Traits::count_banks; ++ind_bank) {
+    const auto & bank = banks_[ind_bank];
+    auto & firing_offsets = firing_offsets_banks[ind_bank];
+    for (size_t ind_channel = 0; ind_channel < count_channels_block; ++ind_channel) {
+      const size_t ind_firing_group = Traits::get_firing_group(ind_bank, ind_channel);
+      firing_offsets.angle_deg[ind_channel] =
+        angles_deg_firing_group[ind_firing_group] + bank.angle_deg_azimuth_offset[ind_channel];
+      const float sin_firing_group = sins_firing_group[ind_firing_group];
+      const float cos_firing_group = coss_firing_group[ind_firing_group];
+      firing_offsets.sin[ind_channel] = sin_firing_group * bank.cos_azimuth_offset[ind_channel] +
+                                        cos_firing_group * bank.sin_azimuth_offset[ind_channel];
+      firing_offsets.cos[ind_channel] = cos_firing_group * bank.cos_azimuth_offset[ind_channel] -
+                                        sin_firing_group * bank.sin_azimuth_offset[ind_channel];
+    }
+  }
+
+  // A scan that doesn't start at a cut starts at the first firing decoded into it.
+  if (telemetry_.stamp_unix_nanoseconds_start == 0U) {
+    telemetry_.stamp_unix_nanoseconds_start =
+      stamp_unix_nanoseconds_packet + static_cast<uint64_t>(table_nanoseconds[0][0]);
+  }
 
-      if (can_publish_again_ && is_close_to_cut_area) {
-        callback_cloud_surround_out(cloud_);
-        cloud_.clear();
-        can_publish_again_ = false;
+  StagedPoints staged_points;
+  auto push_point = [&](
+                      const block_decoder::DecodedBlock & decoded_block,
+                      const DataBlock & data_block, size_t ind_block, size_t ind_point) {
+    const size_t ind_staged = staged_points.count++;
+    staged_points.x[ind_staged] = decoded_block.x[ind_point];
+    staged_points.y[ind_staged] = decoded_block.y[ind_point];
+    staged_points.z[ind_staged] = decoded_block.z[ind_point];
+    staged_points.intensity[ind_staged] = data_block.data_points[ind_point].reflectivity;
+    // Firings before the ToH have negative offsets, which wrap around as intended.
+    staged_points.stamp_unix_nanoseconds[ind_staged] =
+      stamp_unix_nanoseconds_packet +
+      static_cast<uint64_t>(table_nanoseconds[ind_block][ind_point]);
+    staged_points.ring[ind_staged] =
+      static_cast<uint32_t>(
+        Traits::get_laser(ind_block / CountReturns % Traits::count_banks, ind_point)) +
+      1U;
+    staged_points.horizontal_angle[ind_staged] = decoded_block.angle_deg_azimuth[ind_point];
+  };
+
+  block_decoder::DecodedBlock decoded_block;
+  if constexpr (CountReturns == 1) {
+    for (size_t ind_block = 0; ind_block < velodyne_model::count_blocks_data_packet;
+         ++ind_block) {
+      const auto & data_block = data_packet.data_blocks[ind_block];
+      const size_t ind_bank = ind_block % Traits::count_banks;
+      decode_block_(
+        reinterpret_cast<const uint8_t *>(data_block.data_points),
+        data_block.azimuth_multiplied_by_100_deg, banks_[ind_bank].channel_table,
+        firing_offsets_banks[ind_bank], decoded_block);
+
+      // Points within the range gate, in channel order
+      for (uint32_t mask_valid = decoded_block.mask_valid; mask_valid != 0U;
+           mask_valid &= mask_valid - 1U) {
+        push_point(
+          decoded_block, data_block, ind_block, static_cast<size_t>(__builtin_ctz(mask_valid)));
+      }
+    }
+  } else {
+    static_assert(CountReturns == 2 && Traits::count_banks == 1);
+    const auto & channel_table = banks_.front().channel_table;
+    const auto & firing_offsets = firing_offsets_banks.front();
+    block_decoder::DecodedBlock decoded_block_strongest;
+    for (size_t ind_block = 0; ind_block < velodyne_model::count_blocks_data_packet;
+         ind_block += 2) {
+      const auto & data_block_last = data_packet.data_blocks[ind_block];
+      const auto & data_block_strongest = data_packet.data_blocks[ind_block + 1];
+      decode_block_(
+        reinterpret_cast<const uint8_t *>(data_block_last.data_points),
+        data_block_last.azimuth_multiplied_by_100_deg, channel_table, firing_offsets,
+        decoded_block);
+      uint32_t mask_last = decoded_block.mask_valid;
+      uint32_t mask_strongest = 0U;
+
+      if (dual_return_policy_ != DualReturnPolicy::Last) {
+        decode_block_(
+          reinterpret_cast<const uint8_t *>(data_block_strongest.data_points),
+          data_block_strongest.azimuth_multiplied_by_100_deg, channel_table, firing_offsets,
+          decoded_block_strongest);
+        // Picks the returns to keep of each firing. When the strongest return is also the last,
+        // the second strongest is reported in the strongest block instead.
+        uint32_t mask_keep_last = 0U;
+        uint32_t mask_keep_strongest = 0U;
+        for (size_t ind_point = 0; ind_point < count_channels_block; ++ind_point) {
+          const auto & data_point_last = data_block_last.data_points[ind_point];
+          const auto & data_point_strongest = data_block_strongest.data_points[ind_point];
+          const uint32_t bit = 1U << ind_point;
+          if (dual_return_policy_ == DualReturnPolicy::Strongest) {
+            if (data_point_last.reflectivity > data_point_strongest.reflectivity) {
+              mask_keep_last |= bit;
+            } else {
+              mask_keep_strongest |= bit;
+            }
+          } else {
+            mask_keep_last |= bit;
+            // A single return is reported in both blocks
+            if (
+              data_point_last.distance_divided_by_2mm !=
+                data_point_strongest.distance_divided_by_2mm ||
+              data_point_last.reflectivity != data_point_strongest.reflectivity) {
+              mask_keep_strongest |= bit;
+            }
+          }
+        }
+        mask_last &= mask_keep_last;
+        mask_strongest = decoded_block_strongest.mask_valid & mask_keep_strongest;
       }
 
-      break;
+      // Points within the range gate, in channel order, the last return first
+      for (uint32_t mask_valid = mask_last | mask_strongest; mask_valid != 0U;
+           mask_valid &= mask_valid - 1U) {
+        const auto ind_point = static_cast<size_t>(__builtin_ctz(mask_valid));
+        const uint32_t bit = 1U << ind_point;
+        if (mask_last & bit) {
+          push_point(decoded_block, data_block_last, ind_block, ind_point);
+        }
+        if (mask_strongest & bit) {
+          push_point(decoded_block_strongest, data_block_strongest, ind_block + 1, ind_point);
+        }
+      }
     }
-    default: {
-      //          std::cerr << "Unknown package with length: " << rawPacket.getFrameLength() <<
-      //          std::endl;
-      break;
+  }
+  // The points are in firing order, those fired before the cut finish the current scan.
+  size_t ind_staged_cut = 0;
+  if (has_cut) {
+    ind_staged_cut = static_cast<size_t>(
+      std::lower_bound(
+        staged_points.stamp_unix_nanoseconds,
+        staged_points.stamp_unix_nanoseconds + staged_points.count, stamp_unix_nanoseconds_cut) -
+      staged_points.stamp_unix_nanoseconds);
+    staged_points.append_to(cloud_, 0, ind_staged_cut);
+    cut_scan(
+      stamp_unix_nanoseconds_cut, angle_deg_cut_in_packet, true, callback_cloud_surround_out);
+  }
+  staged_points.append_to(cloud_, ind_staged_cut, staged_points.count);
+  telemetry_.stamp_unix_nanoseconds_end =
+    stamp_unix_nanoseconds_packet +
+    static_cast<uint64_t>(
+      table_nanoseconds[velodyne_model::count_blocks_data_packet - 1][count_channels_block - 1]);
+}
+
+void ContinuousPacketParser::cut_scan(
+  uint64_t stamp_unix_nanoseconds_cut, float angle_deg_cut_in_packet, bool is_decoding_points,
+  const std::function<void(ScanLease)> & callback_cloud_surround_out)
+{
+  // The span counts from the first firing of the packets, the scans from the cut firings.
+  telemetry_.stamp_unix_nanoseconds_end = stamp_unix_nanoseconds_cut;
+  telemetry_.angle_deg_span += angle_deg_cut_in_packet;
+  if (is_decoding_points) {
+    callback_cloud_surround_out(take_partial_cloud());
+  }
+  discard_partial_cloud();
+  telemetry_.stamp_unix_nanoseconds_start = stamp_unix_nanoseconds_cut;
+  telemetry_.angle_deg_span = -angle_deg_cut_in_packet;
+}
+
+void ContinuousPacketParser::finish(
+  const std::function<void(ScanLease)> & callback_cloud_surround_out)
+{
+  if (is_emitting_partial_scan_last_ && !cloud_.empty()) {
+    callback_cloud_surround_out(take_partial_cloud());
+  }
+  discard_partial_cloud();
+}
+
+void ContinuousPacketParser::set_angle_deg_cut(float angle_deg_cut)
+{
+  if (!(angle_deg_cut >= 0.0f && angle_deg_cut < 360.0f)) {
+    throw std::invalid_argument(
+      "angle_deg_cut was expected to be in [0, 360) but it was: " + std::to_string(angle_deg_cut));
+  }
+  angle_deg_cut_ = angle_deg_cut;
+}
+
+void ContinuousPacketParser::update_telemetry(const DataPacket & data_packet)
+{
+  telemetry_.count_data_packets++;
+
+  const float angle_deg_azimuth_of_packet =
+    static_cast<float>(data_packet.data_blocks[0].azimuth_multiplied_by_100_deg) / 100.0f;
+  float angle_deg_delta = angle_deg_azimuth_of_packet - angle_deg_azimuth_last_packet_;
+  if (angle_deg_delta < 0.0f) {
+    angle_deg_delta += 360.0f;
+  }
+
+  uint64_t microseconds_delta = data_packet.microseconds_toh;
+  if (data_packet.microseconds_toh < microseconds_last_packet_) {
+    telemetry_.count_toh_rollovers++;
+    microseconds_delta += 3600000000U;
+  }
+  microseconds_delta -= microseconds_last_packet_;
+
+  // Whole packet periods since the previous packet, more than one if packets are missing
+  const uint64_t count_periods =
+    (microseconds_delta * 1000U + nanoseconds_data_packet_ / 2U) / nanoseconds_data_packet_;
+  if (count_periods > 1U) {
+    telemetry_.count_data_packets_dropped += count_periods - 1U;
+  }
+
+  // Dropped packets don't change the speed, the azimuth of a jump doesn't follow the time. A
+  // repeated packet has no speed, it is a jump only if its azimuth moved.
+  const double speed_deg_per_microseconds =
+    microseconds_delta == 0U
+      ? 0.0
+      : static_cast<double>(angle_deg_delta) / static_cast<double>(microseconds_delta);
+  const bool is_azimuth_jump =
+    microseconds_delta == 0U
+      ? angle_deg_delta > 0.0f
+      : speed_deg_per_microseconds_last_packet_ > 0.0 &&
+          std::abs(speed_deg_per_microseconds - speed_deg_per_microseconds_last_packet_) >
+            ratio_speed_change_azimuth_jump * speed_deg_per_microseconds_last_packet_;
+  if (is_azimuth_jump) {
+    // Neither the speed nor the azimuth of a jump is trusted, the span advances as the sensor
+    // would have rotated.
+    telemetry_.count_azimuth_jumps++;
+    telemetry_.angle_deg_span += static_cast<float>(
+      speed_deg_per_microseconds_last_packet_ * static_cast<double>(microseconds_delta));
+    return;
+  }
+  telemetry_.angle_deg_span += angle_deg_delta;
+  if (microseconds_delta != 0U) {
+    speed_deg_per_microseconds_last_packet_ = speed_deg_per_microseconds;
+  }
+}
+
+ContinuousPacketParser::ScanLease ContinuousPacketParser::take_partial_cloud()
+{
+  ScanLease cloud = scan_buffer_pool_->acquire();
+  std::swap(cloud.get_points(), cloud_);
+  cloud.get_telemetry() = telemetry_;
+  telemetry_ = scan_telemetry::ScanTelemetry();
+  return cloud;
+}
+
+ContinuousPacketParser::DualReturnPolicy ContinuousPacketParser::parse_dual_return_policy(
+  const std::string & name)
+{
+  if (name == "strongest") {
+    return DualReturnPolicy::Strongest;
+  }
+  if (name == "last") {
+    return DualReturnPolicy::Last;
+  }
+  if (name == "both") {
+    return DualReturnPolicy::Both;
+  }
+  throw std::invalid_argument(
+    "dual_return_policy was expected to be strongest, last or both but it was: " + name);
+}
+
+void ContinuousPacketParser::set_time_window(
+  uint64_t stamp_unix_nanoseconds_start, uint64_t stamp_unix_nanoseconds_end)
+{
+  has_time_window_ = true;
+  is_past_time_window_ = false;
+  stamp_unix_nanoseconds_window_start_ = stamp_unix_nanoseconds_start;
+  stamp_unix_nanoseconds_window_end_ = stamp_unix_nanoseconds_end;
+}
+
+bool ContinuousPacketParser::parse_hours_since_epoch(
+  const uint8_t * position_packet_bytes, date::sys_time<std::chrono::hours> & tp_hours)
+{
+  static_assert(sizeof(PositionPacket) == size_position_packet);
+  const auto * position_packet = reinterpret_cast<const PositionPacket *>(position_packet_bytes);
+
+  std::string nmea_sentence(
+    position_packet->nmea_sentence,
+    strnlen(position_packet->nmea_sentence, sizeof(position_packet->nmea_sentence)));
+  auto segments_with_nullstuff = utils::Utils::string_to_vec_split_by(nmea_sentence, '\r');
+  if (segments_with_nullstuff.empty()) {
+    throw std::length_error("nmea sentence is empty");
+  }
+
+  auto segments_with_crc =
+    utils::Utils::string_to_vec_split_by(segments_with_nullstuff.front(), '*');
+  auto segments = utils::Utils::string_to_vec_split_by(segments_with_crc.front(), ',');
+
+  if (13 > segments.size() || 14 < segments.size()) {
+    throw std::length_error(
+      "nmea sentence should have 13 elements, it has " + std::to_string(segments.size()));
+  }
+
+  // Receiver status: A= Active, V= Void
+  if (segments.at(2) != "A") {
+    return false;
+  }
+  const auto & str_time = segments.at(1);
+  int hours_raw = std::stoi(str_time.substr(0, 2));
+
+  const auto & str_date = segments.at(9);
+  int days_raw = std::stoi(str_date.substr(0, 2));
+  int months_raw = std::stoi(str_date.substr(2, 2));
+  int years_raw = 2000 + std::stoi(str_date.substr(4, 2));
+
+  date::year_month_day date_current_ = date::year{years_raw} / months_raw / days_raw;
+  tp_hours = date::sys_days(date_current_) + std::chrono::hours(hours_raw);
+  return true;
+}
+
+bool ContinuousPacketParser::is_receiver_active(const uint8_t * position_packet_bytes)
+{
+  const auto * position_packet = reinterpret_cast<const PositionPacket *>(position_packet_bytes);
+  const char * nmea_sentence = position_packet->nmea_sentence;
+  const char * nmea_sentence_end = nmea_sentence + sizeof(position_packet->nmea_sentence);
+
+  // $GPRMC,hhmmss,A,... the status follows the second comma
+  const char * status = nmea_sentence;
+  for (size_t count_commas = 0; count_commas < 2; ++count_commas) {
+    status = static_cast<const char *>(
+      std::memchr(status, ',', static_cast<size_t>(nmea_sentence_end - status)));
+    if (status == nullptr) {
+      return false;
     }
+    ++status;
   }
+  return status < nmea_sentence_end && *status == 'A';
+}
+
+uint32_t ContinuousPacketParser::read_microseconds_toh(
+  const uint8_t * data_packet, size_t length_packet)
+{
+  static_assert(sizeof(DataPacket) == size_data_packet);
+  uint32_t microseconds_toh{0U};
+  if (length_packet == size_data_packet) {
+    std::memcpy(
+      &microseconds_toh, data_packet + offsetof(DataPacket, microseconds_toh),
+      sizeof(microseconds_toh));
+  } else if (length_packet == size_position_packet) {
+    std::memcpy(
+      &microseconds_toh, data_packet + offsetof(PositionPacket, timestamp_microseconds_since_hour),
+      sizeof(microseconds_toh));
+  }
+  return microseconds_toh;
+}
+
+uint16_t ContinuousPacketParser::read_azimuth_multiplied_by_100_deg(const uint8_t * data_packet)
+{
+  uint16_t azimuth{0U};
+  std::memcpy(
+    &azimuth,
+    data_packet + offsetof(DataPacket, data_blocks) +
+      offsetof(DataBlock, azimuth_multiplied_by_100_deg),
+    sizeof(azimuth));
+  return azimuth;
 }
 
 }  // namespace loam_mapper::points_provider::continuous_packet_parser
@@ -23,7 +23,7 @@ void FeatureExtraction::initializationValue()
 }
 
 void FeatureExtraction::laserCloudInfoHandler(
-  const Points & deskewed_cloud, utils::Utils::CloudInfo & cloudInfo)
+  const PointColumns & deskewed_cloud, utils::Utils::CloudInfo & cloudInfo)
 {
   extractedCloud = deskewed_cloud;
 
@@ -103,8 +103,8 @@ void FeatureExtraction::extractFeatures(
   cornerCloud.clear();
   surfaceCloud.clear();
 
-  Points surfaceCloudScan;
-  Points surfaceCloudScanDS;
+  PointColumns surfaceCloudScan;
+  PointColumns surfaceCloudScanDS;
 
   for (int i = 1; i < 16; i++) {
     surfaceCloudScan.clear();
@@ -137,7 +137,7 @@ void FeatureExtraction::extractFeatures(
           largestPickedNum++;
           if (largestPickedNum <= 20) {
             cloudLabel[ind] = 1;
-            cornerCloud.push_back(extractedCloud[ind]);
+            cornerCloud.push_back(extractedCloud.get_point(ind));
           } else {
             break;
           }
@@ -185,7 +185,7 @@ void FeatureExtraction::extractFeatures(
 
       for (int k = sp; k <= ep; k++) {
         if (cloudLabel[k] <= 0) {
-          surfaceCloudScan.push_back(extractedCloud[k]);
+          surfaceCloudScan.push_back(extractedCloud.get_point(k));
         }
       }
     }
@@ -193,7 +193,7 @@ void FeatureExtraction::extractFeatures(
     //    downSizeFilter.setInputCloud(surfaceCloudScan);
     //    downSizeFilter.filter(*surfaceCloudScanDS);
 
-    surfaceCloud.insert(surfaceCloud.end(), surfaceCloudScan.begin(), surfaceCloudScan.end());
+    surfaceCloud.append(surfaceCloudScan);
     surfaceCloudScanDS.clear();
   }
 }
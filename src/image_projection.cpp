@@ -41,7 +41,7 @@ void ImageProjection::odomHandler(const nav_msgs::msg::Odometry odometryMsg)
   odomQueue.push_back(odometryMsg);
 }
 
-void ImageProjection::cloudHandler(Points & laserCloudMsg)
+void ImageProjection::cloudHandler(PointColumns & laserCloudMsg)
 {
   cachePointCloud(laserCloudMsg);
 
@@ -50,7 +50,7 @@ void ImageProjection::cloudHandler(Points & laserCloudMsg)
   cloudExtraction(laserCloudMsg);
 }
 
-void ImageProjection::cachePointCloud(Points & laserCloudMsg)
+void ImageProjection::cachePointCloud(PointColumns & laserCloudMsg)
 {
   cloudQueue.push_back(laserCloudMsg);
   if (cloudQueue.size() > 2)
@@ -59,29 +59,24 @@ void ImageProjection::cachePointCloud(Points & laserCloudMsg)
   cloudQueue.pop_front();
 }
 
-void ImageProjection::projectPointCloud(Points & laserCloudMsg)
+void ImageProjection::projectPointCloud(PointColumns & laserCloudMsg)
 {
+  // Only the x, y, z, ring and horizontal_angle columns are read here
+  const float * xs = laserCloudMsg.x.data();
+  const float * ys = laserCloudMsg.y.data();
+  const float * zs = laserCloudMsg.z.data();
   int cloudSize = laserCloudMsg.size();
   for (int i = 0; i < cloudSize; ++i) {
-    Point thisPoint;
-    thisPoint.x = laserCloudMsg[i].x;
-    thisPoint.y = laserCloudMsg[i].y;
-    thisPoint.z = laserCloudMsg[i].z;
-    thisPoint.intensity = laserCloudMsg[i].intensity;
-    thisPoint.horizontal_angle = laserCloudMsg[i].horizontal_angle;
-    thisPoint.ring = laserCloudMsg[i].ring;
-
-    float range =
-      sqrt(thisPoint.x * thisPoint.x + thisPoint.y * thisPoint.y + thisPoint.z * thisPoint.z);
-
-    int rowIdn = laserCloudMsg[i].ring;
+    float range = sqrt(xs[i] * xs[i] + ys[i] * ys[i] + zs[i] * zs[i]);
+
+    int rowIdn = laserCloudMsg.ring[i];
     if (rowIdn < 0 || rowIdn >= 16) continue;
 
     //    if (rowIdn % downsampleRate != 0)
     //      continue;
 
     int columnIdn = -1;
-    float horizonAngle = laserCloudMsg[i].horizontal_angle;
+    float horizonAngle = laserCloudMsg.horizontal_angle[i];
     static float ang_res_x = 360.0 / float(1800);
     columnIdn = round((horizonAngle) / ang_res_x);
     if (columnIdn >= 1800) columnIdn -= 1800;
@@ -95,11 +90,13 @@ void ImageProjection::projectPointCloud(Points & laserCloudMsg)
 
     rangeMat.at<float>(rowIdn, columnIdn) = range;
 
+    Point thisPoint = laserCloudMsg.get_point(i);
+    thisPoint.stamp_unix_nanoseconds = 0U;
     fullCloud.push_back(thisPoint);
   }
 }
 
-void ImageProjection::cloudExtraction(Points & laserCloudMsg)
+void ImageProjection::cloudExtraction(PointColumns & laserCloudMsg)
 {
   int count = 0;
   // extract segmented cloud for lidar odometry
@@ -113,7 +110,7 @@ void ImageProjection::cloudExtraction(Points & laserCloudMsg)
         // save range info
         cloudInfo.point_range[count] = rangeMat.at<float>(i, j);
         // save extracted cloud
-        extractedCloud.push_back(laserCloudMsg[j + i * 1800]);
+        extractedCloud.push_back(laserCloudMsg.get_point(j + i * 1800));
         // size of extracted cloud
         ++count;
       }
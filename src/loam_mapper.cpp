@@ -3,7 +3,6 @@
 
 #include "loam_mapper/Occtree.h"
 
-#include <Eigen/Geometry>
 #include <loam_mapper/point_types.hpp>
 #include <loam_mapper/utils.hpp>
 #include <point_cloud_msg_wrapper/point_cloud_msg_wrapper.hpp>
@@ -14,16 +13,34 @@
 #include <pcl/io/pcd_io.h>
 #include <pcl_conversions/pcl_conversions.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <execution>
+#include <limits>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace
 {
 const std::uint32_t QOS_HISTORY_DEPTH = 10;
+
+// Seconds to nanoseconds, saturating at the uint64 range, which can't hold the product of huge
+// or negative parameters.
+std::uint64_t get_nanoseconds_saturated(double seconds)
+{
+  const double nanoseconds = seconds * 1e9;
+  if (!(nanoseconds > 0.0)) {
+    return 0U;
+  }
+  // 2^64, the first double past the uint64 range
+  if (nanoseconds >= 18446744073709551616.0) {
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+  return static_cast<std::uint64_t>(nanoseconds);
 }
+}  // namespace
 
 namespace loam_mapper
 {
@@ -41,6 +58,21 @@ LoamMapper::LoamMapper() : Node("loam_mapper")
   this->declare_parameter("enable_ned2enu", true);
   this->declare_parameter("voxel_resolution", 0.4);
   this->declare_parameter("save_pcd", true);
+  this->declare_parameter("enable_streaming", true);
+  this->declare_parameter("count_threads_decode", 1);
+  this->declare_parameter("prefetch_size_mb", 64);
+  this->declare_parameter("lidar_ip", "");
+  this->declare_parameter("lidar_port_data", 2368);
+  this->declare_parameter("lidar_port_position", 8308);
+  this->declare_parameter("dual_return_policy", "both");
+  this->declare_parameter("calibration_path", "");
+  this->declare_parameter("skip_broken_scans", false);
+  this->declare_parameter("scan_cut_azimuth", 90.0);
+  this->declare_parameter("emit_partial_scan_last", false);
+  this->declare_parameter("sensor_names", std::vector<std::string>{});
+  this->declare_parameter("time_window_start", 0.0);
+  this->declare_parameter("time_window_end", 0.0);
+  this->declare_parameter("enable_trajectory_time_window", true);
 
   pcap_dir_path_ = this->get_parameter("pcap_dir_path").as_string();
   pose_txt_path_ = this->get_parameter("pose_txt_path").as_string();
@@ -54,6 +86,21 @@ LoamMapper::LoamMapper() : Node("loam_mapper")
   enable_ned2enu_ = this->get_parameter("enable_ned2enu").as_bool();
   voxel_resolution_ = this->get_parameter("voxel_resolution").as_double();
   save_pcd_ = this->get_parameter("save_pcd").as_bool();
+  enable_streaming_ = this->get_parameter("enable_streaming").as_bool();
+  count_threads_decode_ = this->get_parameter("count_threads_decode").as_int();
+  prefetch_size_mb_ = this->get_parameter("prefetch_size_mb").as_int();
+  lidar_ip_ = this->get_parameter("lidar_ip").as_string();
+  lidar_port_data_ = this->get_parameter("lidar_port_data").as_int();
+  lidar_port_position_ = this->get_parameter("lidar_port_position").as_int();
+  dual_return_policy_ = this->get_parameter("dual_return_policy").as_string();
+  calibration_path_ = this->get_parameter("calibration_path").as_string();
+  skip_broken_scans_ = this->get_parameter("skip_broken_scans").as_bool();
+  scan_cut_azimuth_ = this->get_parameter("scan_cut_azimuth").as_double();
+  emit_partial_scan_last_ = this->get_parameter("emit_partial_scan_last").as_bool();
+  sensor_names_ = this->get_parameter("sensor_names").as_string_array();
+  time_window_start_ = this->get_parameter("time_window_start").as_double();
+  time_window_end_ = this->get_parameter("time_window_end").as_double();
+  enable_trajectory_time_window_ = this->get_parameter("enable_trajectory_time_window").as_bool();
 
   pub_ptr_basic_cloud_current_ = this->create_publisher<PointCloud2>("basic_cloud_current", 10);
   pub_ptr_corner_cloud_current_ = this->create_publisher<PointCloud2>("corner_cloud_current", 10);
@@ -69,192 +116,258 @@ LoamMapper::LoamMapper() : Node("loam_mapper")
 
   points_provider = std::make_shared<points_provider::PointsProvider>(std::string(
     "/home/ataparlar/data/task_spesific/loam_based_localization/mapping/pcap_and_poses/pcaps/"));
+  points_provider->size_bytes_prefetch =
+    static_cast<size_t>(std::max<int64_t>(prefetch_size_mb_, 0)) * 1024UL * 1024UL;
+  points_provider->packet_filter.port_data = static_cast<uint16_t>(lidar_port_data_);
+  points_provider->packet_filter.port_position = static_cast<uint16_t>(lidar_port_position_);
+  points_provider->packet_filter.address_source =
+    points_provider::packet_filter::PacketFilter::parse_address(lidar_ip_);
+  points_provider->dual_return_policy =
+    points_provider::continuous_packet_parser::ContinuousPacketParser::parse_dual_return_policy(
+      dual_return_policy_);
+  points_provider->angle_deg_cut = static_cast<float>(scan_cut_azimuth_);
+  points_provider->is_emitting_partial_scan_last = emit_partial_scan_last_;
+  if (!calibration_path_.empty()) {
+    points_provider->calibration =
+      points_provider::velodyne_calibration::Calibration::load(calibration_path_);
+  }
+  transform_chains_ = {transform_provider::transform_chain::TransformChain(
+    imu2lidar_roll_, imu2lidar_pitch_, imu2lidar_yaw_, enable_ned2enu_)};
+
+  // Every sensor sharing the capture has its own packet filter and extrinsic, declared as
+  // sensors.<name>.<param> and defaulting to the single sensor parameters.
+  std::vector<points_provider::packet_filter::PacketFilter> packet_filters_sensors;
+  if (!sensor_names_.empty()) {
+    transform_chains_.clear();
+  }
+  for (const auto & sensor_name : sensor_names_) {
+    const std::string prefix = "sensors." + sensor_name + ".";
+    this->declare_parameter(prefix + "lidar_ip", lidar_ip_);
+    this->declare_parameter(prefix + "lidar_port_data", lidar_port_data_);
+    this->declare_parameter(prefix + "lidar_port_position", lidar_port_position_);
+    this->declare_parameter(prefix + "imu2lidar_roll", imu2lidar_roll_);
+    this->declare_parameter(prefix + "imu2lidar_pitch", imu2lidar_pitch_);
+    this->declare_parameter(prefix + "imu2lidar_yaw", imu2lidar_yaw_);
+
+    points_provider::packet_filter::PacketFilter packet_filter;
+    packet_filter.port_data =
+      static_cast<uint16_t>(this->get_parameter(prefix + "lidar_port_data").as_int());
+    packet_filter.port_position =
+      static_cast<uint16_t>(this->get_parameter(prefix + "lidar_port_position").as_int());
+    packet_filter.address_source = points_provider::packet_filter::PacketFilter::parse_address(
+      this->get_parameter(prefix + "lidar_ip").as_string());
+    packet_filters_sensors.push_back(packet_filter);
+    transform_chains_.emplace_back(
+      this->get_parameter(prefix + "imu2lidar_roll").as_double(),
+      this->get_parameter(prefix + "imu2lidar_pitch").as_double(),
+      this->get_parameter(prefix + "imu2lidar_yaw").as_double(), enable_ned2enu_);
+  }
   points_provider->process();
 
   image_projection = std::make_shared<image_projection::ImageProjection>();
   feature_extraction = std::make_shared<feature_extraction::FeatureExtraction>();
 
-  std::function<void(const Points &)> callback =
+  occ_cloud_ = std::make_shared<Occtree>(voxel_resolution_);
+  occ_cloud_corner_ = std::make_shared<Occtree>(voxel_resolution_);
+  occ_cloud_surface_ = std::make_shared<Occtree>(voxel_resolution_);
+
+  // In streaming mode every scan goes through the whole pipeline inside this callback and is
+  // dropped afterwards, otherwise all scans are collected first and processed in process().
+  std::function<void(ScanLease)> callback =
     std::bind(&LoamMapper::callback_cloud_surround_out, this, std::placeholders::_1);
-  points_provider->process_pcaps_into_clouds(callback, 0, 2);
+  // Points outside the trajectory can't be transformed, so they are not even decoded.
+  uint64_t stamp_window_start = 0U;
+  uint64_t stamp_window_end = std::numeric_limits<uint64_t>::max();
+  if (enable_trajectory_time_window_) {
+    stamp_window_start = transform_provider->get_stamp_unix_nanoseconds_first();
+    stamp_window_end = transform_provider->get_stamp_unix_nanoseconds_last();
+  }
+  const bool has_explicit_time_window = time_window_start_ != 0.0 || time_window_end_ != 0.0;
+  if (time_window_start_ != 0.0) {
+    stamp_window_start =
+      std::max(stamp_window_start, get_nanoseconds_saturated(time_window_start_));
+  }
+  if (time_window_end_ != 0.0) {
+    stamp_window_end = std::min(stamp_window_end, get_nanoseconds_saturated(time_window_end_));
+  }
+  if (enable_trajectory_time_window_ || has_explicit_time_window) {
+    points_provider->set_time_window(stamp_window_start, stamp_window_end);
+  }
+
+  if (!sensor_names_.empty()) {
+    const std::function<void(ScanLease, size_t)> callback_multi_sensor = std::bind(
+      &LoamMapper::callback_cloud_surround_out_of_sensor, this, std::placeholders::_1,
+      std::placeholders::_2);
+    points_provider->process_pcaps_into_clouds_multi_sensor(
+      callback_multi_sensor, 0, points_provider->get_count_pcaps(), packet_filters_sensors);
+  } else if (has_explicit_time_window) {
+    points_provider->process_pcaps_into_clouds_in_time_range(
+      callback, 0, points_provider->get_count_pcaps(), stamp_window_start, stamp_window_end);
+  } else if (count_threads_decode_ == 1) {
+    points_provider->process_pcaps_into_clouds(callback, 0, points_provider->get_count_pcaps());
+  } else {
+    points_provider->process_pcaps_into_clouds_parallel(
+      callback, 0, points_provider->get_count_pcaps(),
+      static_cast<size_t>(std::max<int64_t>(count_threads_decode_, 0)));
+  }
   std::cout << "process_pcaps_into_clouds done" << std::endl;
+  std::cout << "scans: " << count_scans_ << ", " << count_scans_broken_ << " broken"
+            << (skip_broken_scans_ ? " and skipped" : "") << ", "
+            << telemetry_scans_.count_data_packets_dropped << " data packets dropped, "
+            << telemetry_scans_.count_azimuth_jumps << " azimuth jumps, "
+            << telemetry_scans_.count_toh_rollovers << " ToH rollovers, "
+            << telemetry_scans_.count_position_packets_inactive
+            << " position packets with inactive receiver" << std::endl;
 
   process();
 }
 
 void LoamMapper::process()
 {
-  auto thing_to_cloud =
-    [](const points_provider::PointsProvider::Points & points_bad, const std::string & frame_id) {
-      using CloudModifier = point_cloud_msg_wrapper::PointCloud2Modifier<point_types::PointXYZI>;
-      PointCloud2::SharedPtr cloud_ptr_current = std::make_shared<PointCloud2>();
-      CloudModifier cloud_modifier_current(*cloud_ptr_current, frame_id);
-      cloud_modifier_current.resize(points_bad.size());
-      std::transform(
-        std::execution::par, points_bad.cbegin(), points_bad.cend(), cloud_modifier_current.begin(),
-        [](const points_provider::PointsProvider::Point & point_bad) {
-          return point_types::PointXYZI{
-            point_bad.x, point_bad.y, point_bad.z, static_cast<float>(point_bad.intensity)};
-        });
-      return cloud_ptr_current;
-    };
-
-  nav_msgs::msg::Path path_;
-  path_.header.frame_id = "map";
-  path_.poses.resize(transform_provider->poses_.size());
-
-  points_provider::PointsProvider::Points cloud_all;
-  points_provider::PointsProvider::Points cloud_all_corner_;
-  points_provider::PointsProvider::Points cloud_all_surface_;
-
-  for (auto & cloud : clouds) {
-    //    utils::Utils::CloudInfo cloudInfo;
-
-    points_provider::PointsProvider::Points cloud_trans;
-    cloud_trans.resize(cloud.size());
-
-    std::transform(
-      std::execution::par, cloud.cbegin(), cloud.cend(), cloud_trans.begin(),
-      [this, &path_](const points_provider::PointsProvider::Point & point) {
-        points_provider::PointsProvider::Point point_trans;
-        loam_mapper::transform_provider::TransformProvider::Pose pose =
-          this->transform_provider->get_pose_at(point.stamp_unix_seconds, point.stamp_nanoseconds);
-
-        geometry_msgs::msg::PoseStamped pose_stamped;
-        pose_stamped.pose = pose.pose_with_covariance.pose;
-        pose_stamped.header.frame_id = path_.header.frame_id;
-
-        const auto & pose_ori = pose.pose_with_covariance.pose.orientation;
-        Eigen::Quaterniond quat(pose_ori.w, pose_ori.x, pose_ori.y, pose_ori.z);
-
-        Eigen::Affine3d affine_sensor2map(Eigen::Affine3d::Identity());
-
-        Eigen::Affine3d affine_imu2lidar(Eigen::Affine3d::Identity());
-        affine_imu2lidar.matrix().topLeftCorner<3, 3>() =
-          Eigen::AngleAxisd(utils::Utils::deg_to_rad(imu2lidar_yaw_), Eigen::Vector3d::UnitZ())
-            .toRotationMatrix() *
-          Eigen::AngleAxisd(utils::Utils::deg_to_rad(imu2lidar_pitch_), Eigen::Vector3d::UnitY())
-            .toRotationMatrix() *
-          Eigen::AngleAxisd(utils::Utils::deg_to_rad(imu2lidar_roll_), Eigen::Vector3d::UnitX())
-            .toRotationMatrix();
-
-        if (enable_ned2enu_) {
-          Eigen::Affine3d ned2enu(Eigen::Affine3d::Identity());
-          ned2enu.matrix().topLeftCorner<3, 3>() =
-            Eigen::AngleAxisd(utils::Utils::deg_to_rad(-90.0), Eigen::Vector3d::UnitZ())
-              .toRotationMatrix() *
-            Eigen::AngleAxisd(utils::Utils::deg_to_rad(0.0), Eigen::Vector3d::UnitY())
-              .toRotationMatrix() *
-            Eigen::AngleAxisd(utils::Utils::deg_to_rad(180.0), Eigen::Vector3d::UnitX())
-              .toRotationMatrix();
-
-          Eigen::Affine3d affine_imu2lidar_enu(Eigen::Affine3d::Identity());
-          affine_imu2lidar_enu = affine_imu2lidar.matrix() * ned2enu.matrix();
-
-          affine_sensor2map.matrix().topLeftCorner<3, 3>() =
-            quat.toRotationMatrix() * affine_imu2lidar_enu.rotation();
-
-        } else {
-          affine_sensor2map.matrix().topLeftCorner<3, 3>() =
-            quat.toRotationMatrix() * affine_imu2lidar.rotation();
-        }
-
-        auto & pose_pos = pose_stamped.pose.position;
-        affine_sensor2map.matrix().topRightCorner<3, 1>() << pose_pos.x, pose_pos.y, pose_pos.z;
-
-        Eigen::Vector4d vec_point_in(point.x, point.y, point.z, 1.0);
-        Eigen::Vector4d vec_point_trans = affine_sensor2map.matrix() * vec_point_in;
-
-        point_trans.x = static_cast<float>(vec_point_trans(0));
-        point_trans.y = static_cast<float>(vec_point_trans(1));
-        point_trans.z = static_cast<float>(vec_point_trans(2));
-        point_trans.ring = point.ring;
-        point_trans.horizontal_angle = point.horizontal_angle;
-        point_trans.intensity = point.intensity;
-
-        return point_trans;
-      });
-
-    //    image_projection->setLaserCloudIn(cloud_trans);
-    image_projection->cloudHandler(cloud_trans);
-    sensor_msgs::msg::Image image = createImageFromRangeMat(image_projection->rangeMat);
-
-    feature_extraction->laserCloudInfoHandler(cloud_trans, image_projection->cloudInfo);
-
-    auto corner_cloud_ptr_current = thing_to_cloud(feature_extraction->cornerCloud, "map");
-    pub_ptr_corner_cloud_current_->publish(*corner_cloud_ptr_current);
-
-    auto surface_cloud_ptr_current = thing_to_cloud(feature_extraction->surfaceCloud, "map");
-    pub_ptr_surface_cloud_current_->publish(*surface_cloud_ptr_current);
-
-    cloud_all.insert(cloud_all.end(), cloud_trans.begin(), cloud_trans.end());
-    cloud_all_corner_.insert(
-      cloud_all_corner_.end(), feature_extraction->cornerCloud.begin(),
-      feature_extraction->cornerCloud.end());
-    cloud_all_surface_.insert(
-      cloud_all_surface_.end(), feature_extraction->surfaceCloud.begin(),
-      feature_extraction->surfaceCloud.end());
-    std::this_thread::sleep_for(std::chrono::milliseconds(180));
-    auto cloud_ptr_current = thing_to_cloud(cloud_trans, "map");
-    pub_ptr_basic_cloud_current_->publish(*cloud_ptr_current);
-    pub_ptr_image_->publish(image);
-
-    image_projection->resetParameters();
+  size_t size_bytes_clouds = 0;
+  for (const auto & cloud : clouds) {
+    size_bytes_clouds += cloud.get_size_bytes();
+  }
+  if (!clouds.empty()) {
+    std::cout << clouds.size() << " scans held in " << size_bytes_clouds / (1024UL * 1024UL)
+              << " MB" << std::endl;
   }
 
-  if (save_pcd_) {
-    Occtree occ_cloud(voxel_resolution_);
-    Occtree occ_cloud_corner(voxel_resolution_);
-    Occtree occ_cloud_surface(voxel_resolution_);
+  PointColumns cloud;
+  for (size_t i = 0; i < clouds.size(); ++i) {
+    clouds.at(i).decode(cloud);
+    process_cloud(cloud, indices_sensor_clouds_.at(i));
+  }
+  clouds.clear();
+  indices_sensor_clouds_.clear();
+
+  save_pcds();
+
+  std::cout << "LoamMapper is done." << std::endl;
+}
+
+void LoamMapper::process_cloud(const PointColumns & cloud, size_t index_sensor)
+{
+  const std::string frame_id_map = "map";
+
+  PointColumns cloud_trans;
+  cloud_trans.resize(cloud.size());
+  cloud_trans.intensity = cloud.intensity;
+  cloud_trans.ring = cloud.ring;
+  cloud_trans.horizontal_angle = cloud.horizontal_angle;
+
+  // Every point gets the pose interpolated at its own firing time.
+  transform_provider::pose_interpolation::PoseColumns poses;
+  transform_provider->get_poses_interpolated_at(
+    cloud.stamp_unix_nanoseconds.data(), cloud.size(), poses);
 
-    for (const auto & point : cloud_all) {
-      occ_cloud.addPointIfVoxelEmpty(pcl::PointXYZI(point.x, point.y, point.z, point.intensity));
+  transform_chains_.at(index_sensor).apply(cloud, poses, cloud_trans);
+
+  //    image_projection->setLaserCloudIn(cloud_trans);
+  image_projection->cloudHandler(cloud_trans);
+  sensor_msgs::msg::Image image = createImageFromRangeMat(image_projection->rangeMat);
+
+  feature_extraction->laserCloudInfoHandler(cloud_trans, image_projection->cloudInfo);
+
+  auto corner_cloud_ptr_current = points_to_cloud(feature_extraction->cornerCloud, frame_id_map);
+  pub_ptr_corner_cloud_current_->publish(*corner_cloud_ptr_current);
+
+  auto surface_cloud_ptr_current = points_to_cloud(feature_extraction->surfaceCloud, frame_id_map);
+  pub_ptr_surface_cloud_current_->publish(*surface_cloud_ptr_current);
+
+  // Voxelize right away, so only the map is kept in memory and not every scan of the drive.
+  if (save_pcd_) {
+    for (const auto point : cloud_trans.get_view()) {
+      occ_cloud_->addPointIfVoxelEmpty(
+        pcl::PointXYZI(point.x, point.y, point.z, point.intensity));
     }
-    for (const auto & point : cloud_all_corner_) {
-      occ_cloud_corner.addPointIfVoxelEmpty(
+    for (const auto point : feature_extraction->cornerCloud.get_view()) {
+      occ_cloud_corner_->addPointIfVoxelEmpty(
         pcl::PointXYZI(point.x, point.y, point.z, point.intensity));
     }
-    for (const auto & point : cloud_all_surface_) {
-      occ_cloud_surface.addPointIfVoxelEmpty(
+    for (const auto point : feature_extraction->surfaceCloud.get_view()) {
+      occ_cloud_surface_->addPointIfVoxelEmpty(
         pcl::PointXYZI(point.x, point.y, point.z, point.intensity));
     }
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(180));
+  auto cloud_ptr_current = points_to_cloud(cloud_trans, frame_id_map);
+  pub_ptr_basic_cloud_current_->publish(*cloud_ptr_current);
+  pub_ptr_image_->publish(image);
 
-    pcl::PointCloud<pcl::PointXYZI> new_cloud;
-    for (auto & point : *occ_cloud.cloud) {
-      new_cloud.push_back(point);
-    }
-    pcl::PointCloud<pcl::PointXYZI> corner_cloud_pcl;
-    for (auto & point : *occ_cloud_corner.cloud) {
-      corner_cloud_pcl.push_back(point);
-    }
-    pcl::PointCloud<pcl::PointXYZI> surface_cloud_pcl;
-    for (auto & point : *occ_cloud_surface.cloud) {
-      surface_cloud_pcl.push_back(point);
-    }
-    pcl::io::savePCDFileASCII(pcd_export_dir_ + "ytu_campus.pcd", new_cloud);
-    pcl::io::savePCDFileASCII(pcd_export_dir_ + "ytu_campus_corner.pcd", corner_cloud_pcl);
-    pcl::io::savePCDFileASCII(pcd_export_dir_ + "ytu_campus_surface.pcd", surface_cloud_pcl);
-    std::cout << "PCDs saved." << std::endl;
+  image_projection->resetParameters();
+}
+
+void LoamMapper::save_pcds()
+{
+  if (!save_pcd_) {
+    return;
+  }
+  pcl::PointCloud<pcl::PointXYZI> new_cloud;
+  for (auto & point : *occ_cloud_->cloud) {
+    new_cloud.push_back(point);
+  }
+  pcl::PointCloud<pcl::PointXYZI> corner_cloud_pcl;
+  for (auto & point : *occ_cloud_corner_->cloud) {
+    corner_cloud_pcl.push_back(point);
   }
+  pcl::PointCloud<pcl::PointXYZI> surface_cloud_pcl;
+  for (auto & point : *occ_cloud_surface_->cloud) {
+    surface_cloud_pcl.push_back(point);
+  }
+  pcl::io::savePCDFileASCII(pcd_export_dir_ + "ytu_campus.pcd", new_cloud);
+  pcl::io::savePCDFileASCII(pcd_export_dir_ + "ytu_campus_corner.pcd", corner_cloud_pcl);
+  pcl::io::savePCDFileASCII(pcd_export_dir_ + "ytu_campus_surface.pcd", surface_cloud_pcl);
+  std::cout << "PCDs saved." << std::endl;
+}
 
-  std::cout << "LoamMapper is done." << std::endl;
+void LoamMapper::callback_cloud_surround_out(LoamMapper::ScanLease scan_surround)
+{
+  callback_cloud_surround_out_of_sensor(std::move(scan_surround), 0);
 }
 
-void LoamMapper::callback_cloud_surround_out(const LoamMapper::Points & points_surround)
+void LoamMapper::callback_cloud_surround_out_of_sensor(
+  LoamMapper::ScanLease scan_surround, size_t index_sensor)
 {
-  clouds.push_back(points_surround);
+  const auto & telemetry = scan_surround.get_telemetry();
+  telemetry_scans_.merge(telemetry);
+  count_scans_++;
+  if (!telemetry.is_intact()) {
+    count_scans_broken_++;
+    if (skip_broken_scans_) {
+      return;
+    }
+  }
+  if (enable_streaming_) {
+    // The scan buffer goes back to the pool as soon as the scan is processed.
+    process_cloud(*scan_surround, index_sensor);
+    return;
+  }
+  // A scan lasting seconds has lost packets, whether or not its telemetry caught the gap.
+  if (!point_types::CompactScan::is_encodable(*scan_surround)) {
+    if (telemetry.is_intact()) {
+      count_scans_broken_++;
+    }
+    std::cout << "skipping a scan of " << scan_surround->size()
+              << " points that lasts too long to be held compactly" << std::endl;
+    return;
+  }
+  // The scan buffer goes back to the pool once the scan is encoded.
+  clouds.push_back(point_types::CompactScan::encode(*scan_surround));
+  indices_sensor_clouds_.push_back(index_sensor);
 }
 
 sensor_msgs::msg::PointCloud2::SharedPtr LoamMapper::points_to_cloud(
-  const LoamMapper::Points & points_bad, const std::string & frame_id)
+  const LoamMapper::PointColumns & points_bad, const std::string & frame_id)
 {
+  const auto view_points_bad = points_bad.get_view();
   using CloudModifier = point_cloud_msg_wrapper::PointCloud2Modifier<point_types::PointXYZI>;
   PointCloud2::SharedPtr cloud_ptr_current = std::make_shared<PointCloud2>();
   CloudModifier cloud_modifier_current(*cloud_ptr_current, frame_id);
   cloud_modifier_current.resize(points_bad.size());
   std::transform(
-    std::execution::par, points_bad.cbegin(), points_bad.cend(), cloud_modifier_current.begin(),
-    [](const points_provider::PointsProvider::Point & point_bad) {
+    std::execution::par, view_points_bad.begin(), view_points_bad.end(),
+    cloud_modifier_current.begin(), [](const points_provider::PointsProvider::Point & point_bad) {
       return point_types::PointXYZI{
         point_bad.x, point_bad.y, point_bad.z, static_cast<float>(point_bad.intensity)};
     });
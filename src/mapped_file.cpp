@@ -0,0 +1,47 @@
+#include "loam_mapper/mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace loam_mapper::mapped_file
+{
+MappedFile::MappedFile(const fs::path & path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+      "Cannot open " + path.string() + " for reading: " + std::strerror(errno));
+  }
+  struct stat stat_file{};
+  if (::fstat(fd, &stat_file) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot stat " + path.string() + ": " + std::strerror(errno));
+  }
+  size_ = static_cast<std::size_t>(stat_file.st_size);
+  if (size_ == 0) {
+    ::close(fd);
+    throw std::runtime_error(path.string() + " is empty.");
+  }
+  void * mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Cannot mmap " + path.string() + ": " + std::strerror(errno));
+  }
+  data_ = static_cast<const char *>(mapping);
+}
+
+MappedFile::~MappedFile() { ::munmap(const_cast<char *>(data_), size_); }
+
+void MappedFile::advise_will_need() const
+{
+  ::madvise(const_cast<char *>(data_), size_, MADV_WILLNEED);
+}
+}  // namespace loam_mapper::mapped_file
@@ -0,0 +1,158 @@
+#include "loam_mapper/mapped_pcap_reader.hpp"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace loam_mapper::points_provider::mapped_pcap_reader
+{
+namespace
+{
+constexpr std::uint32_t magic_microseconds = 0xa1b2c3d4U;
+constexpr std::uint32_t magic_microseconds_swapped = 0xd4c3b2a1U;
+constexpr std::uint32_t magic_nanoseconds = 0xa1b23c4dU;
+constexpr std::uint32_t magic_nanoseconds_swapped = 0x4d3cb2a1U;
+constexpr std::uint32_t link_type_ethernet = 1U;
+
+// Number of consecutive records that must chain up before a resync candidate is accepted.
+constexpr int count_records_to_validate = 8;
+// Records of a capture are expected to be within this many seconds of its first record.
+constexpr std::uint32_t seconds_max_capture_span = 7U * 24U * 3600U;
+}  // namespace
+
+MappedPcapReader::MappedPcapReader(const fs::path & path_pcap)
+: path_pcap_{path_pcap},
+  file_{path_pcap},
+  data_{reinterpret_cast<const std::uint8_t *>(file_.data())},
+  size_{file_.size()},
+  offset_{0U},
+  is_byte_swapped_{false},
+  is_nanosecond_resolution_{false},
+  snap_length_{0U},
+  stamp_seconds_first_{0U}
+{
+  if (size_ < size_global_header) {
+    throw std::runtime_error(path_pcap_.string() + " is too small to be a pcap file.");
+  }
+  if (::madvise(const_cast<std::uint8_t *>(data_), size_, MADV_SEQUENTIAL) != 0) {
+    std::cerr << "madvise(MADV_SEQUENTIAL) failed for " << path_pcap_ << std::endl;
+  }
+
+  std::uint32_t magic;
+  std::memcpy(&magic, data_, sizeof(magic));
+  switch (magic) {
+    case magic_microseconds:
+      break;
+    case magic_microseconds_swapped:
+      is_byte_swapped_ = true;
+      break;
+    case magic_nanoseconds:
+      is_nanosecond_resolution_ = true;
+      break;
+    case magic_nanoseconds_swapped:
+      is_byte_swapped_ = true;
+      is_nanosecond_resolution_ = true;
+      break;
+    default:
+      throw std::runtime_error(path_pcap_.string() + " is not a classic pcap file.");
+  }
+
+  // The parser expects Ethernet framed UDP packets (42 bytes of headers).
+  const std::uint32_t link_type = read_u32(20);
+  if (link_type != link_type_ethernet) {
+    throw std::runtime_error(
+      path_pcap_.string() + " has link type " + std::to_string(link_type) +
+      ", only Ethernet captures are supported.");
+  }
+
+  snap_length_ = read_u32(16);
+  if (snap_length_ == 0U) {
+    // Some writers leave the snapshot length unset, fall back to the libpcap maximum.
+    snap_length_ = 262144U;
+  }
+  offset_ = size_global_header;
+  if (size_ - offset_ >= size_record_header) {
+    stamp_seconds_first_ = read_u32(offset_);
+  }
+}
+
+bool MappedPcapReader::get_next_packet(PacketView & packet)
+{
+  return get_packet_at(offset_, packet);
+}
+
+bool MappedPcapReader::get_packet_at(std::size_t & offset, PacketView & packet) const
+{
+  if (offset >= size_ || size_ - offset < size_record_header) {
+    return false;
+  }
+  const std::uint32_t length_captured = read_u32(offset + 8);
+  if (size_ - offset - size_record_header < length_captured) {
+    std::cerr << "Truncated pcap record at offset " << offset << " in " << path_pcap_
+              << std::endl;
+    offset = size_;
+    return false;
+  }
+
+  packet.data = data_ + offset + size_record_header;
+  packet.length_captured = length_captured;
+  packet.length_original = read_u32(offset + 12);
+  packet.stamp_seconds = read_u32(offset);
+  packet.stamp_microseconds = read_u32(offset + 4);
+  if (is_nanosecond_resolution_) {
+    packet.stamp_microseconds /= 1000U;
+  }
+  packet.offset_record = offset;
+
+  offset += size_record_header + length_captured;
+  return true;
+}
+
+std::size_t MappedPcapReader::find_record_boundary(std::size_t offset_hint) const
+{
+  for (std::size_t offset = std::max(offset_hint, size_global_header); offset < size_; ++offset) {
+    std::size_t offset_chain = offset;
+    int count_valid = 0;
+    while (count_valid < count_records_to_validate && offset_chain < size_ &&
+           is_plausible_record_header(offset_chain)) {
+      offset_chain += size_record_header + read_u32(offset_chain + 8);
+      ++count_valid;
+    }
+    // A chain that ends exactly at the end of the file is also fine.
+    if (count_valid == count_records_to_validate || offset_chain == size_) {
+      return offset;
+    }
+  }
+  return size_;
+}
+
+bool MappedPcapReader::is_plausible_record_header(std::size_t offset) const
+{
+  if (size_ - offset < size_record_header) {
+    return false;
+  }
+  const std::uint32_t stamp_seconds = read_u32(offset);
+  const std::uint32_t stamp_subseconds = read_u32(offset + 4);
+  const std::uint32_t length_captured = read_u32(offset + 8);
+  const std::uint32_t length_original = read_u32(offset + 12);
+  const std::uint32_t subseconds_per_second = is_nanosecond_resolution_ ? 1000000000U : 1000000U;
+
+  return stamp_subseconds < subseconds_per_second && length_captured > 0U &&
+         length_captured <= length_original && length_captured <= snap_length_ &&
+         size_ - offset - size_record_header >= length_captured &&
+         stamp_seconds + seconds_max_capture_span >= stamp_seconds_first_ &&
+         stamp_seconds <= stamp_seconds_first_ + seconds_max_capture_span;
+}
+
+std::uint32_t MappedPcapReader::read_u32(std::size_t offset) const
+{
+  std::uint32_t value;
+  std::memcpy(&value, data_ + offset, sizeof(value));
+  return is_byte_swapped_ ? __builtin_bswap32(value) : value;
+}
+
+}  // namespace loam_mapper::points_provider::mapped_pcap_reader
@@ -0,0 +1,20 @@
+#include "loam_mapper/packet_filter.hpp"
+
+#include <arpa/inet.h>
+
+#include <stdexcept>
+
+namespace loam_mapper::points_provider::packet_filter
+{
+std::uint32_t PacketFilter::parse_address(const std::string & address)
+{
+  if (address.empty()) {
+    return 0U;
+  }
+  in_addr address_network{};
+  if (inet_pton(AF_INET, address.c_str(), &address_network) != 1) {
+    throw std::invalid_argument(address + " is not a valid IPv4 address.");
+  }
+  return ntohl(address_network.s_addr);
+}
+}  // namespace loam_mapper::points_provider::packet_filter
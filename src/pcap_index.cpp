@@ -0,0 +1,188 @@
+#include "loam_mapper/pcap_index.hpp"
+
+#include "loam_mapper/continuous_packet_parser.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace loam_mapper::points_provider::pcap_index
+{
+namespace
+{
+using continuous_packet_parser::ContinuousPacketParser;
+
+constexpr char magic_index[8] = {'L', 'M', 'P', 'C', 'I', 'D', 'X', '\0'};
+constexpr std::uint32_t version_index = 2U;
+
+struct IndexHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t stride_data_packets;
+  std::uint64_t size_pcap;
+  std::int64_t time_last_write_pcap;
+  std::uint16_t port_data;
+  std::uint16_t port_position;
+  std::uint32_t address_source;
+  std::uint64_t count_entries;
+} __attribute__((packed));
+}  // namespace
+
+PcapIndex PcapIndex::load_or_build(
+  const fs::path & path_pcap,
+  const mapped_pcap_reader::MappedPcapReader & reader,
+  std::uint32_t stride_data_packets,
+  const packet_filter::PacketFilter & packet_filter)
+{
+  const fs::path path_index = get_path_index(path_pcap);
+  PcapIndex index;
+  if (
+    load(path_index, index) && index.stride_data_packets_ == stride_data_packets &&
+    index.packet_filter_ == packet_filter && index.size_pcap_ == fs::file_size(path_pcap) &&
+    index.time_last_write_pcap_ == fs::last_write_time(path_pcap)) {
+    return index;
+  }
+
+  std::cout << "building index: " << path_index << std::endl;
+  index = build(reader, stride_data_packets, packet_filter);
+  index.time_last_write_pcap_ = fs::last_write_time(path_pcap);
+  try {
+    index.save(path_index);
+  } catch (const std::exception & ex) {
+    // A read only capture folder shouldn't prevent using the index for this run.
+    std::cerr << "Cannot save index: " << ex.what() << std::endl;
+  }
+  return index;
+}
+
+PcapIndex PcapIndex::build(
+  const mapped_pcap_reader::MappedPcapReader & reader,
+  std::uint32_t stride_data_packets,
+  const packet_filter::PacketFilter & packet_filter)
+{
+  if (stride_data_packets == 0U) {
+    throw std::invalid_argument("stride_data_packets should be at least 1.");
+  }
+  PcapIndex index;
+  index.stride_data_packets_ = stride_data_packets;
+  index.size_pcap_ = reader.size();
+  index.packet_filter_ = packet_filter;
+
+  std::uint32_t hours_since_epoch = 0U;
+  std::uint32_t microseconds_toh_last = 0U;
+  std::uint64_t count_data_packets = 0U;
+
+  std::size_t offset = mapped_pcap_reader::MappedPcapReader::size_global_header;
+  mapped_pcap_reader::PacketView packet;
+  while (reader.get_packet_at(offset, packet)) {
+    IndexEntry entry;
+    entry.offset_record = packet.offset_record;
+    entry.stamp_pcap_seconds = packet.stamp_seconds;
+    entry.stamp_pcap_microseconds = packet.stamp_microseconds;
+
+    switch (packet_filter.classify(packet.data, packet.length_captured)) {
+      case packet_filter::PacketFilter::Kind::Position: {
+        entry.type = IndexEntry::Type::PositionInvalid;
+        entry.microseconds_toh =
+          ContinuousPacketParser::read_microseconds_toh(packet.data, packet.length_captured);
+        try {
+          date::sys_time<std::chrono::hours> tp_hours;
+          if (ContinuousPacketParser::parse_hours_since_epoch(packet.data, tp_hours)) {
+            entry.type = IndexEntry::Type::Position;
+            hours_since_epoch = static_cast<std::uint32_t>(tp_hours.time_since_epoch().count());
+            microseconds_toh_last = entry.microseconds_toh;
+          }
+        } catch (const std::exception &) {
+          // Malformed NMEA sentences are kept as invalid position entries.
+        }
+        entry.hours_since_epoch = hours_since_epoch;
+        index.entries_.push_back(entry);
+        break;
+      }
+      case packet_filter::PacketFilter::Kind::Data: {
+        entry.microseconds_toh =
+          ContinuousPacketParser::read_microseconds_toh(packet.data, packet.length_captured);
+        // Same ToH rollover handling as the parser
+        if (hours_since_epoch != 0U && entry.microseconds_toh < microseconds_toh_last) {
+          hours_since_epoch++;
+        }
+        microseconds_toh_last = entry.microseconds_toh;
+        if (count_data_packets++ % stride_data_packets != 0U) {
+          break;
+        }
+        entry.type = IndexEntry::Type::Data;
+        entry.hours_since_epoch = hours_since_epoch;
+        entry.azimuth_multiplied_by_100_deg =
+          ContinuousPacketParser::read_azimuth_multiplied_by_100_deg(packet.data);
+        index.entries_.push_back(entry);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  return index;
+}
+
+void PcapIndex::save(const fs::path & path_index) const
+{
+  std::ofstream file(path_index.string(), std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path_index.string() + " for writing.");
+  }
+  IndexHeader header{};
+  std::memcpy(header.magic, magic_index, sizeof(magic_index));
+  header.version = version_index;
+  header.stride_data_packets = stride_data_packets_;
+  header.size_pcap = size_pcap_;
+  header.time_last_write_pcap = time_last_write_pcap_;
+  header.port_data = packet_filter_.port_data;
+  header.port_position = packet_filter_.port_position;
+  header.address_source = packet_filter_.address_source;
+  header.count_entries = entries_.size();
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(
+    reinterpret_cast<const char *>(entries_.data()),
+    static_cast<std::streamsize>(entries_.size() * sizeof(IndexEntry)));
+  if (!file) {
+    throw std::runtime_error("Cannot write " + path_index.string());
+  }
+}
+
+bool PcapIndex::load(const fs::path & path_index, PcapIndex & index)
+{
+  std::ifstream file(path_index.string(), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  IndexHeader header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (
+    !file || std::memcmp(header.magic, magic_index, sizeof(magic_index)) != 0 ||
+    header.version != version_index) {
+    return false;
+  }
+  index.stride_data_packets_ = header.stride_data_packets;
+  index.size_pcap_ = header.size_pcap;
+  index.time_last_write_pcap_ = header.time_last_write_pcap;
+  index.packet_filter_.port_data = header.port_data;
+  index.packet_filter_.port_position = header.port_position;
+  index.packet_filter_.address_source = header.address_source;
+  index.entries_.resize(header.count_entries);
+  file.read(
+    reinterpret_cast<char *>(index.entries_.data()),
+    static_cast<std::streamsize>(index.entries_.size() * sizeof(IndexEntry)));
+  return static_cast<bool>(file);
+}
+
+fs::path PcapIndex::get_path_index(const fs::path & path_pcap)
+{
+  return fs::path(path_pcap.string() + ".idx");
+}
+
+}  // namespace loam_mapper::points_provider::pcap_index
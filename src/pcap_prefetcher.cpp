@@ -0,0 +1,69 @@
+#include "loam_mapper/pcap_prefetcher.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace loam_mapper::points_provider::pcap_prefetcher
+{
+PcapPrefetcher::PcapPrefetcher(std::size_t size_bytes_prefetch)
+: size_bytes_prefetch_{size_bytes_prefetch}
+{
+}
+
+PcapPrefetcher::~PcapPrefetcher()
+{
+  if (future_pending_.valid()) {
+    future_pending_.wait();
+  }
+}
+
+void PcapPrefetcher::prefetch(const fs::path & path_pcap)
+{
+  if (size_bytes_prefetch_ == 0U) {
+    return;
+  }
+  if (future_pending_.valid()) {
+    future_pending_.wait();
+  }
+  path_pending_ = path_pcap;
+  future_pending_ =
+    std::async(std::launch::async, &PcapPrefetcher::warm, path_pcap, size_bytes_prefetch_);
+}
+
+double PcapPrefetcher::wait(const fs::path & path_pcap)
+{
+  if (!future_pending_.valid() || path_pending_ != path_pcap) {
+    return 0.0;
+  }
+  const auto time_start = std::chrono::steady_clock::now();
+  future_pending_.get();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start)
+    .count();
+}
+
+void PcapPrefetcher::warm(const fs::path & path_pcap, std::size_t size_bytes)
+{
+  // Best effort, the reader reports the errors when it opens the file.
+  const int fd = ::open(path_pcap.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  ::posix_fadvise(fd, 0, static_cast<off_t>(size_bytes), POSIX_FADV_WILLNEED);
+  // Network file systems may ignore the advice, reading the pages is what brings them in.
+  std::vector<char> buffer(1024UL * 1024UL);
+  std::size_t offset = 0U;
+  while (offset < size_bytes) {
+    const ssize_t count_read = ::pread(
+      fd, buffer.data(), std::min(buffer.size(), size_bytes - offset), static_cast<off_t>(offset));
+    if (count_read <= 0) {
+      break;
+    }
+    offset += static_cast<std::size_t>(count_read);
+  }
+  ::close(fd);
+}
+}  // namespace loam_mapper::points_provider::pcap_prefetcher
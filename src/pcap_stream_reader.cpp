@@ -0,0 +1,546 @@
+#include "loam_mapper/pcap_stream_reader.hpp"
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace loam_mapper::points_provider::pcap_stream_reader
+{
+namespace
+{
+constexpr std::size_t size_chunk = 4UL * 1024UL * 1024UL;
+constexpr std::size_t count_chunks = 4;
+
+constexpr std::uint32_t magic_microseconds = 0xa1b2c3d4U;
+constexpr std::uint32_t magic_microseconds_swapped = 0xd4c3b2a1U;
+constexpr std::uint32_t magic_nanoseconds = 0xa1b23c4dU;
+constexpr std::uint32_t magic_nanoseconds_swapped = 0x4d3cb2a1U;
+constexpr std::uint32_t link_type_ethernet = 1U;
+
+constexpr std::uint32_t pcapng_block_section_header = 0x0a0d0d0aU;
+constexpr std::uint32_t pcapng_block_interface_description = 0x00000001U;
+constexpr std::uint32_t pcapng_block_simple_packet = 0x00000003U;
+constexpr std::uint32_t pcapng_block_enhanced_packet = 0x00000006U;
+constexpr std::uint32_t pcapng_byte_order_magic = 0x1a2b3c4dU;
+constexpr std::uint32_t pcapng_byte_order_magic_swapped = 0x4d3c2b1aU;
+constexpr std::uint16_t pcapng_option_end = 0U;
+constexpr std::uint16_t pcapng_option_if_tsresol = 9U;
+
+bool ends_with(const std::string & str, const std::string & suffix)
+{
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+struct FileCloser
+{
+  void operator()(std::FILE * file) const { std::fclose(file); }
+};
+struct GzCloser
+{
+  void operator()(gzFile_s * file) const { gzclose(file); }
+};
+struct ZstdDCtxFreer
+{
+  void operator()(ZSTD_DCtx * dctx) const { ZSTD_freeDCtx(dctx); }
+};
+}  // namespace
+
+PcapStreamReader::PcapStreamReader(const fs::path & path_capture)
+: path_capture_{path_capture},
+  compression_{Compression::None},
+  format_{Format::Pcap},
+  is_producer_done_{false},
+  is_stopping_{false},
+  offset_chunk_current_{0U},
+  offset_stream_{0U},
+  is_byte_swapped_{false},
+  is_nanosecond_resolution_{false}
+{
+  if (!is_supported(path_capture_)) {
+    throw std::runtime_error(path_capture_.string() + " is not a supported capture file.");
+  }
+  const std::string & name = path_capture_.string();
+  if (ends_with(name, ".gz")) {
+    compression_ = Compression::Gzip;
+  } else if (ends_with(name, ".zst")) {
+    compression_ = Compression::Zstd;
+  }
+
+  for (std::size_t i = 0; i < count_chunks; ++i) {
+    chunks_free_.emplace_back();
+    chunks_free_.back().reserve(size_chunk);
+  }
+  bytes_staging_.reserve(64UL * 1024UL);
+
+  thread_decompression_ = std::thread(&PcapStreamReader::run_decompression, this);
+  try {
+    read_file_header();
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_chunks_);
+      is_stopping_ = true;
+    }
+    cv_chunks_.notify_all();
+    thread_decompression_.join();
+    throw;
+  }
+}
+
+PcapStreamReader::~PcapStreamReader()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_chunks_);
+    is_stopping_ = true;
+  }
+  cv_chunks_.notify_all();
+  if (thread_decompression_.joinable()) {
+    thread_decompression_.join();
+  }
+}
+
+bool PcapStreamReader::is_supported(const fs::path & path_capture)
+{
+  std::string name = path_capture.filename().string();
+  if (ends_with(name, ".gz")) {
+    name.resize(name.size() - 3);
+  } else if (ends_with(name, ".zst")) {
+    name.resize(name.size() - 4);
+  }
+  return ends_with(name, ".pcap") || ends_with(name, ".pcapng");
+}
+
+bool PcapStreamReader::get_next_packet(mapped_pcap_reader::PacketView & packet)
+{
+  return format_ == Format::Pcap ? get_next_packet_pcap(packet) : get_next_packet_pcapng(packet);
+}
+
+void PcapStreamReader::run_decompression()
+{
+  try {
+    switch (compression_) {
+      case Compression::None:
+        read_uncompressed();
+        break;
+      case Compression::Gzip:
+        read_gzip();
+        break;
+      case Compression::Zstd:
+        read_zstd();
+        break;
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_chunks_);
+    exception_producer_ = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_chunks_);
+    is_producer_done_ = true;
+  }
+  cv_chunks_.notify_all();
+}
+
+void PcapStreamReader::read_uncompressed()
+{
+  std::unique_ptr<std::FILE, FileCloser> file(std::fopen(path_capture_.c_str(), "rb"));
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path_capture_.string() + " for reading.");
+  }
+  std::vector<std::uint8_t> chunk;
+  while (acquire_chunk_free(chunk)) {
+    chunk.resize(size_chunk);
+    chunk.resize(std::fread(chunk.data(), 1, chunk.size(), file.get()));
+    if (chunk.empty()) {
+      if (std::ferror(file.get())) {
+        throw std::runtime_error("Cannot read " + path_capture_.string());
+      }
+      return;
+    }
+    push_chunk_filled(std::move(chunk));
+  }
+}
+
+void PcapStreamReader::read_gzip()
+{
+  std::unique_ptr<gzFile_s, GzCloser> file(gzopen(path_capture_.c_str(), "rb"));
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path_capture_.string() + " for reading.");
+  }
+  gzbuffer(file.get(), 1024U * 1024U);
+  std::vector<std::uint8_t> chunk;
+  while (acquire_chunk_free(chunk)) {
+    chunk.resize(size_chunk);
+    const int count_read =
+      gzread(file.get(), chunk.data(), static_cast<unsigned int>(chunk.size()));
+    if (count_read < 0) {
+      int error_number;
+      throw std::runtime_error(
+        "Cannot decompress " + path_capture_.string() + ": " + gzerror(file.get(), &error_number));
+    }
+    if (count_read == 0) {
+      return;
+    }
+    chunk.resize(static_cast<std::size_t>(count_read));
+    push_chunk_filled(std::move(chunk));
+  }
+}
+
+void PcapStreamReader::read_zstd()
+{
+  std::unique_ptr<std::FILE, FileCloser> file(std::fopen(path_capture_.c_str(), "rb"));
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path_capture_.string() + " for reading.");
+  }
+  std::unique_ptr<ZSTD_DCtx, ZstdDCtxFreer> dctx(ZSTD_createDCtx());
+  std::vector<std::uint8_t> bytes_in(ZSTD_DStreamInSize());
+  ZSTD_inBuffer input{bytes_in.data(), 0, 0};
+  bool is_end_of_file = false;
+  bool is_done = false;
+  std::size_t result_last = 0;
+
+  std::vector<std::uint8_t> chunk;
+  while (!is_done && acquire_chunk_free(chunk)) {
+    chunk.resize(size_chunk);
+    ZSTD_outBuffer output{chunk.data(), chunk.size(), 0};
+    while (output.pos < output.size) {
+      if (input.pos == input.size && !is_end_of_file) {
+        input.size = std::fread(bytes_in.data(), 1, bytes_in.size(), file.get());
+        input.pos = 0;
+        is_end_of_file = input.size == 0;
+      }
+      const std::size_t pos_output_before = output.pos;
+      const std::size_t result = ZSTD_decompressStream(dctx.get(), &output, &input);
+      if (ZSTD_isError(result)) {
+        throw std::runtime_error(
+          "Cannot decompress " + path_capture_.string() + ": " + ZSTD_getErrorName(result));
+      }
+      // Keep flushing with empty input until the decompressor has nothing left.
+      if (is_end_of_file && output.pos == pos_output_before) {
+        is_done = true;
+        break;
+      }
+      // 0 once a frame is completely decoded and flushed
+      result_last = result;
+    }
+    chunk.resize(output.pos);
+    if (!chunk.empty()) {
+      push_chunk_filled(std::move(chunk));
+    }
+  }
+  if (is_done && result_last != 0) {
+    std::cerr << "Truncated zstd frame at the end of " << path_capture_ << std::endl;
+  }
+}
+
+bool PcapStreamReader::acquire_chunk_free(std::vector<std::uint8_t> & chunk)
+{
+  std::unique_lock<std::mutex> lock(mutex_chunks_);
+  cv_chunks_.wait(lock, [this]() { return is_stopping_ || !chunks_free_.empty(); });
+  if (is_stopping_) {
+    return false;
+  }
+  chunk = std::move(chunks_free_.front());
+  chunks_free_.pop_front();
+  return true;
+}
+
+void PcapStreamReader::push_chunk_filled(std::vector<std::uint8_t> && chunk)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_chunks_);
+    chunks_filled_.push_back(std::move(chunk));
+  }
+  cv_chunks_.notify_all();
+}
+
+bool PcapStreamReader::pull_chunk()
+{
+  std::unique_lock<std::mutex> lock(mutex_chunks_);
+  if (chunk_current_.capacity() > 0) {
+    chunks_free_.push_back(std::move(chunk_current_));
+    cv_chunks_.notify_all();
+  }
+  chunk_current_ = std::vector<std::uint8_t>();
+  offset_chunk_current_ = 0;
+  cv_chunks_.wait(lock, [this]() { return is_producer_done_ || !chunks_filled_.empty(); });
+  if (chunks_filled_.empty()) {
+    if (exception_producer_) {
+      std::rethrow_exception(exception_producer_);
+    }
+    return false;
+  }
+  chunk_current_ = std::move(chunks_filled_.front());
+  chunks_filled_.pop_front();
+  return true;
+}
+
+const std::uint8_t * PcapStreamReader::read_bytes(std::size_t count)
+{
+  if (chunk_current_.size() - offset_chunk_current_ >= count) {
+    const std::uint8_t * bytes = chunk_current_.data() + offset_chunk_current_;
+    offset_chunk_current_ += count;
+    offset_stream_ += count;
+    return bytes;
+  }
+  // The bytes straddle chunks, gather them in the staging buffer.
+  bytes_staging_.assign(
+    chunk_current_.begin() + static_cast<std::ptrdiff_t>(offset_chunk_current_),
+    chunk_current_.end());
+  offset_chunk_current_ = chunk_current_.size();
+  while (bytes_staging_.size() < count) {
+    if (!pull_chunk()) {
+      return nullptr;
+    }
+    const std::size_t count_taken = std::min(count - bytes_staging_.size(), chunk_current_.size());
+    bytes_staging_.insert(
+      bytes_staging_.end(), chunk_current_.begin(),
+      chunk_current_.begin() + static_cast<std::ptrdiff_t>(count_taken));
+    offset_chunk_current_ = count_taken;
+  }
+  offset_stream_ += count;
+  return bytes_staging_.data();
+}
+
+std::uint32_t PcapStreamReader::to_u32(const std::uint8_t * bytes) const
+{
+  std::uint32_t value;
+  std::memcpy(&value, bytes, sizeof(value));
+  return is_byte_swapped_ ? __builtin_bswap32(value) : value;
+}
+
+std::uint16_t PcapStreamReader::to_u16(const std::uint8_t * bytes) const
+{
+  std::uint16_t value;
+  std::memcpy(&value, bytes, sizeof(value));
+  return is_byte_swapped_ ? __builtin_bswap16(value) : value;
+}
+
+void PcapStreamReader::read_file_header()
+{
+  const std::uint8_t * bytes_magic = read_bytes(4);
+  if (bytes_magic == nullptr) {
+    throw std::runtime_error(path_capture_.string() + " is empty.");
+  }
+  std::uint32_t magic;
+  std::memcpy(&magic, bytes_magic, sizeof(magic));
+
+  switch (magic) {
+    case magic_microseconds:
+    case magic_microseconds_swapped:
+    case magic_nanoseconds:
+    case magic_nanoseconds_swapped: {
+      format_ = Format::Pcap;
+      is_byte_swapped_ = magic == magic_microseconds_swapped || magic == magic_nanoseconds_swapped;
+      is_nanosecond_resolution_ = magic == magic_nanoseconds || magic == magic_nanoseconds_swapped;
+      const std::uint8_t * bytes_header = read_bytes(20);
+      if (bytes_header == nullptr) {
+        throw std::runtime_error(path_capture_.string() + " has a truncated pcap header.");
+      }
+      // The parser expects Ethernet framed UDP packets (42 bytes of headers).
+      const std::uint32_t link_type = to_u32(bytes_header + 16);
+      if (link_type != link_type_ethernet) {
+        throw std::runtime_error(
+          path_capture_.string() + " has link type " + std::to_string(link_type) +
+          ", only Ethernet captures are supported.");
+      }
+      break;
+    }
+    case pcapng_block_section_header: {
+      format_ = Format::Pcapng;
+      const std::uint8_t * bytes_header = read_bytes(8);
+      if (bytes_header == nullptr) {
+        throw std::runtime_error(path_capture_.string() + " has a truncated pcapng header.");
+      }
+      std::uint32_t byte_order_magic;
+      std::memcpy(&byte_order_magic, bytes_header + 4, sizeof(byte_order_magic));
+      if (byte_order_magic == pcapng_byte_order_magic_swapped) {
+        is_byte_swapped_ = true;
+      } else if (byte_order_magic != pcapng_byte_order_magic) {
+        throw std::runtime_error(path_capture_.string() + " has an invalid byte order magic.");
+      }
+      const std::uint32_t length_block = to_u32(bytes_header);
+      if (length_block < 28 || length_block % 4 != 0 || read_bytes(length_block - 12) == nullptr) {
+        throw std::runtime_error(path_capture_.string() + " has an invalid section header.");
+      }
+      break;
+    }
+    default:
+      throw std::runtime_error(path_capture_.string() + " is neither a pcap nor a pcapng file.");
+  }
+}
+
+bool PcapStreamReader::get_next_packet_pcap(mapped_pcap_reader::PacketView & packet)
+{
+  const std::size_t offset_record = offset_stream_;
+  const std::uint8_t * bytes_header =
+    read_bytes(mapped_pcap_reader::MappedPcapReader::size_record_header);
+  if (bytes_header == nullptr) {
+    return false;
+  }
+  packet.offset_record = offset_record;
+  packet.stamp_seconds = to_u32(bytes_header);
+  packet.stamp_microseconds = to_u32(bytes_header + 4);
+  if (is_nanosecond_resolution_) {
+    packet.stamp_microseconds /= 1000U;
+  }
+  packet.length_captured = to_u32(bytes_header + 8);
+  packet.length_original = to_u32(bytes_header + 12);
+
+  packet.data = read_bytes(packet.length_captured);
+  if (packet.data == nullptr) {
+    std::cerr << "Truncated pcap record at offset " << offset_record << " in " << path_capture_
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool PcapStreamReader::get_next_packet_pcapng(mapped_pcap_reader::PacketView & packet)
+{
+  while (true) {
+    const std::size_t offset_block = offset_stream_;
+    const std::uint8_t * bytes_header = read_bytes(8);
+    if (bytes_header == nullptr) {
+      return false;
+    }
+    std::uint32_t type_block;
+    std::uint32_t length_block_raw;
+    std::memcpy(&type_block, bytes_header, sizeof(type_block));
+    std::memcpy(&length_block_raw, bytes_header + 4, sizeof(length_block_raw));
+
+    if (type_block == pcapng_block_section_header) {
+      // A new section may switch the byte order, and starts without interfaces.
+      const std::uint8_t * bytes_byte_order_magic = read_bytes(4);
+      if (bytes_byte_order_magic == nullptr) {
+        return false;
+      }
+      std::uint32_t byte_order_magic;
+      std::memcpy(&byte_order_magic, bytes_byte_order_magic, sizeof(byte_order_magic));
+      is_byte_swapped_ = byte_order_magic == pcapng_byte_order_magic_swapped;
+      const std::uint32_t length_block =
+        is_byte_swapped_ ? __builtin_bswap32(length_block_raw) : length_block_raw;
+      if (length_block < 28 || length_block % 4 != 0) {
+        throw std::runtime_error(
+          "Invalid pcapng section header at offset " + std::to_string(offset_block) + " in " +
+          path_capture_.string());
+      }
+      if (read_bytes(length_block - 12) == nullptr) {
+        return false;
+      }
+      interfaces_.clear();
+      continue;
+    }
+
+    type_block = is_byte_swapped_ ? __builtin_bswap32(type_block) : type_block;
+    const std::uint32_t length_block =
+      is_byte_swapped_ ? __builtin_bswap32(length_block_raw) : length_block_raw;
+    if (length_block < 12 || length_block % 4 != 0) {
+      throw std::runtime_error(
+        "Invalid pcapng block length at offset " + std::to_string(offset_block) + " in " +
+        path_capture_.string());
+    }
+    // Body and the trailing copy of the block length
+    const std::uint8_t * body = read_bytes(length_block - 8);
+    if (body == nullptr) {
+      std::cerr << "Truncated pcapng block at offset " << offset_block << " in " << path_capture_
+                << std::endl;
+      return false;
+    }
+    const std::size_t size_body = length_block - 12;
+
+    switch (type_block) {
+      case pcapng_block_interface_description:
+        read_interface_description(body, size_body);
+        break;
+      case pcapng_block_enhanced_packet: {
+        if (size_body < 20) {
+          break;
+        }
+        const std::uint32_t id_interface = to_u32(body);
+        if (id_interface >= interfaces_.size()) {
+          break;
+        }
+        const auto & interface = interfaces_.at(id_interface);
+        const std::uint32_t length_captured = to_u32(body + 12);
+        if (interface.link_type != link_type_ethernet || length_captured > size_body - 20) {
+          break;
+        }
+        const std::uint64_t stamp =
+          (static_cast<std::uint64_t>(to_u32(body + 4)) << 32U) | to_u32(body + 8);
+        packet.stamp_seconds = static_cast<std::uint32_t>(stamp / interface.units_per_second);
+        packet.stamp_microseconds = static_cast<std::uint32_t>(
+          static_cast<double>(stamp % interface.units_per_second) * 1e6 /
+          static_cast<double>(interface.units_per_second));
+        packet.length_captured = length_captured;
+        packet.length_original = to_u32(body + 16);
+        packet.data = body + 20;
+        packet.offset_record = offset_block;
+        return true;
+      }
+      case pcapng_block_simple_packet: {
+        if (size_body < 4 || interfaces_.empty()) {
+          break;
+        }
+        const auto & interface = interfaces_.front();
+        if (interface.link_type != link_type_ethernet) {
+          break;
+        }
+        packet.length_original = to_u32(body);
+        std::uint32_t length_captured =
+          std::min(packet.length_original, static_cast<std::uint32_t>(size_body - 4));
+        if (interface.snap_length != 0U) {
+          length_captured = std::min(length_captured, interface.snap_length);
+        }
+        // Simple packet blocks don't carry a timestamp.
+        packet.stamp_seconds = 0U;
+        packet.stamp_microseconds = 0U;
+        packet.length_captured = length_captured;
+        packet.data = body + 4;
+        packet.offset_record = offset_block;
+        return true;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+void PcapStreamReader::read_interface_description(const std::uint8_t * body, std::size_t size_body)
+{
+  if (size_body < 8) {
+    throw std::runtime_error("Invalid pcapng interface description in " + path_capture_.string());
+  }
+  Interface interface{to_u16(body), to_u32(body + 4), 1000000U};
+
+  std::size_t offset = 8;
+  while (offset + 4 <= size_body) {
+    const std::uint16_t code = to_u16(body + offset);
+    const std::uint16_t length = to_u16(body + offset + 2);
+    if (code == pcapng_option_end || offset + 4 + length > size_body) {
+      break;
+    }
+    if (code == pcapng_option_if_tsresol && length >= 1) {
+      const std::uint8_t resolution = body[offset + 4];
+      const std::uint8_t exponent = resolution & 0x7fU;
+      std::uint64_t units_per_second = 1U;
+      for (std::uint8_t i = 0; i < exponent; ++i) {
+        units_per_second *= (resolution & 0x80U) ? 2U : 10U;
+      }
+      interface.units_per_second = units_per_second;
+    }
+    // Option values are padded to 32 bits
+    offset += 4 + ((length + 3U) & ~3U);
+  }
+  interfaces_.push_back(interface);
+}
+
+}  // namespace loam_mapper::points_provider::pcap_stream_reader
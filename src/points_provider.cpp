@@ -3,24 +3,283 @@
 #include <boost/filesystem.hpp>
 #include <boost/range/iterator_range.hpp>
 
-#include <pcapplusplus/PcapFileDevice.h>
+#include <sys/resource.h>
+
 #include <exception>
 #include <utility>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include "loam_mapper/point_types.hpp"
 #include "loam_mapper/utils.hpp"
 #include "loam_mapper/date.h"
 #include "loam_mapper/points_provider.hpp"
 #include "loam_mapper/continuous_packet_parser.hpp"
+#include "loam_mapper/mapped_pcap_reader.hpp"
+#include "loam_mapper/pcap_index.hpp"
+#include "loam_mapper/pcap_prefetcher.hpp"
+#include "loam_mapper/pcap_stream_reader.hpp"
+#include "loam_mapper/sensor_demultiplexer.hpp"
 
 namespace loam_mapper::points_provider
 {
 namespace fs = boost::filesystem;
 using Point = PointsProviderBase::Point;
 using Points = PointsProviderBase::Points;
+using ScanLease = scan_buffer_pool::ScanLease;
+
+namespace
+{
+using continuous_packet_parser::ContinuousPacketParser;
+using mapped_pcap_reader::MappedPcapReader;
+using mapped_pcap_reader::PacketView;
+using pcap_prefetcher::FileIoStats;
+using pcap_prefetcher::PcapPrefetcher;
+using pcap_stream_reader::PcapStreamReader;
+using Readers = std::vector<std::unique_ptr<MappedPcapReader>>;
+
+// ~6700 data packets, small enough to keep the decoded ranges in flight bounded.
+constexpr size_t size_bytes_range = 8UL * 1024UL * 1024UL;
+// Initial distance to walk back from a range to find a position packet, doubled until found.
+constexpr size_t size_bytes_lookback_initial = 1024UL * 1024UL;
+
+// Only uncompressed classic pcaps can be mapped and read at arbitrary offsets, compressed and
+// pcapng captures are streamed from the beginning.
+bool is_mappable(const fs::path & path_pcap)
+{
+  return path_pcap.extension() == ".pcap";
+}
+
+bool are_mappable(const std::vector<fs::path> & paths_pcaps, size_t index_start, size_t count)
+{
+  return std::all_of(
+    paths_pcaps.begin() + static_cast<std::ptrdiff_t>(index_start),
+    paths_pcaps.begin() + static_cast<std::ptrdiff_t>(index_start + count), is_mappable);
+}
+
+int64_t get_count_major_page_faults_thread()
+{
+  rusage usage{};
+  getrusage(RUSAGE_THREAD, &usage);
+  return usage.ru_majflt;
+}
+
+double get_milliseconds_since(const std::chrono::steady_clock::time_point & time_start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start)
+    .count();
+}
+
+// Wraps a scan callback so that the time spent in it is added to milliseconds.
+template <typename... Args>
+std::function<void(ScanLease, Args...)> make_callback_timed(
+  const std::function<void(ScanLease, Args...)> & callback, double & milliseconds)
+{
+  return [&callback, &milliseconds](ScanLease scan, Args... args) {
+    const auto time_start = std::chrono::steady_clock::now();
+    callback(std::move(scan), args...);
+    milliseconds += get_milliseconds_since(time_start);
+  };
+}
+
+// Passes every packet of the capture to the visitor until it returns false. milliseconds_callbacks
+// accumulates the time the visitor spends in the scan callbacks, which isn't counted as decoding.
+template <typename Visitor>
+FileIoStats read_pcap(
+  const fs::path & path_pcap, Visitor && visitor, const double & milliseconds_callbacks)
+{
+  std::cout << "processing: " << path_pcap << std::endl;
+  FileIoStats stats;
+  stats.path = path_pcap;
+  stats.count_bytes = fs::file_size(path_pcap);
+  const int64_t count_major_page_faults_start = get_count_major_page_faults_thread();
+  auto time_start = std::chrono::steady_clock::now();
+
+  auto read = [&stats, &time_start, &visitor](auto & reader) {
+    stats.milliseconds_open = get_milliseconds_since(time_start);
+    time_start = std::chrono::steady_clock::now();
+    PacketView packet;
+    while (reader.get_next_packet(packet) && visitor(packet)) {
+    }
+  };
+  const double milliseconds_callbacks_start = milliseconds_callbacks;
+  if (is_mappable(path_pcap)) {
+    MappedPcapReader reader(path_pcap);
+    read(reader);
+  } else {
+    PcapStreamReader reader(path_pcap);
+    read(reader);
+  }
+  stats.milliseconds_callbacks = milliseconds_callbacks - milliseconds_callbacks_start;
+  stats.milliseconds_decode = get_milliseconds_since(time_start) - stats.milliseconds_callbacks;
+  stats.count_major_page_faults =
+    get_count_major_page_faults_thread() - count_major_page_faults_start;
+  return stats;
+}
+
+struct ByteRange
+{
+  size_t index_reader;
+  size_t offset_begin;
+  size_t offset_end;
+};
+
+struct RangeResult
+{
+  // The first scan lacks the points collected in preceding ranges since their last cut.
+  std::vector<ScanLease> scans;
+  // Points after the last cut of the range, they belong to a scan completed by a later range.
+  ScanLease cloud_tail;
+  bool is_past_time_window{false};
+  bool is_done{false};
+};
+
+void decode_between(
+  const Readers & readers,
+  size_t index_reader_begin,
+  size_t offset_begin,
+  size_t index_reader_end,
+  size_t offset_end,
+  ContinuousPacketParser & parser,
+  const std::function<void(ScanLease)> & callback_cloud_surround_out)
+{
+  for (size_t i = index_reader_begin; i <= index_reader_end && !parser.is_past_time_window(); ++i) {
+    size_t offset = i == index_reader_begin ? offset_begin : MappedPcapReader::size_global_header;
+    const size_t offset_stop = i == index_reader_end ? offset_end : readers.at(i)->size();
+    PacketView packet;
+    while (offset < offset_stop && !parser.is_past_time_window() &&
+           readers.at(i)->get_packet_at(offset, packet)) {
+      parser.process_packet_into_cloud(
+        packet.data, packet.length_captured, callback_cloud_surround_out);
+    }
+  }
+}
+
+// Position (index_reader, offset) at the first record boundary at least size_lookback bytes
+// before position, walking into the preceding readers if needed. has_reached_stream_start is set
+// if that goes past the beginning of the first reader, the first record is returned then.
+std::pair<size_t, size_t> walk_back(
+  const Readers & readers,
+  const std::pair<size_t, size_t> & position,
+  size_t size_lookback,
+  bool & has_reached_stream_start)
+{
+  size_t index_reader = position.first;
+  size_t offset = position.second;
+  size_t size_remaining = size_lookback;
+  while (index_reader > 0 && size_remaining > offset - MappedPcapReader::size_global_header) {
+    size_remaining -= offset - MappedPcapReader::size_global_header;
+    index_reader--;
+    offset = readers.at(index_reader)->size();
+  }
+  has_reached_stream_start =
+    index_reader == 0 && size_remaining >= offset - MappedPcapReader::size_global_header;
+  if (has_reached_stream_start) {
+    return {0U, MappedPcapReader::size_global_header};
+  }
+  return {index_reader, readers.at(index_reader)->find_record_boundary(offset - size_remaining)};
+}
+
+// Finds the last valid position packet of the parser's sensor in [begin, end), reading only the
+// packet headers.
+bool find_position_packet_last(
+  const Readers & readers,
+  const ContinuousPacketParser & parser,
+  const std::pair<size_t, size_t> & position_begin,
+  const std::pair<size_t, size_t> & position_end,
+  std::pair<size_t, size_t> & position_found)
+{
+  bool has_found = false;
+  for (size_t i = position_begin.first; i <= position_end.first; ++i) {
+    size_t offset =
+      i == position_begin.first ? position_begin.second : MappedPcapReader::size_global_header;
+    const size_t offset_stop =
+      i == position_end.first ? position_end.second : readers.at(i)->size();
+    PacketView packet;
+    while (offset < offset_stop && readers.at(i)->get_packet_at(offset, packet)) {
+      if (parser.is_valid_position_packet(packet.data, packet.length_captured)) {
+        position_found = {i, packet.offset_record};
+        has_found = true;
+      }
+    }
+  }
+  return has_found;
+}
+
+// Brings a fresh parser to the state the serial parser would have at the beginning of range,
+// by replaying the bytes before it (without decoding points) from the nearest preceding valid
+// position packet. That packet is searched for backwards in windows of doubling size, each only
+// scanning the bytes the previous ones didn't, so only the replay itself decodes packets.
+void bootstrap_parser(
+  const Readers & readers,
+  const ByteRange & range,
+  const ContinuousPacketParser & parser_initial,
+  ContinuousPacketParser & parser)
+{
+  const std::function<void(ScanLease)> callback_ignore = [](ScanLease) {};
+  auto replay_from = [&](const std::pair<size_t, size_t> & position) {
+    parser = parser_initial;
+    parser.set_is_priming(true);
+    decode_between(
+      readers, position.first, position.second, range.index_reader, range.offset_begin, parser,
+      callback_ignore);
+    parser.set_is_priming(false);
+    parser.discard_partial_cloud();
+  };
+
+  std::pair<size_t, size_t> position_end{range.index_reader, range.offset_begin};
+  for (size_t size_lookback = size_bytes_lookback_initial;; size_lookback *= 2) {
+    bool has_reached_stream_start = false;
+    const auto position_begin =
+      walk_back(readers, position_end, size_lookback, has_reached_stream_start);
+    std::pair<size_t, size_t> position_packet;
+    if (find_position_packet_last(
+          readers, parser_initial, position_begin, position_end, position_packet)) {
+      replay_from(position_packet);
+      if (parser.is_bootstrapped()) {
+        return;
+      }
+      // Too few data packets follow it before the range, an earlier one is needed.
+      position_end = position_packet;
+      continue;
+    }
+    // When replaying from the very beginning, the state is exactly the serial one anyway.
+    if (has_reached_stream_start) {
+      replay_from(position_begin);
+      return;
+    }
+    position_end = position_begin;
+  }
+}
+
+void decode_range(
+  const Readers & readers,
+  const std::vector<ByteRange> & ranges,
+  size_t index_range,
+  const ContinuousPacketParser & parser_initial,
+  RangeResult & result)
+{
+  const auto & range = ranges.at(index_range);
+  ContinuousPacketParser parser = parser_initial;
+  if (index_range != 0) {
+    bootstrap_parser(readers, range, parser_initial, parser);
+  }
+  const std::function<void(ScanLease)> callback_collect = [&result](ScanLease cloud) {
+    result.scans.push_back(std::move(cloud));
+  };
+  decode_between(
+    readers, range.index_reader, range.offset_begin, range.index_reader, range.offset_end, parser,
+    callback_collect);
+  result.cloud_tail = parser.take_partial_cloud();
+  result.is_past_time_window = parser.is_past_time_window();
+}
+}  // namespace
 
 PointsProvider::PointsProvider(std::string path_folder_pcaps)
 : path_folder_pcaps_{path_folder_pcaps}
@@ -37,17 +296,19 @@ void PointsProvider::process()
        boost::make_iterator_range(fs::directory_iterator(path_folder_pcaps_)))
   {
     if (fs::is_directory(path_pcap.path())) {continue;}
-    if (path_pcap.path().extension() != ".pcap") {continue;}
+    if (!PcapStreamReader::is_supported(path_pcap.path())) {continue;}
     //    std::cout << "pcap: " << path_pcap.path().string() << std::endl;
     paths_pcaps_.push_back(path_pcap);
   }
+  // Directory iteration order is unspecified, the captures are named in recording order.
+  std::sort(paths_pcaps_.begin(), paths_pcaps_.end());
   if (paths_pcaps_.empty()) {
     throw std::runtime_error(path_folder_pcaps_.string() + " doesn't contain a pcap file.");
   }
 }
 
 void PointsProvider::process_pcaps_into_clouds(
-  std::function<void(const Points &)> & callback_cloud_surround_out,
+  const std::function<void(ScanLease)> & callback_cloud_surround_out,
   const size_t index_start,
   const size_t count)
 {
@@ -55,39 +316,359 @@ void PointsProvider::process_pcaps_into_clouds(
     throw std::range_error("index is outside paths_pcaps_ range.");
   }
 
-  continuous_packet_parser::ContinuousPacketParser packet_parser;
+  continuous_packet_parser::ContinuousPacketParser packet_parser = create_parser();
+  process_pcaps_serially(callback_cloud_surround_out, index_start, count, packet_parser);
+}
+
+void PointsProvider::process_pcaps_into_clouds_parallel(
+  const std::function<void(ScanLease)> & callback_cloud_surround_out,
+  const size_t index_start,
+  const size_t count,
+  size_t count_threads)
+{
+  if (index_start >= paths_pcaps_.size() || index_start + count > paths_pcaps_.size()) {
+    throw std::range_error("index is outside paths_pcaps_ range.");
+  }
+  if (!are_mappable(paths_pcaps_, index_start, count)) {
+    std::cout << "compressed or pcapng captures are decoded serially." << std::endl;
+    process_pcaps_into_clouds(callback_cloud_surround_out, index_start, count);
+    return;
+  }
+  if (count_threads == 0) {
+    count_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  Readers readers;
+  std::vector<ByteRange> ranges;
   for (size_t i = index_start; i < index_start + count; ++i) {
-    process_pcap_into_clouds(paths_pcaps_.at(i), callback_cloud_surround_out, packet_parser);
+    readers.push_back(std::make_unique<MappedPcapReader>(paths_pcaps_.at(i)));
+    const auto & reader = *readers.back();
+    size_t offset_begin = MappedPcapReader::size_global_header;
+    while (offset_begin < reader.size()) {
+      const size_t offset_end = reader.find_record_boundary(offset_begin + size_bytes_range);
+      ranges.push_back(ByteRange{readers.size() - 1, offset_begin, offset_end});
+      offset_begin = offset_end;
+    }
+  }
+  std::cout << "processing " << count << " pcaps in " << ranges.size() << " ranges with "
+            << count_threads << " threads." << std::endl;
+
+  const ContinuousPacketParser parser_initial = create_parser();
+  std::vector<RangeResult> results(ranges.size());
+  std::mutex mutex_results;
+  std::condition_variable cv_results;
+  size_t index_range_next = 0;
+  size_t index_range_emitted = 0;
+  std::exception_ptr exception;
+  // Workers may only run this far ahead of the emitted scans, which bounds memory usage.
+  const size_t count_ranges_in_flight_max = 2 * count_threads;
+
+  auto worker = [&]() {
+    while (true) {
+      size_t index_range;
+      {
+        std::unique_lock<std::mutex> lock(mutex_results);
+        cv_results.wait(lock, [&]() {
+          return exception || index_range_next >= ranges.size() ||
+                 index_range_next < index_range_emitted + count_ranges_in_flight_max;
+        });
+        if (exception || index_range_next >= ranges.size()) {
+          return;
+        }
+        index_range = index_range_next++;
+      }
+      RangeResult result;
+      try {
+        decode_range(readers, ranges, index_range, parser_initial, result);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_results);
+        exception = std::current_exception();
+        cv_results.notify_all();
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_results);
+        results.at(index_range) = std::move(result);
+        results.at(index_range).is_done = true;
+      }
+      cv_results.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < count_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+
+  // Stitch the scans that straddle range boundaries and emit everything in order.
+  ScanLease cloud_carry = parser_initial.get_scan_buffer_pool()->acquire();
+  for (size_t index_range = 0; index_range < ranges.size(); ++index_range) {
+    RangeResult result;
+    {
+      std::unique_lock<std::mutex> lock(mutex_results);
+      cv_results.wait(lock, [&]() { return exception || results.at(index_range).is_done; });
+      if (exception) {
+        break;
+      }
+      result = std::move(results.at(index_range));
+      index_range_emitted = index_range + 1;
+    }
+    cv_results.notify_all();
+
+    if (result.is_past_time_window) {
+      // Nothing after this range is needed, stop handing out ranges.
+      std::lock_guard<std::mutex> lock(mutex_results);
+      index_range_next = ranges.size();
+    }
+    try {
+      auto & points_carry = cloud_carry.get_points();
+      auto & telemetry_carry = cloud_carry.get_telemetry();
+      if (result.scans.empty()) {
+        points_carry.append(*result.cloud_tail);
+        telemetry_carry.merge(result.cloud_tail.get_telemetry());
+      } else {
+        points_carry.append(*result.scans.front());
+        telemetry_carry.merge(result.scans.front().get_telemetry());
+        callback_cloud_surround_out(std::move(cloud_carry));
+        for (size_t i = 1; i < result.scans.size(); ++i) {
+          callback_cloud_surround_out(std::move(result.scans.at(i)));
+        }
+        cloud_carry = std::move(result.cloud_tail);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_results);
+      exception = std::current_exception();
+      cv_results.notify_all();
+      break;
+    }
+    if (result.is_past_time_window) {
+      cv_results.notify_all();
+      break;
+    }
+  }
+
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+  // The carried points are what the serial parser has left after its last cut.
+  if (parser_initial.is_emitting_partial_scan_last() && !cloud_carry->empty()) {
+    callback_cloud_surround_out(std::move(cloud_carry));
   }
 }
 
-void PointsProvider::process_pcap_into_clouds(
-  const fs::path & path_pcap,
-  const std::function<void(const Points &)> & callback_cloud_surround_out,
-  continuous_packet_parser::ContinuousPacketParser & parser)
+void PointsProvider::process_pcaps_into_clouds_in_time_range(
+  const std::function<void(ScanLease)> & callback_cloud_surround_out,
+  const size_t index_start,
+  const size_t count,
+  const uint64_t stamp_unix_nanoseconds_start,
+  const uint64_t stamp_unix_nanoseconds_end)
 {
-  std::cout << "processing: " << path_pcap << std::endl;
-  pcpp::IFileReaderDevice * reader = pcpp::IFileReaderDevice::getReader(path_pcap.string());
-  if (reader == nullptr) {
-    printf("Cannot determine reader for file type\n");
-    exit(1);
+  if (index_start >= paths_pcaps_.size() || index_start + count > paths_pcaps_.size()) {
+    throw std::range_error("index is outside paths_pcaps_ range.");
+  }
+  using pcap_index::IndexEntry;
+  using pcap_index::PcapIndex;
+
+  ContinuousPacketParser parser = create_parser();
+  parser.set_time_window(
+    std::max(stamp_unix_nanoseconds_start, stamp_unix_nanoseconds_window_start_),
+    has_time_window_ ? std::min(stamp_unix_nanoseconds_end, stamp_unix_nanoseconds_window_end_)
+                     : stamp_unix_nanoseconds_end);
+  if (!are_mappable(paths_pcaps_, index_start, count)) {
+    // Can't seek, decode from the beginning and let the parser skip everything before the window.
+    std::cout << "compressed or pcapng captures are decoded without an index." << std::endl;
+    process_pcaps_serially(callback_cloud_surround_out, index_start, count, parser);
+    return;
+  }
+
+  Readers readers;
+  std::vector<PcapIndex> indices;
+  for (size_t i = index_start; i < index_start + count; ++i) {
+    readers.push_back(std::make_unique<MappedPcapReader>(paths_pcaps_.at(i)));
+    indices.push_back(
+      PcapIndex::load_or_build(
+        paths_pcaps_.at(i), *readers.back(), stride_data_packets_index, packet_filter));
+  }
+
+  // Positions are (index_reader, offset). Without a seek point decoding starts at the beginning.
+  std::pair<size_t, size_t> position_seek{0U, MappedPcapReader::size_global_header};
+  std::pair<size_t, size_t> position_bootstrap{0U, 0U};
+  std::pair<size_t, size_t> position_stop{readers.size() - 1, readers.back()->size()};
+  bool has_seek = false;
+  bool has_bootstrap = false;
+  bool has_stop = false;
+  std::pair<size_t, size_t> position_last_valid_position_packet{0U, 0U};
+  bool has_seen_valid_position_packet = false;
+
+  for (size_t i = 0; i < indices.size(); ++i) {
+    for (const auto & entry : indices.at(i).get_entries()) {
+      if (entry.type == IndexEntry::Type::Position) {
+        position_last_valid_position_packet = {i, entry.offset_record};
+        has_seen_valid_position_packet = true;
+        continue;
+      }
+      if (entry.type != IndexEntry::Type::Data || !entry.has_stamp()) {
+        continue;
+      }
+      const uint64_t stamp = entry.get_stamp_unix_nanoseconds();
+      if (stamp <= stamp_unix_nanoseconds_start) {
+        position_seek = {i, entry.offset_record};
+        position_bootstrap = position_last_valid_position_packet;
+        has_seek = true;
+        has_bootstrap = has_seen_valid_position_packet;
+      } else if (stamp > stamp_unix_nanoseconds_end) {
+        position_stop = {i, entry.offset_record};
+        has_stop = true;
+        break;
+      }
+    }
+    if (has_stop) {
+      break;
+    }
+  }
+
+  if (has_seek && has_bootstrap) {
+    const std::function<void(ScanLease)> callback_ignore = [](ScanLease) {};
+    parser.set_is_priming(true);
+    decode_between(
+      readers, position_bootstrap.first, position_bootstrap.second, position_seek.first,
+      position_seek.second, parser, callback_ignore);
+    parser.set_is_priming(false);
+    parser.discard_partial_cloud();
   }
+  std::cout << "processing from " << paths_pcaps_.at(index_start + position_seek.first) << " @ "
+            << position_seek.second << " to " << paths_pcaps_.at(index_start + position_stop.first)
+            << " @ " << position_stop.second << std::endl;
+  decode_between(
+    readers, position_seek.first, position_seek.second, position_stop.first,
+    position_stop.second, parser, callback_cloud_surround_out);
+  parser.finish(callback_cloud_surround_out);
+}
 
-  if (!reader->open()) {
-    printf("Cannot open input.pcap for reading\n");
-    exit(1);
+void PointsProvider::process_pcaps_into_clouds_multi_sensor(
+  const std::function<void(ScanLease, size_t)> & callback_cloud_surround_out,
+  const size_t index_start,
+  const size_t count,
+  const std::vector<packet_filter::PacketFilter> & packet_filters)
+{
+  if (index_start >= paths_pcaps_.size() || index_start + count > paths_pcaps_.size()) {
+    throw std::range_error("index is outside paths_pcaps_ range.");
+  }
+  std::vector<ContinuousPacketParser> parsers;
+  for (const auto & packet_filter_sensor : packet_filters) {
+    parsers.push_back(create_parser());
+    parsers.back().set_packet_filter(packet_filter_sensor);
   }
+  // The scans are emitted on this thread, while packets are pushed.
+  double milliseconds_callbacks = 0.0;
+  sensor_demultiplexer::SensorDemultiplexer demultiplexer(
+    parsers, packet_filters,
+    make_callback_timed(callback_cloud_surround_out, milliseconds_callbacks));
+
+  bool is_done = false;
+  read_pcaps_serially(
+    index_start, count,
+    [&demultiplexer, &is_done, &milliseconds_callbacks](const fs::path & path_pcap) {
+      return read_pcap(
+        path_pcap,
+        [&demultiplexer, &is_done](const PacketView & packet) {
+          is_done = !demultiplexer.push_packet(packet.data, packet.length_captured);
+          return !is_done;
+        },
+        milliseconds_callbacks);
+    },
+    [&is_done]() { return is_done; });
+  demultiplexer.finish();
+}
+
+void PointsProvider::process_pcaps_serially(
+  const std::function<void(ScanLease)> & callback_cloud_surround_out,
+  const size_t index_start,
+  const size_t count,
+  continuous_packet_parser::ContinuousPacketParser & parser)
+{
+  read_pcaps_serially(
+    index_start, count,
+    [this, &callback_cloud_surround_out, &parser](const fs::path & path_pcap) {
+      return process_pcap_into_clouds(path_pcap, callback_cloud_surround_out, parser);
+    },
+    [&parser]() { return parser.is_past_time_window(); });
+  parser.finish(callback_cloud_surround_out);
+}
 
-  pcpp::RawPacket rawPacket;
-  while (reader->getNextPacket(rawPacket)) {
-    parser.process_packet_into_cloud(rawPacket, callback_cloud_surround_out);
+void PointsProvider::read_pcaps_serially(
+  const size_t index_start,
+  const size_t count,
+  const std::function<FileIoStats(const fs::path &)> & read_pcap_into_parsers,
+  const std::function<bool()> & is_done)
+{
+  // While a file is decoded, the next one is read ahead in the background.
+  PcapPrefetcher prefetcher(size_bytes_prefetch);
+  prefetcher.prefetch(paths_pcaps_.at(index_start));
+  for (size_t i = index_start; i < index_start + count && !is_done(); ++i) {
+    const double milliseconds_prefetch_wait = prefetcher.wait(paths_pcaps_.at(i));
+    if (i + 1 < index_start + count) {
+      prefetcher.prefetch(paths_pcaps_.at(i + 1));
+    }
+    FileIoStats stats = read_pcap_into_parsers(paths_pcaps_.at(i));
+    stats.milliseconds_prefetch_wait = milliseconds_prefetch_wait;
+    std::cout << "io: " << stats.path.filename() << " " << stats.count_bytes / (1024 * 1024)
+              << " MB, prefetch wait " << stats.milliseconds_prefetch_wait << " ms, open "
+              << stats.milliseconds_open << " ms, decode " << stats.milliseconds_decode
+              << " ms, callbacks " << stats.milliseconds_callbacks << " ms, "
+              << stats.count_major_page_faults << " major faults" << std::endl;
+    io_stats_.push_back(stats);
   }
+}
 
-  reader->close();
-  delete reader;
+FileIoStats PointsProvider::process_pcap_into_clouds(
+  const fs::path & path_pcap,
+  const std::function<void(ScanLease)> & callback_cloud_surround_out,
+  continuous_packet_parser::ContinuousPacketParser & parser)
+{
+  double milliseconds_callbacks = 0.0;
+  const auto callback_timed =
+    make_callback_timed(callback_cloud_surround_out, milliseconds_callbacks);
+  return read_pcap(
+    path_pcap,
+    [&parser, &callback_timed](const PacketView & packet) {
+      if (parser.is_past_time_window()) {
+        return false;
+      }
+      parser.process_packet_into_cloud(packet.data, packet.length_captured, callback_timed);
+      return true;
+    },
+    milliseconds_callbacks);
 }
 
+void PointsProvider::set_time_window(
+  uint64_t stamp_unix_nanoseconds_start, uint64_t stamp_unix_nanoseconds_end)
+{
+  if (stamp_unix_nanoseconds_start > stamp_unix_nanoseconds_end) {
+    throw std::invalid_argument("time window start is after its end.");
+  }
+  has_time_window_ = true;
+  stamp_unix_nanoseconds_window_start_ = stamp_unix_nanoseconds_start;
+  stamp_unix_nanoseconds_window_end_ = stamp_unix_nanoseconds_end;
+}
 
+continuous_packet_parser::ContinuousPacketParser PointsProvider::create_parser() const
+{
+  continuous_packet_parser::ContinuousPacketParser parser;
+  parser.set_packet_filter(packet_filter);
+  parser.set_dual_return_policy(dual_return_policy);
+  parser.set_calibration(calibration);
+  parser.set_angle_deg_cut(angle_deg_cut);
+  parser.set_is_emitting_partial_scan_last(is_emitting_partial_scan_last);
+  if (has_time_window_) {
+    parser.set_time_window(
+      stamp_unix_nanoseconds_window_start_, stamp_unix_nanoseconds_window_end_);
+  }
+  return parser;
+}
 
 std::string PointsProvider::info() {return "";}
 }  // namespace loam_mapper::points_provider
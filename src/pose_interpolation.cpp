@@ -0,0 +1,194 @@
+#include "loam_mapper/pose_interpolation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <execution>
+#include <memory>
+#include <vector>
+
+namespace loam_mapper::transform_provider::pose_interpolation
+{
+namespace
+{
+// Stamps are interpolated in blocks, so the poses gathered for a block stay in the L1 cache.
+constexpr std::size_t size_block = 256;
+// Stamps interpolated by one task of the parallel loop
+constexpr std::size_t size_chunk = 16 * size_block;
+
+// sin(ratio * angle) / sin(angle) is summed as a series in cos(angle) - 1 (D. Eberly, "A Fast and
+// Accurate Algorithm for Computing SLERP"). Down to this cosine, 8 terms are exact in double
+// precision. The angle is half the rotation between two poses, so that covers 16 degrees, more
+// than consecutive poses ever differ by unless the trajectory has a gap.
+constexpr double cos_angle_series_min = 0.99;
+constexpr std::size_t count_terms_series = 8;
+
+constexpr std::array<double, count_terms_series + 1> make_factors_series()
+{
+  std::array<double, count_terms_series + 1> factors{};
+  for (std::size_t i = 1; i <= count_terms_series; ++i) {
+    factors[i] = 1.0 / static_cast<double>(i * (2 * i + 1));
+  }
+  return factors;
+}
+constexpr std::array<double, count_terms_series + 1> factors_series = make_factors_series();
+
+// No branches or calls once unrolled, so the loop calling it vectorizes.
+inline double get_weight_series(double ratio, double cos_angle)
+{
+  const double ratio_squared = ratio * ratio;
+  const double delta = cos_angle - 1.0;
+  double coefficient = ratio;
+  double power = 1.0;
+  double weight = ratio;
+#pragma GCC unroll 8
+  for (std::size_t i = 1; i <= count_terms_series; ++i) {
+    coefficient *= (ratio_squared - static_cast<double>(i * i)) * factors_series[i];
+    power *= delta;
+    weight += coefficient * power;
+  }
+  return weight;
+}
+
+using Column = std::array<double, size_block>;
+
+// The poses around the stamps of a block and the poses blended from them, column wise. Keeping
+// all of them in one struct lets the compiler see that the columns don't overlap.
+struct Block
+{
+  Column ratio;
+  std::array<Column, 3> position_before;
+  std::array<Column, 3> position_after;
+  std::array<Column, 4> orientation_before;
+  std::array<Column, 4> orientation_after;
+  std::array<Column, 3> position;
+  std::array<Column, 4> orientation;
+};
+
+void gather_block(
+  const PoseTable & poses, const pose_lookup::PoseLookup & lookup,
+  pose_lookup::PoseLookup::Cursor & cursor, const std::uint64_t * stamps_unix_nanoseconds,
+  std::size_t count, Block & block)
+{
+  const std::array<const double *, 3> position{
+    poses.get_column(PoseTable::column_x), poses.get_column(PoseTable::column_y),
+    poses.get_column(PoseTable::column_z)};
+  const std::array<const double *, 4> orientation{
+    poses.get_column(PoseTable::column_orientation_x),
+    poses.get_column(PoseTable::column_orientation_y),
+    poses.get_column(PoseTable::column_orientation_z),
+    poses.get_column(PoseTable::column_orientation_w)};
+  for (std::size_t i = 0; i < count; ++i) {
+    const pose_lookup::Bracket bracket = lookup.find_bracket(stamps_unix_nanoseconds[i], cursor);
+    block.ratio[i] = bracket.ratio;
+    for (std::size_t j = 0; j < 3; ++j) {
+      block.position_before[j][i] = position[j][bracket.index_before];
+      block.position_after[j][i] = position[j][bracket.index_after];
+    }
+    for (std::size_t j = 0; j < 4; ++j) {
+      block.orientation_before[j][i] = orientation[j][bracket.index_before];
+      block.orientation_after[j][i] = orientation[j][bracket.index_after];
+    }
+  }
+}
+
+// Always blends the whole block, a constant trip count lets the compiler vectorize the loop at -O2
+// as well. The lanes past the stamps of a partial block hold finite leftovers. Compiled for AVX2
+// as well where available, the loader picks the version the CPU supports.
+#if defined(__x86_64__)
+__attribute__((target_clones("avx2", "default")))
+#endif
+void blend_block(Block & block)
+{
+  const auto & before = block.orientation_before;
+  const auto & after = block.orientation_after;
+  for (std::size_t i = 0; i < size_block; ++i) {
+    const double ratio = block.ratio[i];
+#pragma GCC unroll 3
+    for (std::size_t j = 0; j < 3; ++j) {
+      block.position[j][i] = block.position_before[j][i] +
+                             ratio * (block.position_after[j][i] - block.position_before[j][i]);
+    }
+
+    // q and -q are the same orientation, the shorter arc is taken.
+    const double dot = before[0][i] * after[0][i] + before[1][i] * after[1][i] +
+                       before[2][i] * after[2][i] + before[3][i] * after[3][i];
+    const double sign = std::copysign(1.0, dot);
+    const double cos_angle = std::fabs(dot);
+    const double weight_before = get_weight_series(1.0 - ratio, cos_angle);
+    const double weight_after = get_weight_series(ratio, cos_angle) * sign;
+#pragma GCC unroll 4
+    for (std::size_t j = 0; j < 4; ++j) {
+      block.orientation[j][i] = weight_before * before[j][i] + weight_after * after[j][i];
+    }
+  }
+}
+
+// Redoes the orientations the series isn't exact for with the closed form of SLERP.
+void blend_block_wide_angles(Block & block, std::size_t count)
+{
+  const auto & before = block.orientation_before;
+  const auto & after = block.orientation_after;
+  for (std::size_t i = 0; i < count; ++i) {
+    const double dot = before[0][i] * after[0][i] + before[1][i] * after[1][i] +
+                       before[2][i] * after[2][i] + before[3][i] * after[3][i];
+    if (std::fabs(dot) >= cos_angle_series_min) {
+      continue;
+    }
+    const double angle = std::acos(std::fabs(dot));
+    const double sin_angle = std::sin(angle);
+    const double weight_before = std::sin((1.0 - block.ratio[i]) * angle) / sin_angle;
+    const double weight_after =
+      std::copysign(std::sin(block.ratio[i] * angle) / sin_angle, dot);
+    for (std::size_t j = 0; j < 4; ++j) {
+      block.orientation[j][i] = weight_before * before[j][i] + weight_after * after[j][i];
+    }
+  }
+}
+
+void store_block(const Block & block, std::size_t count, PoseColumns & poses, std::size_t offset)
+{
+  const std::array<double *, 3> position{
+    poses.x.data() + offset, poses.y.data() + offset, poses.z.data() + offset};
+  const std::array<double *, 4> orientation{
+    poses.orientation_x.data() + offset, poses.orientation_y.data() + offset,
+    poses.orientation_z.data() + offset, poses.orientation_w.data() + offset};
+  for (std::size_t j = 0; j < 3; ++j) {
+    std::copy_n(block.position[j].cbegin(), count, position[j]);
+  }
+  for (std::size_t j = 0; j < 4; ++j) {
+    std::copy_n(block.orientation[j].cbegin(), count, orientation[j]);
+  }
+}
+}  // namespace
+
+void interpolate(
+  const PoseTable & poses, const pose_lookup::PoseLookup & lookup,
+  const std::uint64_t * stamps_unix_nanoseconds, std::size_t count,
+  PoseColumns & poses_interpolated)
+{
+  poses_interpolated.resize(count);
+  std::vector<std::size_t> offsets_chunk;
+  for (std::size_t offset = 0; offset < count; offset += size_chunk) {
+    offsets_chunk.push_back(offset);
+  }
+  std::for_each(
+    std::execution::par, offsets_chunk.cbegin(), offsets_chunk.cend(),
+    [&poses, &lookup, stamps_unix_nanoseconds, count,
+     &poses_interpolated](std::size_t offset_chunk) {
+      // About 43 KB, too much for the stack of the worker threads. Zeroed, so that the unused
+      // lanes of a partial block are finite.
+      auto block = std::make_unique<Block>();
+      pose_lookup::PoseLookup::Cursor cursor;
+      const std::size_t offset_end = std::min(count, offset_chunk + size_chunk);
+      for (std::size_t offset = offset_chunk; offset < offset_end; offset += size_block) {
+        const std::size_t count_block = std::min(size_block, offset_end - offset);
+        gather_block(
+          poses, lookup, cursor, stamps_unix_nanoseconds + offset, count_block, *block);
+        blend_block(*block);
+        blend_block_wide_angles(*block, count_block);
+        store_block(*block, count_block, poses_interpolated, offset);
+      }
+    });
+}
+}  // namespace loam_mapper::transform_provider::pose_interpolation
@@ -0,0 +1,101 @@
+#include "loam_mapper/pose_lookup.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace loam_mapper::transform_provider::pose_lookup
+{
+namespace
+{
+// A sequential search walks at most this many poses before it goes through the buckets.
+constexpr std::size_t count_steps_cursor_max = 8;
+}  // namespace
+
+PoseLookup::PoseLookup(const PoseTable & poses)
+: stamps_{poses.get_stamps_unix_nanoseconds()}, count_stamps_{poses.size()}
+{
+  if (count_stamps_ >= std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error(
+      "trajectory was expected to have less than 2^32 poses but it has " +
+      std::to_string(count_stamps_));
+  }
+  if (count_stamps_ == 0) {
+    return;
+  }
+  const std::uint64_t nanoseconds_span = stamps_[count_stamps_ - 1] - stamps_[0];
+  nanoseconds_bucket_ = std::max<std::uint64_t>(1U, nanoseconds_span / count_stamps_);
+  const std::size_t count_buckets =
+    static_cast<std::size_t>(nanoseconds_span / nanoseconds_bucket_) + 1;
+
+  indices_first_pose_.resize(count_buckets);
+  std::size_t index = 0;
+  for (std::size_t i = 0; i < count_buckets; ++i) {
+    const std::uint64_t stamp_bucket = stamps_[0] + i * nanoseconds_bucket_;
+    while (index < count_stamps_ && stamps_[index] < stamp_bucket) {
+      ++index;
+    }
+    indices_first_pose_[i] = static_cast<std::uint32_t>(index);
+  }
+}
+
+std::size_t PoseLookup::find_index_in_buckets(std::uint64_t stamp_unix_nanoseconds) const
+{
+  if (count_stamps_ == 0 || stamp_unix_nanoseconds <= stamps_[0]) {
+    return 0;
+  }
+  if (stamp_unix_nanoseconds > stamps_[count_stamps_ - 1]) {
+    return count_stamps_;
+  }
+  // The first pose of the bucket is at or before the stamp's pose, which exists since the stamp
+  // isn't after the last pose.
+  std::size_t index = indices_first_pose_[static_cast<std::size_t>(
+    (stamp_unix_nanoseconds - stamps_[0]) / nanoseconds_bucket_)];
+  while (stamps_[index] < stamp_unix_nanoseconds) {
+    ++index;
+  }
+  return index;
+}
+
+std::size_t PoseLookup::find_index_at_or_after(
+  std::uint64_t stamp_unix_nanoseconds, Cursor & cursor) const
+{
+  if (cursor.mode == Mode::Sequential && cursor.index <= count_stamps_) {
+    std::size_t index = cursor.index;
+    // The cursor is valid if the stamp isn't before the pose it is at.
+    if (index == 0 || stamps_[index - 1] < stamp_unix_nanoseconds) {
+      const std::size_t index_end = std::min(count_stamps_, index + count_steps_cursor_max);
+      while (index < index_end && stamps_[index] < stamp_unix_nanoseconds) {
+        ++index;
+      }
+      if (index == count_stamps_ || stamps_[index] >= stamp_unix_nanoseconds) {
+        cursor.index = index;
+        return index;
+      }
+    }
+  }
+  cursor.index = find_index_in_buckets(stamp_unix_nanoseconds);
+  return cursor.index;
+}
+
+Bracket PoseLookup::find_bracket(std::uint64_t stamp_unix_nanoseconds, Cursor & cursor) const
+{
+  if (count_stamps_ == 0) {
+    throw std::length_error("there are no poses to interpolate.");
+  }
+  const std::size_t index_after = find_index_at_or_after(stamp_unix_nanoseconds, cursor);
+  if (index_after == 0) {
+    return Bracket{0U, 0U, 0.0};
+  }
+  if (index_after == count_stamps_) {
+    return Bracket{index_after - 1, index_after - 1, 0.0};
+  }
+  // The stamp before is smaller than the stamp searched, which isn't larger than the one after.
+  const std::size_t index_before = index_after - 1;
+  return Bracket{
+    index_before, index_after,
+    static_cast<double>(stamp_unix_nanoseconds - stamps_[index_before]) /
+      static_cast<double>(stamps_[index_after] - stamps_[index_before])};
+}
+}  // namespace loam_mapper::transform_provider::pose_lookup
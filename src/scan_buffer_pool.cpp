@@ -0,0 +1,94 @@
+#include "loam_mapper/scan_buffer_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace loam_mapper::points_provider::scan_buffer_pool
+{
+ScanLease::ScanLease(Points && points, std::shared_ptr<ScanBufferPool> pool)
+: points_{std::move(points)}, pool_{std::move(pool)}
+{
+}
+
+ScanLease::~ScanLease() { give_back(); }
+
+ScanLease & ScanLease::operator=(ScanLease && other) noexcept
+{
+  if (this != &other) {
+    give_back();
+    points_ = std::move(other.points_);
+    pool_ = std::move(other.pool_);
+    telemetry_ = other.telemetry_;
+  }
+  return *this;
+}
+
+Points ScanLease::release()
+{
+  pool_.reset();
+  return std::move(points_);
+}
+
+void ScanLease::give_back()
+{
+  if (pool_) {
+    pool_->give_back(std::move(points_));
+    pool_.reset();
+  }
+  points_ = Points();
+  telemetry_ = scan_telemetry::ScanTelemetry();
+}
+
+std::shared_ptr<ScanBufferPool> ScanBufferPool::create(std::size_t count_points_reserved)
+{
+  return std::shared_ptr<ScanBufferPool>(new ScanBufferPool(count_points_reserved));
+}
+
+ScanBufferPool::ScanBufferPool(std::size_t count_points_reserved)
+: count_points_reserved_{count_points_reserved}, count_buffers_allocated_{0U}
+{
+}
+
+void ScanBufferPool::reserve(std::size_t count_points_reserved)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  count_points_reserved_ = std::max(count_points_reserved_, count_points_reserved);
+}
+
+ScanLease ScanBufferPool::acquire()
+{
+  Points points;
+  std::size_t count_points_reserved;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!buffers_free_.empty()) {
+      points = std::move(buffers_free_.back());
+      buffers_free_.pop_back();
+    } else {
+      count_buffers_allocated_++;
+    }
+    count_points_reserved = count_points_reserved_;
+  }
+  if (points.capacity() < count_points_reserved) {
+    points.reserve(count_points_reserved);
+  }
+  return ScanLease(std::move(points), shared_from_this());
+}
+
+std::size_t ScanBufferPool::get_count_buffers_allocated() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return count_buffers_allocated_;
+}
+
+void ScanBufferPool::give_back(Points && points)
+{
+  points.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Reserved once for every buffer in circulation, so recycling doesn't allocate either.
+  if (buffers_free_.capacity() < count_buffers_allocated_) {
+    buffers_free_.reserve(count_buffers_allocated_);
+  }
+  buffers_free_.push_back(std::move(points));
+}
+}  // namespace loam_mapper::points_provider::scan_buffer_pool
@@ -0,0 +1,303 @@
+#include "loam_mapper/sensor_demultiplexer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace loam_mapper::points_provider::sensor_demultiplexer
+{
+namespace
+{
+constexpr std::size_t count_packets_batch = 256;
+// Batches queued per sensor before the pushing thread waits for its worker
+constexpr std::size_t count_batches_in_flight_max = 4;
+// ~10 s of scans. Past that, a sensor holding back the others has its pending packets decoded
+// or its partial scan handed out.
+constexpr std::size_t count_scans_buffered_max = 100;
+
+std::uint64_t get_stamp_unix_nanoseconds_first(
+  const continuous_packet_parser::ContinuousPacketParser::ScanLease & scan)
+{
+  if (scan->empty()) {
+    return 0U;
+  }
+  return scan->stamp_unix_nanoseconds.front();
+}
+}  // namespace
+
+SensorDemultiplexer::SensorDemultiplexer(
+  const std::vector<continuous_packet_parser::ContinuousPacketParser> & parsers,
+  const std::vector<packet_filter::PacketFilter> & packet_filters,
+  CallbackScan callback_scan)
+: callback_scan_{std::move(callback_scan)}, is_input_closed_{false}, is_stopping_{false}
+{
+  if (parsers.size() != packet_filters.size() || parsers.empty()) {
+    throw std::invalid_argument("There should be one parser and one packet filter per sensor.");
+  }
+  for (size_t i = 0; i < parsers.size(); ++i) {
+    auto sensor = std::make_unique<Sensor>();
+    sensor->parser = parsers.at(i);
+    sensor->packet_filter = packet_filters.at(i);
+    sensors_.push_back(std::move(sensor));
+  }
+  for (auto & sensor : sensors_) {
+    sensor->thread = std::thread(&SensorDemultiplexer::run_sensor, this, std::ref(*sensor));
+  }
+}
+
+SensorDemultiplexer::~SensorDemultiplexer() { stop(); }
+
+bool SensorDemultiplexer::push_packet(const std::uint8_t * data, std::size_t length)
+{
+  for (auto & sensor : sensors_) {
+    if (sensor->packet_filter.classify(data, length) == packet_filter::PacketFilter::Kind::Other) {
+      continue;
+    }
+    if (sensor->is_past_time_window) {
+      break;
+    }
+    auto & batch = sensor->batch_pending;
+    batch.bytes.insert(batch.bytes.end(), data, data + length);
+    batch.lengths.push_back(static_cast<std::uint32_t>(length));
+    if (batch.lengths.size() >= count_packets_batch) {
+      flush_batch(*sensor);
+      emit_ready_scans();
+    }
+    break;
+  }
+  return !std::all_of(
+    sensors_.begin(), sensors_.end(),
+    [](const std::unique_ptr<Sensor> & sensor) { return sensor->is_past_time_window.load(); });
+}
+
+void SensorDemultiplexer::finish()
+{
+  for (auto & sensor : sensors_) {
+    if (!sensor->batch_pending.lengths.empty()) {
+      flush_batch(*sensor);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_input_closed_ = true;
+  }
+  cv_.notify_all();
+  for (auto & sensor : sensors_) {
+    sensor->thread.join();
+  }
+  if (exception_) {
+    std::rethrow_exception(exception_);
+  }
+  emit_ready_scans();
+}
+
+void SensorDemultiplexer::run_sensor(Sensor & sensor)
+{
+  const std::function<void(ScanLease)> callback_collect = [this, &sensor](ScanLease scan) {
+    const std::uint64_t stamp_unix_nanoseconds = get_stamp_unix_nanoseconds_first(scan);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sensor.scans.push_back(ScanStamped{stamp_unix_nanoseconds, std::move(scan)});
+    }
+    cv_.notify_all();
+  };
+
+  try {
+    while (true) {
+      PacketBatch batch;
+      bool is_partial_scan_requested = false;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this, &sensor]() {
+          return is_stopping_ || is_input_closed_ || !sensor.batches_filled.empty() ||
+                 sensor.is_partial_scan_requested;
+        });
+        if (is_stopping_) {
+          break;
+        }
+        is_partial_scan_requested = sensor.is_partial_scan_requested;
+        sensor.is_partial_scan_requested = false;
+        if (!is_partial_scan_requested) {
+          if (sensor.batches_filled.empty()) {
+            break;
+          }
+          batch = std::move(sensor.batches_filled.front());
+          sensor.batches_filled.pop_front();
+        }
+        sensor.is_decoding = true;
+      }
+      cv_.notify_all();
+
+      if (is_partial_scan_requested) {
+        hand_out_partial_scan(sensor, callback_collect);
+      } else {
+        size_t offset = 0;
+        for (const auto length : batch.lengths) {
+          sensor.parser.process_packet_into_cloud(
+            batch.bytes.data() + offset, length, callback_collect);
+          offset += length;
+        }
+        if (sensor.parser.is_past_time_window()) {
+          sensor.is_past_time_window = true;
+        }
+        batch.bytes.clear();
+        batch.lengths.clear();
+      }
+
+      const auto & cloud_partial = sensor.parser.get_partial_cloud();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!is_partial_scan_requested) {
+          sensor.batches_free.push_back(std::move(batch));
+        }
+        sensor.is_decoding = false;
+        sensor.has_partial_scan = !cloud_partial.empty();
+        sensor.stamp_unix_nanoseconds_partial_first =
+          cloud_partial.empty() ? 0U : cloud_partial.stamp_unix_nanoseconds.front();
+      }
+      cv_.notify_all();
+    }
+    bool is_stopping;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_stopping = is_stopping_;
+    }
+    // Every packet is decoded
+    if (!is_stopping) {
+      sensor.parser.finish(callback_collect);
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!exception_) {
+      exception_ = std::current_exception();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sensor.is_done = true;
+  }
+  cv_.notify_all();
+}
+
+void SensorDemultiplexer::hand_out_partial_scan(
+  Sensor & sensor, const std::function<void(ScanLease)> & callback_collect)
+{
+  if (sensor.parser.get_partial_cloud().empty()) {
+    return;
+  }
+  // No more points are coming for it, it is what finish() would do with it.
+  if (sensor.parser.is_past_time_window()) {
+    sensor.parser.finish(callback_collect);
+    return;
+  }
+  std::cout << "sensor demultiplexer: handing out a partial scan of a sensor without packets"
+            << std::endl;
+  callback_collect(sensor.parser.take_partial_cloud());
+}
+
+void SensorDemultiplexer::flush_batch(Sensor & sensor)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this, &sensor]() {
+    return exception_ || sensor.is_done ||
+           sensor.batches_filled.size() < count_batches_in_flight_max;
+  });
+  if (exception_) {
+    std::rethrow_exception(exception_);
+  }
+  sensor.batches_filled.push_back(std::move(sensor.batch_pending));
+  // Reuse the buffers of a decoded batch
+  if (sensor.batches_free.empty()) {
+    sensor.batch_pending = PacketBatch();
+    sensor.batch_pending.bytes.reserve(
+      count_packets_batch * packet_filter::PacketFilter::size_data_packet);
+  } else {
+    sensor.batch_pending = std::move(sensor.batches_free.front());
+    sensor.batches_free.pop_front();
+  }
+  lock.unlock();
+  cv_.notify_all();
+}
+
+void SensorDemultiplexer::emit_ready_scans()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    size_t index_sensor_next = sensors_.size();
+    bool has_backlog = false;
+    for (size_t i = 0; i < sensors_.size(); ++i) {
+      const auto & sensor = *sensors_.at(i);
+      if (sensor.scans.empty()) {
+        continue;
+      }
+      has_backlog = has_backlog || sensor.scans.size() > count_scans_buffered_max;
+      if (
+        index_sensor_next == sensors_.size() ||
+        sensor.scans.front().stamp_unix_nanoseconds <
+          sensors_.at(index_sensor_next)->scans.front().stamp_unix_nanoseconds) {
+        index_sensor_next = i;
+      }
+    }
+    if (index_sensor_next == sensors_.size()) {
+      return;
+    }
+    const std::uint64_t stamp_unix_nanoseconds_next =
+      sensors_.at(index_sensor_next)->scans.front().stamp_unix_nanoseconds;
+
+    // A sensor without queued scans can still queue an earlier one from the packets it hasn't
+    // decoded yet, or by completing a partial scan that started earlier. Packets that aren't
+    // pushed yet come after those the queued scans were completed from.
+    bool is_held_back = false;
+    std::vector<Sensor *> sensors_flush;
+    for (auto & sensor_ptr : sensors_) {
+      auto & sensor = *sensor_ptr;
+      if (!sensor.scans.empty() || sensor.is_done) {
+        continue;
+      }
+      const bool has_packets_pending = !sensor.batch_pending.lengths.empty();
+      if (has_packets_pending || !sensor.batches_filled.empty() || sensor.is_decoding) {
+        is_held_back = true;
+        if (has_backlog && has_packets_pending) {
+          sensors_flush.push_back(&sensor);
+        }
+      } else if (
+        sensor.has_partial_scan &&
+        sensor.stamp_unix_nanoseconds_partial_first < stamp_unix_nanoseconds_next) {
+        is_held_back = true;
+        // Its packets stopped mid scan while the others went on
+        if (has_backlog) {
+          sensor.is_partial_scan_requested = true;
+        }
+      }
+    }
+    if (is_held_back) {
+      lock.unlock();
+      cv_.notify_all();
+      for (auto * sensor : sensors_flush) {
+        flush_batch(*sensor);
+      }
+      return;
+    }
+    auto & scans = sensors_.at(index_sensor_next)->scans;
+    ScanStamped scan = std::move(scans.front());
+    scans.pop_front();
+    lock.unlock();
+    callback_scan_(std::move(scan.scan), index_sensor_next);
+    lock.lock();
+  }
+}
+
+void SensorDemultiplexer::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto & sensor : sensors_) {
+    if (sensor->thread.joinable()) {
+      sensor->thread.join();
+    }
+  }
+}
+}  // namespace loam_mapper::points_provider::sensor_demultiplexer
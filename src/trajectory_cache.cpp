@@ -0,0 +1,171 @@
+#include "loam_mapper/trajectory_cache.hpp"
+
+#include "loam_mapper/mapped_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace loam_mapper::transform_provider::trajectory_cache
+{
+namespace
+{
+constexpr char magic_cache[8] = {'L', 'M', 'T', 'R', 'A', 'J', 'C', '\0'};
+constexpr std::uint32_t version_cache = 1U;
+constexpr std::size_t size_bytes_hashed = 64UL * 1024UL;
+
+struct CacheHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t count_columns;
+  std::uint64_t count_poses;
+  std::uint64_t size_source;
+  std::int64_t time_last_write_source;
+  std::uint64_t hash_source;
+  double origin_x;
+  double origin_y;
+  double origin_z;
+} __attribute__((packed));
+// The columns that follow the header are read in place.
+static_assert(sizeof(CacheHeader) % sizeof(double) == 0);
+
+// FNV-1a
+std::uint64_t hash_bytes(const char * data, std::size_t size, std::uint64_t hash)
+{
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<std::uint8_t>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+std::size_t get_size_bytes_columns(std::size_t count_poses)
+{
+  return count_poses * (sizeof(std::uint64_t) + PoseTable::count_columns * sizeof(double));
+}
+}  // namespace
+
+CacheKey CacheKey::make(
+  const fs::path & path_source, double origin_x, double origin_y, double origin_z)
+{
+  CacheKey key;
+  key.size_source = fs::file_size(path_source);
+  key.time_last_write_source = fs::last_write_time(path_source);
+  key.origin_x = origin_x;
+  key.origin_y = origin_y;
+  key.origin_z = origin_z;
+
+  std::ifstream file(path_source.string(), std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path_source.string() + " for reading.");
+  }
+  std::vector<char> buffer(std::min<std::uint64_t>(size_bytes_hashed, key.size_source));
+  std::uint64_t hash = hash_bytes(
+    reinterpret_cast<const char *>(&key.size_source), sizeof(key.size_source),
+    0xcbf29ce484222325ULL);
+  file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  hash = hash_bytes(buffer.data(), buffer.size(), hash);
+  file.seekg(static_cast<std::streamoff>(key.size_source - buffer.size()));
+  file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  hash = hash_bytes(buffer.data(), buffer.size(), hash);
+  if (!file) {
+    throw std::runtime_error("Cannot read " + path_source.string());
+  }
+  key.hash_source = hash;
+  return key;
+}
+
+bool CacheKey::operator==(const CacheKey & other) const
+{
+  return size_source == other.size_source &&
+         time_last_write_source == other.time_last_write_source &&
+         hash_source == other.hash_source && origin_x == other.origin_x &&
+         origin_y == other.origin_y && origin_z == other.origin_z;
+}
+
+bool TrajectoryCache::load(const fs::path & path_cache, const CacheKey & key, PoseTable & poses)
+{
+  if (!fs::exists(path_cache)) {
+    return false;
+  }
+  std::shared_ptr<const mapped_file::MappedFile> file;
+  try {
+    file = std::make_shared<const mapped_file::MappedFile>(path_cache);
+  } catch (const std::exception & ex) {
+    std::cerr << "Cannot load trajectory cache: " << ex.what() << std::endl;
+    return false;
+  }
+  if (file->size() < sizeof(CacheHeader)) {
+    return false;
+  }
+  CacheHeader header{};
+  std::memcpy(&header, file->data(), sizeof(header));
+  CacheKey key_cache;
+  key_cache.size_source = header.size_source;
+  key_cache.time_last_write_source = header.time_last_write_source;
+  key_cache.hash_source = header.hash_source;
+  key_cache.origin_x = header.origin_x;
+  key_cache.origin_y = header.origin_y;
+  key_cache.origin_z = header.origin_z;
+  if (
+    std::memcmp(header.magic, magic_cache, sizeof(magic_cache)) != 0 ||
+    header.version != version_cache || header.count_columns != PoseTable::count_columns ||
+    key_cache != key ||
+    file->size() != sizeof(CacheHeader) + get_size_bytes_columns(header.count_poses)) {
+    return false;
+  }
+  const char * columns = file->data() + sizeof(CacheHeader);
+  poses = PoseTable(header.count_poses, columns, std::move(file));
+  return true;
+}
+
+void TrajectoryCache::save(
+  const fs::path & path_cache, const CacheKey & key, const PoseTable & poses)
+{
+  // Written aside and renamed over the old cache, which another run may still have mapped.
+  const fs::path path_temporary(path_cache.string() + ".tmp");
+  {
+    std::ofstream file(path_temporary.string(), std::ios::binary | std::ios::trunc);
+    if (!file) {
+      throw std::runtime_error("Cannot open " + path_temporary.string() + " for writing.");
+    }
+    CacheHeader header{};
+    std::memcpy(header.magic, magic_cache, sizeof(magic_cache));
+    header.version = version_cache;
+    header.count_columns = PoseTable::count_columns;
+    header.count_poses = poses.size();
+    header.size_source = key.size_source;
+    header.time_last_write_source = key.time_last_write_source;
+    header.hash_source = key.hash_source;
+    header.origin_x = key.origin_x;
+    header.origin_y = key.origin_y;
+    header.origin_z = key.origin_z;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(
+      reinterpret_cast<const char *>(poses.get_stamps_unix_nanoseconds()),
+      static_cast<std::streamsize>(poses.size() * sizeof(std::uint64_t)));
+    for (std::size_t i = 0; i < PoseTable::count_columns; ++i) {
+      file.write(
+        reinterpret_cast<const char *>(poses.get_column(static_cast<PoseTable::Column>(i))),
+        static_cast<std::streamsize>(poses.size() * sizeof(double)));
+    }
+    if (!file) {
+      throw std::runtime_error("Cannot write " + path_temporary.string());
+    }
+  }
+  fs::rename(path_temporary, path_cache);
+}
+
+fs::path TrajectoryCache::get_path_cache(const fs::path & path_source)
+{
+  return fs::path(path_source.string() + ".cache");
+}
+
+}  // namespace loam_mapper::transform_provider::trajectory_cache
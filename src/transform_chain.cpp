@@ -0,0 +1,113 @@
+#include "loam_mapper/transform_chain.hpp"
+
+#include "loam_mapper/utils.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <execution>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace loam_mapper::transform_provider::transform_chain
+{
+namespace
+{
+// Points transformed by one task of the parallel loop
+constexpr std::size_t size_chunk = 4096;
+
+// Branch free over contiguous columns, so the compiler can vectorize it. The points are rotated
+// by the static part first, then by the 3x4 matrix of their pose built from its quaternion, which
+// interpolation keeps normalized.
+void apply_chunk(
+  const std::array<double, 9> & r, const point_types::PointColumnsXYZITRH & cloud,
+  const pose_interpolation::PoseColumns & poses, point_types::PointColumnsXYZITRH & cloud_trans,
+  std::size_t offset, std::size_t count)
+{
+  const float * x_in = cloud.x.data() + offset;
+  const float * y_in = cloud.y.data() + offset;
+  const float * z_in = cloud.z.data() + offset;
+  const double * tx = poses.x.data() + offset;
+  const double * ty = poses.y.data() + offset;
+  const double * tz = poses.z.data() + offset;
+  const double * qx = poses.orientation_x.data() + offset;
+  const double * qy = poses.orientation_y.data() + offset;
+  const double * qz = poses.orientation_z.data() + offset;
+  const double * qw = poses.orientation_w.data() + offset;
+  float * x_out = cloud_trans.x.data() + offset;
+  float * y_out = cloud_trans.y.data() + offset;
+  float * z_out = cloud_trans.z.data() + offset;
+  for (std::size_t i = 0; i < count; ++i) {
+    const double px = x_in[i];
+    const double py = y_in[i];
+    const double pz = z_in[i];
+    const double sx = r[0] * px + r[1] * py + r[2] * pz;
+    const double sy = r[3] * px + r[4] * py + r[5] * pz;
+    const double sz = r[6] * px + r[7] * py + r[8] * pz;
+
+    const double xx = qx[i] * qx[i];
+    const double yy = qy[i] * qy[i];
+    const double zz = qz[i] * qz[i];
+    const double xy = qx[i] * qy[i];
+    const double xz = qx[i] * qz[i];
+    const double yz = qy[i] * qz[i];
+    const double wx = qw[i] * qx[i];
+    const double wy = qw[i] * qy[i];
+    const double wz = qw[i] * qz[i];
+    x_out[i] = static_cast<float>(
+      (1.0 - 2.0 * (yy + zz)) * sx + 2.0 * (xy - wz) * sy + 2.0 * (xz + wy) * sz + tx[i]);
+    y_out[i] = static_cast<float>(
+      2.0 * (xy + wz) * sx + (1.0 - 2.0 * (xx + zz)) * sy + 2.0 * (yz - wx) * sz + ty[i]);
+    z_out[i] = static_cast<float>(
+      2.0 * (xz - wy) * sx + 2.0 * (yz + wx) * sy + (1.0 - 2.0 * (xx + yy)) * sz + tz[i]);
+  }
+}
+}  // namespace
+
+TransformChain::TransformChain(
+  double roll_deg, double pitch_deg, double yaw_deg, bool is_converting_ned2enu)
+{
+  Eigen::Matrix3d rotation =
+    (Eigen::AngleAxisd(utils::Utils::deg_to_rad(yaw_deg), Eigen::Vector3d::UnitZ()) *
+     Eigen::AngleAxisd(utils::Utils::deg_to_rad(pitch_deg), Eigen::Vector3d::UnitY()) *
+     Eigen::AngleAxisd(utils::Utils::deg_to_rad(roll_deg), Eigen::Vector3d::UnitX()))
+      .toRotationMatrix();
+  if (is_converting_ned2enu) {
+    const Eigen::Matrix3d ned2enu =
+      (Eigen::AngleAxisd(utils::Utils::deg_to_rad(-90.0), Eigen::Vector3d::UnitZ()) *
+       Eigen::AngleAxisd(utils::Utils::deg_to_rad(180.0), Eigen::Vector3d::UnitX()))
+        .toRotationMatrix();
+    rotation = rotation * ned2enu;
+  }
+  for (Eigen::Index row = 0; row < 3; ++row) {
+    for (Eigen::Index col = 0; col < 3; ++col) {
+      rotation_static_[static_cast<std::size_t>(row * 3 + col)] = rotation(row, col);
+    }
+  }
+}
+
+void TransformChain::apply(
+  const point_types::PointColumnsXYZITRH & cloud, const pose_interpolation::PoseColumns & poses,
+  point_types::PointColumnsXYZITRH & cloud_trans) const
+{
+  const std::size_t count = cloud.size();
+  if (poses.size() != count || cloud_trans.size() != count) {
+    throw std::length_error(
+      "cloud of " + std::to_string(count) + " points was expected to come with as many poses and "
+      "output points but it got " + std::to_string(poses.size()) + " and " +
+      std::to_string(cloud_trans.size()));
+  }
+  std::vector<std::size_t> offsets_chunk;
+  for (std::size_t offset = 0; offset < count; offset += size_chunk) {
+    offsets_chunk.push_back(offset);
+  }
+  std::for_each(
+    std::execution::par, offsets_chunk.cbegin(), offsets_chunk.cend(),
+    [this, &cloud, &poses, &cloud_trans, count](std::size_t offset_chunk) {
+      apply_chunk(
+        rotation_static_, cloud, poses, cloud_trans, offset_chunk,
+        std::min(size_chunk, count - offset_chunk));
+    });
+}
+}  // namespace loam_mapper::transform_provider::transform_chain
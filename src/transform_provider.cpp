@@ -1,11 +1,21 @@
 #include "loam_mapper/transform_provider.hpp"
-#include "loam_mapper/csv.hpp"
+
+#include "loam_mapper/mapped_file.hpp"
+#include "loam_mapper/trajectory_cache.hpp"
+
 #include <string>
 #include <array>
-#include <sstream>
+#include <cmath>
+#include <charconv>
+#include <chrono>
+#include <cstring>
 #include <exception>
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
 #include <Eigen/Geometry>
 #include <GeographicLib/LocalCartesian.hpp>
 #include "loam_mapper/date.h"
@@ -13,6 +23,213 @@
 
 namespace loam_mapper::transform_provider
 {
+namespace
+{
+// Columns of the data lines of an Applanix ASCII export
+enum Column : size_t {
+  column_time,                // UTC seconds since the midnight of the mission date
+  column_distance,            // in meters
+  column_easting,             // in meters
+  column_northing,            // in meters
+  column_height_orthometric,  // in meters
+  column_latitude,            // in degrees
+  column_longitude,           // in degrees
+  column_height_ellipsoid,    // in meters
+  column_roll,                // in degrees
+  column_pitch,               // in degrees
+  column_heading,             // in degrees
+  column_velocity_east,       // in meters per second
+  column_velocity_north,
+  column_velocity_up,
+  column_angular_rate_x,
+  column_angular_rate_y,
+  column_angular_rate_z,
+  column_acceleration_x,
+  column_acceleration_y,
+  column_acceleration_z,
+  column_sd_east,     // in meters
+  column_sd_north,    // in meters
+  column_sd_height,   // in meters
+  column_sd_roll,     // in degrees
+  column_sd_pitch,    // in degrees
+  column_sd_heading,  // in degrees
+  count_columns
+};
+using Fields = std::array<double, count_columns>;
+
+// The mission date is on the 16th line of the export, as dd/mm/yyyy from its 21st character.
+constexpr size_t index_line_mission_date = 15;
+constexpr size_t index_char_mission_date = 20;
+// The column names are followed by two lines of units and a blank line.
+constexpr size_t count_lines_after_header = 3;
+// Below this, splitting the data lines over more threads isn't worth it.
+constexpr size_t size_bytes_chunk_min = 1024UL * 1024UL;
+
+// Data lines of the export that are parsed by one thread
+struct Chunk
+{
+  const char * begin{nullptr};
+  const char * end{nullptr};
+  // Lines that aren't blank
+  size_t count_lines{0U};
+  // Where the poses of the chunk go in poses_
+  size_t index_pose_first{0U};
+  size_t count_poses{0U};
+  std::string line_malformed;
+};
+
+const char * find_line_end(const char * begin, const char * end)
+{
+  const auto * line_end =
+    static_cast<const char *>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+  return line_end == nullptr ? end : line_end;
+}
+
+// Start of the first line at or after position
+const char * find_line_begin(const char * position, const char * end)
+{
+  if (position == end || position[-1] == '\n') {
+    return position;
+  }
+  return std::min(find_line_end(position, end) + 1, end);
+}
+
+// Fields are separated by spaces, tabs or commas, lines may end with a carriage return.
+bool is_separator(char character)
+{
+  return character == ' ' || character == '\t' || character == ',' || character == '\r';
+}
+
+bool is_blank(const char * begin, const char * end)
+{
+  return std::all_of(begin, end, is_separator);
+}
+
+size_t count_lines_not_blank(const char * begin, const char * end)
+{
+  size_t count = 0;
+  for (const char * line = begin; line < end;) {
+    const char * line_end = find_line_end(line, end);
+    count += is_blank(line, line_end) ? 0U : 1U;
+    line = line_end + 1;
+  }
+  return count;
+}
+
+bool parse_fields(const char * begin, const char * end, Fields & fields)
+{
+  const char * cursor = begin;
+  for (auto & field : fields) {
+    while (cursor < end && is_separator(*cursor)) {
+      ++cursor;
+    }
+    const auto result = std::from_chars(cursor, end, field);
+    if (result.ec != std::errc()) {
+      return false;
+    }
+    cursor = result.ptr;
+  }
+  return std::all_of(cursor, end, is_separator);
+}
+
+date::sys_days parse_mission_date(std::string_view line)
+{
+  int days = 0;
+  int months = 0;
+  int years = 0;
+  const char * cursor = line.data() + std::min(index_char_mission_date, line.size());
+  const char * end = line.data() + line.size();
+  bool is_valid = true;
+  for (int * value : {&days, &months, &years}) {
+    while (cursor < end && *cursor == ' ') {
+      ++cursor;
+    }
+    const auto result = std::from_chars(cursor, end, *value);
+    is_valid = is_valid && result.ec == std::errc();
+    cursor = result.ptr;
+    if (value != &years) {
+      is_valid = is_valid && cursor < end && *cursor == '/';
+      ++cursor;
+    }
+    if (!is_valid) {
+      break;
+    }
+  }
+  const date::year_month_day date_mission =
+    date::year{years} / static_cast<unsigned>(months) / static_cast<unsigned>(days);
+  if (!is_valid || !date_mission.ok()) {
+    throw std::runtime_error(
+      "mission date was expected to be dd/mm/yyyy but the line is: " + std::string(line));
+  }
+  return date::sys_days(date_mission);
+}
+
+void set_pose(
+  PoseTable & poses, size_t index, const Fields & fields, date::sys_days day_mission,
+  double origin_x, double origin_y, double origin_z)
+{
+  PoseTable::Values values;
+  values[PoseTable::column_x] = fields[column_easting] - origin_x;
+  values[PoseTable::column_y] = fields[column_northing] - origin_y;
+  values[PoseTable::column_z] = fields[column_height_ellipsoid] - origin_z;
+  Eigen::AngleAxisd angle_axis_x(
+    utils::Utils::deg_to_rad(fields[column_roll]), Eigen::Vector3d::UnitY());
+  Eigen::AngleAxisd angle_axis_y(
+    utils::Utils::deg_to_rad(fields[column_pitch]), Eigen::Vector3d::UnitX());
+  Eigen::AngleAxisd angle_axis_z(
+    utils::Utils::deg_to_rad(-fields[column_heading]), Eigen::Vector3d::UnitZ());
+
+  Eigen::Quaterniond q = (angle_axis_z * angle_axis_y * angle_axis_x);
+  values[PoseTable::column_orientation_x] = q.x();
+  values[PoseTable::column_orientation_y] = q.y();
+  values[PoseTable::column_orientation_z] = q.z();
+  values[PoseTable::column_orientation_w] = q.w();
+
+  // North first, as the covariance has always been filled
+  values[PoseTable::column_variance_x] = std::pow(fields[column_sd_north], 2);
+  values[PoseTable::column_variance_y] = std::pow(fields[column_sd_east], 2);
+  values[PoseTable::column_variance_z] = std::pow(fields[column_sd_height], 2);
+  values[PoseTable::column_variance_roll] = std::pow(fields[column_sd_roll], 2);
+  values[PoseTable::column_variance_pitch] = std::pow(fields[column_sd_pitch], 2);
+  values[PoseTable::column_variance_yaw] = std::pow(fields[column_sd_heading], 2);
+
+  // The export has millisecond resolution, rounding keeps e.g. 36000.005 from becoming 4 ms.
+  const std::chrono::milliseconds milliseconds_since_midnight(
+    std::llround(fields[column_time] * 1000.0));
+  const auto tp = day_mission + milliseconds_since_midnight;
+  poses.set(
+    index,
+    static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count()),
+    values);
+}
+
+// Runs function on every chunk, each on its own thread. Rethrows the first exception.
+template <typename Function>
+void run_in_parallel(std::vector<Chunk> & chunks, Function function)
+{
+  std::vector<std::exception_ptr> exceptions(chunks.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    threads.emplace_back([&chunks, &exceptions, &function, i]() {
+      try {
+        function(chunks.at(i));
+      } catch (...) {
+        exceptions.at(i) = std::current_exception();
+      }
+    });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  for (const auto & exception : exceptions) {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+}
+}  // namespace
+
 TransformProvider::TransformProvider(
   const std::string & path_file_ascii_output)
 : path_file_ascii_output_(path_file_ascii_output)
@@ -29,207 +246,193 @@ TransformProvider::TransformProvider(
 
 void TransformProvider::process(double origin_x, double origin_y, double origin_z)
 {
-  io::LineReader lines(path_file_ascii_output_.string());
-  double line_number = 1;
-  while (char * line = lines.next_line()) {
-    if (line_number == 16) {  // 16 is the mission date line in the applanix export file
-      mission_date += line;
-      mission_date.erase(0, 20);  // erases 20 characters from 0.
-      std::cout << "mission_date: " << mission_date << std::endl;
-      break;
-    }
-    if (line_number == 29) {  // 29 is the first data line. UTC Time is wanted
-      time_string += line;
-      time_string.erase(11, 188);  // only the time left in the string
-      break;
-    }
-    line_number++;
+  using trajectory_cache::TrajectoryCache;
+  const auto time_start = std::chrono::steady_clock::now();
+  const fs::path path_cache = TrajectoryCache::get_path_cache(path_file_ascii_output_);
+  const auto key =
+    trajectory_cache::CacheKey::make(path_file_ascii_output_, origin_x, origin_y, origin_z);
+  if (TrajectoryCache::load(path_cache, key, poses_)) {
+    lookup_ = pose_lookup::PoseLookup(poses_);
+    std::cout << "trajectory: " << poses_.size() << " poses mapped from " << path_cache
+              << std::endl;
+    return;
   }
 
-  std::string temp_pose_file = "temp_pose_file.csv";
-  {
-    std::ifstream filein(path_file_ascii_output_.string());  // File to read from
-    std::ofstream fileout(temp_pose_file);    // Temporary file
-    if (!filein || !fileout) {
-      // throw exception
-      throw(std::runtime_error("Error opening file"));
+  parse_ascii_output(origin_x, origin_y, origin_z);
+  lookup_ = pose_lookup::PoseLookup(poses_);
+  std::cout << "trajectory: " << poses_.size() << " poses parsed in "
+            << std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - time_start)
+                 .count()
+            << " ms" << std::endl;
+  try {
+    TrajectoryCache::save(path_cache, key, poses_);
+  } catch (const std::exception & ex) {
+    // A read only trajectory folder only costs the parsing on the next run.
+    std::cerr << "Cannot save trajectory cache: " << ex.what() << std::endl;
+  }
+}
+
+void TransformProvider::parse_ascii_output(double origin_x, double origin_y, double origin_z)
+{
+  const mapped_file::MappedFile file(path_file_ascii_output_);
+  file.advise_will_need();
+  const char * const data_end = file.data() + file.size();
+
+  // The header is read line by line up to the column names, the data lines follow their units.
+  const char * cursor = file.data();
+  const char * data_begin = nullptr;
+  std::string_view line_mission_date;
+  for (size_t index_line = 0; cursor < data_end; ++index_line) {
+    const char * line_end = find_line_end(cursor, data_end);
+    const std::string_view line(cursor, static_cast<size_t>(line_end - cursor));
+    cursor = line_end == data_end ? data_end : line_end + 1;
+    if (index_line == index_line_mission_date) {
+      line_mission_date = line;
     }
-    std::string line;
-    bool header_is_found = false;
-    size_t line_number_header = 0;
-    size_t line_number_current = 0;
-
-    while (std::getline(filein, line)) {
-      line_number_current++;
-
-      // fix the header line
-      if (line.find("TIME,") != std::string::npos) {
-        line_number_header = line_number_current;
-        header_is_found = true;
-
-        // separate line into tokens by comma
-        std::stringstream ss(line);
-        std::string token;
-        std::vector<std::string> tokens;
-        while (std::getline(ss, token, ',')) {
-          // remove leading and trailing spaces
-          token.erase(0, token.find_first_not_of(' '));
-          token.erase(token.find_last_not_of(' ') + 1);
-          // replace spaces with underscores
-          std::replace(token.begin(), token.end(), ' ', '_');
-          tokens.push_back(token);
-        }
-        // concatenate tokens with spaces
-        std::string new_line;
-        for (const auto & token : tokens) {
-          new_line += token + ",";
-        }
-        // remove last comma
-        new_line.pop_back();
-        line = new_line;
-      }
-      // fix the data lines to be csv like
-      if (line_number_current > line_number_header + 3 && header_is_found) {
-        // replace multiple spaces with single space
-        line.erase(
-          std::unique(
-            line.begin(), line.end(), [](char a, char b) { return isspace(a) && isspace(b); }),
-          line.end());
-        // replace spaces with commas
-        std::replace(line.begin(), line.end(), '\t', ',');
-        line.pop_back();
+    if (line.find("TIME,") != std::string_view::npos) {
+      for (size_t i = 0; i < count_lines_after_header && cursor < data_end; ++i) {
+        cursor = std::min(find_line_end(cursor, data_end) + 1, data_end);
       }
-      fileout << line << std::endl;
+      data_begin = cursor;
+      break;
     }
   }
+  if (data_begin == nullptr) {
+    throw std::runtime_error(
+      "trajectory has no TIME column header: " + path_file_ascii_output_.string());
+  }
+  const date::sys_days day_mission = parse_mission_date(line_mission_date);
+  std::cout << "mission_date: " << date::year_month_day(day_mission) << std::endl;
 
-  io::CSVReader<26, io::trim_chars<','>> csv_global_pose(temp_pose_file);
-  for (int i = 0; i < 24; ++i) csv_global_pose.next_line();
-
-  // take only what you need
-  csv_global_pose.read_header(
-    //                line_char,
-    io::ignore_no_column, "TIME", "DISTANCE", "EASTING", "NORTHING", "ORTHOMETRIC_HEIGHT",
-    "LATITUDE", "LONGITUDE", "ELLIPSOID_HEIGHT", "ROLL", "PITCH", "HEADING", "EAST_VELOCITY",
-    "NORTH_VELOCITY", "UP_VELOCITY", "X_ANGULAR_RATE", "Y_ANGULAR_RATE", "Z_ANGULAR_RATE",
-    "X_ACCELERATION", "Y_ACCELERATION", "Z_ACCELERATION", "EAST_SD", "NORTH_SD", "HEIGHT_SD",
-    "ROLL_SD", "PITCH_SD", "HEADING_SD");
-  // Skip "units" line
-  csv_global_pose.next_line();
-  csv_global_pose.next_line();
-  csv_global_pose.next_line();
-  struct Transform
-  {
-    double utc_time;            // in seconds
-    double distance;            // in meters
-    double easting;             // in meters
-    double northing;            // in meters
-    double orthometric_height;  // in meters
-    double latitude;            // in degrees
-    double longitude;           // in degrees
-    double ellipsoid_height;    // in meters
-    double roll;                // in degrees
-    double pitch;               // in degrees
-    double heading;             // in degrees
-    double east_vel;            // in Meter/Sec
-    double north_vel;           // in Meter/Sec
-    double up_vel;              // in Meter/Sec
-    double x_angular_rate;      // in meters
-    double y_angular_rate;      // in meters
-    double z_angular_rate;      // in meters
-    double x_acceleration;      // in meters
-    double y_acceleration;      // in meters
-    double z_acceleration;      // in meters
-
-    double east_std;     // in meters
-    double north_std;    // in meters
-    double height_std;   // in meters
-    double roll_std;     // in degrees
-    double pitch_std;    // in degrees
-    double heading_std;  // in degrees
-  } in;
+  // Chunks of whole lines, parsed in parallel into their own part of poses_
+  const size_t count_threads = std::max(
+    size_t{1U},
+    std::min<size_t>(
+      std::thread::hardware_concurrency(),
+      static_cast<size_t>(data_end - data_begin) / size_bytes_chunk_min));
+  std::vector<Chunk> chunks(count_threads);
+  for (size_t i = 0; i < count_threads; ++i) {
+    auto & chunk = chunks.at(i);
+    chunk.begin = i == 0 ? data_begin : chunks.at(i - 1).end;
+    chunk.end = i + 1 == count_threads
+                  ? data_end
+                  : find_line_begin(
+                      data_begin + (data_end - data_begin) * static_cast<std::ptrdiff_t>(i + 1) /
+                                     static_cast<std::ptrdiff_t>(count_threads),
+                      data_end);
+    chunk.end = std::max(chunk.end, chunk.begin);
+  }
+  run_in_parallel(chunks, [](Chunk & chunk) {
+    chunk.count_lines = count_lines_not_blank(chunk.begin, chunk.end);
+  });
 
-  try {
-    data_line_number = csv_global_pose.get_file_line() + 1;
-    while (csv_global_pose.read_row(
-      in.utc_time, in.distance, in.easting, in.northing, in.orthometric_height, in.latitude,
-      in.longitude, in.ellipsoid_height, in.roll, in.pitch, in.heading, in.east_vel, in.north_vel,
-      in.up_vel, in.x_angular_rate, in.y_angular_rate, in.z_angular_rate, in.x_acceleration,
-      in.y_acceleration, in.z_acceleration, in.east_std, in.north_std, in.height_std, in.roll_std,
-      in.pitch_std, in.heading_std)) {
-      Pose pose;
-      pose.pose_with_covariance.pose.position.set__x(in.easting - origin_x);
-      pose.pose_with_covariance.pose.position.set__y(in.northing - origin_y);
-      pose.pose_with_covariance.pose.position.set__z(in.ellipsoid_height - origin_z);
-      Eigen::AngleAxisd angle_axis_x(utils::Utils::deg_to_rad(in.roll), Eigen::Vector3d::UnitY());
-      Eigen::AngleAxisd angle_axis_y(utils::Utils::deg_to_rad(in.pitch), Eigen::Vector3d::UnitX());
-      Eigen::AngleAxisd angle_axis_z(
-        utils::Utils::deg_to_rad(-in.heading), Eigen::Vector3d::UnitZ());
-
-      Eigen::Quaterniond q = (angle_axis_z * angle_axis_y * angle_axis_x);
-      pose.pose_with_covariance.pose.orientation.set__x(q.x());
-      pose.pose_with_covariance.pose.orientation.set__y(q.y());
-      pose.pose_with_covariance.pose.orientation.set__z(q.z());
-      pose.pose_with_covariance.pose.orientation.set__w(q.w());
-
-      auto segments = utils::Utils::string_to_vec_split_by(mission_date, '/');
-
-      int days_raw = std::stoi(segments.at(0));
-      int months_raw = std::stoi(segments.at(1));
-      int years_raw = std::stoi(segments.at(2));
-
-      date::year_month_day date_current_ = date::year{years_raw} / months_raw / days_raw;
-      date::hh_mm_ss time_since_midnight =
-        date::make_time(std::chrono::milliseconds(static_cast<uint64_t>(in.utc_time * 1000)));
-
-      auto tp = date::sys_days(date_current_) + std::chrono::hours{time_since_midnight.hours()} +
-                std::chrono::minutes{time_since_midnight.minutes()} +
-                std::chrono::seconds{time_since_midnight.seconds()};
-
-      pose.stamp_unix_seconds = std::chrono::seconds(tp.time_since_epoch()).count();
-      pose.stamp_nanoseconds = std::chrono::nanoseconds(time_since_midnight.subseconds()).count();
-
-      std::array<double, 6> variances{
-        std::pow(in.north_std, 2), std::pow(in.east_std, 2),  std::pow(in.height_std, 2),
-        std::pow(in.roll_std, 2),  std::pow(in.pitch_std, 2), std::pow(in.heading_std, 2),
-      };
-
-      //  0  1  2  3  4  5
-      //  6  7  8  9  10 11
-      //  12 13 14 15 16 17
-      //  18 19 20 21 22 23
-      //  24 25 26 27 28 29
-      //  30 31 32 33 34 35
-      //  fill diagonal with variances
-      for (size_t i = 0; i < 6; ++i) {
-        pose.pose_with_covariance.covariance.at(i * 7) = variances.at(i);
+  size_t count_lines_total = 0;
+  for (auto & chunk : chunks) {
+    chunk.index_pose_first = count_lines_total;
+    count_lines_total += chunk.count_lines;
+  }
+  poses_ = PoseTable(count_lines_total);
+
+  run_in_parallel(chunks, [this, day_mission, origin_x, origin_y, origin_z](Chunk & chunk) {
+    Fields fields;
+    size_t index_pose = chunk.index_pose_first;
+    for (const char * line = chunk.begin; line < chunk.end;) {
+      const char * line_end = find_line_end(line, chunk.end);
+      if (!is_blank(line, line_end)) {
+        if (!parse_fields(line, line_end, fields)) {
+          chunk.line_malformed = std::string(line, line_end);
+          break;
+        }
+        set_pose(poses_, index_pose++, fields, day_mission, origin_x, origin_y, origin_z);
       }
-      poses_.push_back(pose);
+      line = line_end + 1;
+    }
+    chunk.count_poses = index_pose - chunk.index_pose_first;
+  });
+
+  // Reading stops at the first malformed line.
+  for (const auto & chunk : chunks) {
+    if (!chunk.line_malformed.empty()) {
+      std::cerr << "trajectory reading stopped at a line that isn't " << count_columns
+                << " numbers: " << chunk.line_malformed << std::endl;
+      poses_.truncate(chunk.index_pose_first + chunk.count_poses);
+      break;
     }
-  } catch (const std::exception & ex) {
-    std::cerr << "Probably empty lines at the end of csv, no problems: " << ex.what() << std::endl;
   }
 }
 
 TransformProvider::Pose TransformProvider::get_pose_at(
   uint32_t stamp_unix_seconds,
-  uint32_t stamp_nanoseconds)
-{
-  Pose pose_search;
-  pose_search.stamp_unix_seconds = stamp_unix_seconds;
-  pose_search.stamp_nanoseconds = stamp_nanoseconds;
-  auto iter_result = std::lower_bound(
-    poses_.begin(), poses_.end(), pose_search,
-    [](const Pose & p1, const Pose & p2) {
-      if (p1.stamp_unix_seconds == p2.stamp_unix_seconds) {
-        return p1.stamp_nanoseconds < p2.stamp_nanoseconds;
-      }
-      return p1.stamp_unix_seconds < p2.stamp_unix_seconds;
-    });
+  uint32_t stamp_nanoseconds) const
+{
+  return get_pose_at(static_cast<uint64_t>(stamp_unix_seconds) * 1000000000U + stamp_nanoseconds);
+}
 
-  size_t index = std::distance(poses_.begin(), iter_result);
-  //  std::cout << "ind: " << index << std::endl;
-  return poses_.at(index);
+TransformProvider::Pose TransformProvider::get_pose_at(uint64_t stamp_unix_nanoseconds) const
+{
+  if (poses_.size() == 0) {
+    throw std::length_error("there are no poses in the trajectory.");
+  }
+  pose_lookup::PoseLookup::Cursor cursor{pose_lookup::PoseLookup::Mode::Random};
+  const size_t index = lookup_.find_index_at_or_after(stamp_unix_nanoseconds, cursor);
+  return get_pose(std::min(index, poses_.size() - 1));
+}
+
+void TransformProvider::get_poses_interpolated_at(
+  const uint64_t * stamps_unix_nanoseconds, size_t count,
+  pose_interpolation::PoseColumns & poses) const
+{
+  pose_interpolation::interpolate(poses_, lookup_, stamps_unix_nanoseconds, count, poses);
+}
+
+TransformProvider::Pose TransformProvider::get_pose(size_t index) const
+{
+  if (index >= poses_.size()) {
+    throw std::out_of_range(
+      "pose index " + std::to_string(index) + " is past the " + std::to_string(poses_.size()) +
+      " poses of the trajectory.");
+  }
+  const uint64_t stamp_unix_nanoseconds = poses_.get_stamps_unix_nanoseconds()[index];
+  const PoseTable::Values values = poses_.get_values(index);
+  Pose pose;
+  pose.stamp_unix_seconds = static_cast<uint32_t>(stamp_unix_nanoseconds / 1000000000U);
+  pose.stamp_nanoseconds = static_cast<uint32_t>(stamp_unix_nanoseconds % 1000000000U);
+  auto & pose_with_covariance = pose.pose_with_covariance;
+  pose_with_covariance.pose.position.set__x(values[PoseTable::column_x]);
+  pose_with_covariance.pose.position.set__y(values[PoseTable::column_y]);
+  pose_with_covariance.pose.position.set__z(values[PoseTable::column_z]);
+  pose_with_covariance.pose.orientation.set__x(values[PoseTable::column_orientation_x]);
+  pose_with_covariance.pose.orientation.set__y(values[PoseTable::column_orientation_y]);
+  pose_with_covariance.pose.orientation.set__z(values[PoseTable::column_orientation_z]);
+  pose_with_covariance.pose.orientation.set__w(values[PoseTable::column_orientation_w]);
+  //  0  1  2  3  4  5
+  //  6  7  8  9  10 11
+  //  12 13 14 15 16 17
+  //  18 19 20 21 22 23
+  //  24 25 26 27 28 29
+  //  30 31 32 33 34 35
+  //  fill diagonal with variances
+  for (size_t i = 0; i < 6; ++i) {
+    pose_with_covariance.covariance.at(i * 7) = values.at(PoseTable::column_variance_x + i);
+  }
+  return pose;
+}
+
+uint64_t TransformProvider::get_stamp_unix_nanoseconds_first() const
+{
+  if (poses_.empty()) {
+    throw std::length_error("poses_ is empty.");
+  }
+  return poses_.get_stamps_unix_nanoseconds()[0];
+}
+
+uint64_t TransformProvider::get_stamp_unix_nanoseconds_last() const
+{
+  if (poses_.empty()) {
+    throw std::length_error("poses_ is empty.");
+  }
+  return poses_.get_stamps_unix_nanoseconds()[poses_.size() - 1];
 }
 
 }  // loam_mapper::transform_provider
@@ -0,0 +1,118 @@
+#include "loam_mapper/velodyne_calibration.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace loam_mapper::points_provider::velodyne_calibration
+{
+namespace
+{
+constexpr float meters_per_centimeter = 0.01F;
+
+float rad_to_deg(double angle_rad) { return static_cast<float>(angle_rad * 180.0 / M_PI); }
+
+void insert_laser(
+  std::map<std::size_t, LaserCorrection> & lasers, std::size_t laser,
+  const LaserCorrection & laser_correction)
+{
+  if (!lasers.emplace(laser, laser_correction).second) {
+    throw std::runtime_error("calibration has laser id " + std::to_string(laser) + " twice");
+  }
+}
+}  // namespace
+
+Calibration Calibration::load(const fs::path & path)
+{
+  std::ifstream stream(path.string());
+  if (!stream) {
+    throw std::runtime_error("Cannot open calibration: " + path.string());
+  }
+  const std::string extension = path.extension().string();
+  Calibration calibration;
+  if (extension == ".xml") {
+    calibration = parse_db_xml(stream);
+  } else if (extension == ".yaml" || extension == ".yml") {
+    calibration = parse_yaml(stream);
+  } else {
+    throw std::invalid_argument(
+      "calibration was expected to be a .xml or .yaml file but it was: " + path.string());
+  }
+  std::cout << "calibration: " << path << " " << calibration.get_count_lasers() << " lasers"
+            << std::endl;
+  return calibration;
+}
+
+Calibration Calibration::parse_db_xml(std::istream & stream)
+{
+  namespace pt = boost::property_tree;
+  pt::ptree tree;
+  pt::read_xml(stream, tree);
+
+  std::map<std::size_t, LaserCorrection> lasers;
+  for (const auto & item : tree.get_child("boost_serialization.DB.points_")) {
+    if (item.first != "item") {
+      continue;
+    }
+    const pt::ptree & px = item.second.get_child("px");
+    LaserCorrection laser_correction;
+    laser_correction.angle_deg_vertical = px.get<float>("vertCorrection_");
+    // The azimuth of the laser's firings is reduced by the rotational correction.
+    laser_correction.angle_deg_azimuth_offset = -px.get<float>("rotCorrection_");
+    laser_correction.meters_distance_offset =
+      px.get<float>("distCorrection_", 0.0F) * meters_per_centimeter;
+    laser_correction.meters_vertical_offset =
+      px.get<float>("vertOffsetCorrection_", 0.0F) * meters_per_centimeter;
+    laser_correction.meters_horizontal_offset =
+      px.get<float>("horizOffsetCorrection_", 0.0F) * meters_per_centimeter;
+    insert_laser(lasers, px.get<std::size_t>("id_"), laser_correction);
+  }
+  if (lasers.empty()) {
+    throw std::length_error("db.xml calibration has no lasers");
+  }
+  return from_lasers(lasers);
+}
+
+Calibration Calibration::parse_yaml(std::istream & stream)
+{
+  const YAML::Node root = YAML::Load(stream);
+  const YAML::Node nodes_lasers = root["lasers"];
+  if (!nodes_lasers || !nodes_lasers.IsSequence() || nodes_lasers.size() == 0) {
+    throw std::length_error("yaml calibration has no lasers");
+  }
+
+  std::map<std::size_t, LaserCorrection> lasers;
+  for (const auto & laser : nodes_lasers) {
+    LaserCorrection laser_correction;
+    laser_correction.angle_deg_vertical = rad_to_deg(laser["vert_correction"].as<double>());
+    laser_correction.angle_deg_azimuth_offset =
+      -rad_to_deg(laser["rot_correction"].as<double>(0.0));
+    laser_correction.meters_distance_offset = laser["dist_correction"].as<float>(0.0F);
+    laser_correction.meters_vertical_offset = laser["vert_offset_correction"].as<float>(0.0F);
+    laser_correction.meters_horizontal_offset = laser["horiz_offset_correction"].as<float>(0.0F);
+    insert_laser(lasers, laser["laser_id"].as<std::size_t>(), laser_correction);
+  }
+  return from_lasers(lasers);
+}
+
+Calibration Calibration::from_lasers(const std::map<std::size_t, LaserCorrection> & lasers)
+{
+  // Ids are sorted and unique, so they are contiguous if the highest one is count - 1.
+  if (lasers.rbegin()->first + 1 != lasers.size()) {
+    throw std::runtime_error(
+      "calibration was expected to have laser ids 0 to " + std::to_string(lasers.size() - 1) +
+      " but the highest one is " + std::to_string(lasers.rbegin()->first));
+  }
+  Calibration calibration;
+  for (const auto & laser : lasers) {
+    calibration.lasers_.push_back(laser.second);
+  }
+  return calibration;
+}
+}  // namespace loam_mapper::points_provider::velodyne_calibration
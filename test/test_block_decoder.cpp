@@ -0,0 +1,99 @@
+#include "loam_mapper/block_decoder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace loam_mapper::points_provider::block_decoder
+{
+namespace
+{
+constexpr double rad_per_deg = M_PI / 180.0;
+
+bool are_bytes_equal(float a, float b) { return std::memcmp(&a, &b, sizeof(float)) == 0; }
+}  // namespace
+
+// Random distances, including out of range ones, random azimuths and random laser geometries.
+TEST(BlockDecoder, NativeKernelIsBitIdenticalToScalar)
+{
+  const Isa isa = detect_isa();
+  if (isa == Isa::Scalar) {
+    GTEST_SKIP() << "no SIMD decoder on this CPU";
+  }
+  const DecodeBlockFunction decode_block_native = get_decode_block(isa);
+
+  std::mt19937 generator(42U);
+  std::uniform_real_distribution<double> distribution_vertical(-25.0, 25.0);
+  std::uniform_real_distribution<double> distribution_offset(-0.05, 0.05);
+  std::uniform_real_distribution<double> distribution_firing(-2.0, 2.0);
+  std::uniform_int_distribution<int> distribution_byte(0, 255);
+  std::uniform_int_distribution<int> distribution_azimuth(0, 35999);
+
+  ChannelTable channel_table{};
+  FiringOffsets firing_offsets{};
+  constexpr std::size_t count_blocks = 200000;
+  constexpr std::size_t count_blocks_geometry = 1000;
+  std::size_t count_mismatches = 0;
+  std::size_t count_points_valid = 0;
+  for (std::size_t ind_block = 0; ind_block < count_blocks; ++ind_block) {
+    if (ind_block % count_blocks_geometry == 0) {
+      channel_table.millimeters_per_distance_unit = ind_block % 2 == 0 ? 2U : 4U;
+      channel_table.distance_min =
+        millimeters_range_min / channel_table.millimeters_per_distance_unit;
+      channel_table.distance_max =
+        millimeters_range_max / channel_table.millimeters_per_distance_unit;
+      for (std::size_t i = 0; i < count_channels_block; ++i) {
+        const double angle_rad_vertical = distribution_vertical(generator) * rad_per_deg;
+        channel_table.cos_vertical[i] = static_cast<float>(std::cos(angle_rad_vertical));
+        channel_table.sin_vertical[i] = static_cast<float>(std::sin(angle_rad_vertical));
+        channel_table.offset_xy[i] = static_cast<float>(distribution_offset(generator));
+        channel_table.offset_z[i] = static_cast<float>(distribution_offset(generator));
+        channel_table.offset_horizontal[i] = static_cast<float>(distribution_offset(generator));
+        const double angle_deg_firing = distribution_firing(generator);
+        firing_offsets.angle_deg[i] = static_cast<float>(angle_deg_firing);
+        firing_offsets.sin[i] = static_cast<float>(std::sin(angle_deg_firing * rad_per_deg));
+        firing_offsets.cos[i] = static_cast<float>(std::cos(angle_deg_firing * rad_per_deg));
+      }
+    }
+
+    // One byte past the block is read
+    std::array<std::uint8_t, count_channels_block * size_data_point + 1> data_points{};
+    for (auto & byte : data_points) {
+      byte = static_cast<std::uint8_t>(distribution_byte(generator));
+    }
+    const auto azimuth_multiplied_by_100_deg =
+      static_cast<std::uint16_t>(distribution_azimuth(generator));
+
+    DecodedBlock decoded_scalar{};
+    DecodedBlock decoded_native{};
+    decode_block_scalar(
+      data_points.data(), azimuth_multiplied_by_100_deg, channel_table, firing_offsets,
+      decoded_scalar);
+    decode_block_native(
+      data_points.data(), azimuth_multiplied_by_100_deg, channel_table, firing_offsets,
+      decoded_native);
+
+    bool is_matching = decoded_scalar.mask_valid == decoded_native.mask_valid;
+    for (std::size_t i = 0; i < count_channels_block; ++i) {
+      is_matching = is_matching && are_bytes_equal(
+                                     decoded_scalar.angle_deg_azimuth[i],
+                                     decoded_native.angle_deg_azimuth[i]);
+      // x, y and z are only defined for valid channels
+      if ((decoded_scalar.mask_valid >> i & 1U) == 0U) {
+        continue;
+      }
+      count_points_valid++;
+      is_matching = is_matching && are_bytes_equal(decoded_scalar.x[i], decoded_native.x[i]) &&
+                    are_bytes_equal(decoded_scalar.y[i], decoded_native.y[i]) &&
+                    are_bytes_equal(decoded_scalar.z[i], decoded_native.z[i]);
+    }
+    count_mismatches += is_matching ? 0U : 1U;
+  }
+  EXPECT_EQ(count_mismatches, 0U) << "with " << get_name(isa);
+  // Enough random distances are within the range gate for the valid lanes to be compared
+  EXPECT_GT(count_points_valid, count_blocks * count_channels_block / 4);
+}
+}  // namespace loam_mapper::points_provider::block_decoder
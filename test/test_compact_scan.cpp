@@ -0,0 +1,95 @@
+#include "loam_mapper/compact_scan.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace loam_mapper::point_types
+{
+namespace
+{
+// Points at random positions within +-65 m, fired within nanoseconds_span
+PointColumnsXYZITRH make_scan(std::size_t count_points, std::uint64_t nanoseconds_span)
+{
+  std::mt19937 generator(7U);
+  std::uniform_real_distribution<float> distribution_coordinate(-65.0F, 65.0F);
+  std::uniform_real_distribution<float> distribution_angle(0.0F, 359.99F);
+  std::uniform_int_distribution<std::uint64_t> distribution_nanoseconds(0U, nanoseconds_span);
+  PointColumnsXYZITRH points;
+  for (std::size_t i = 0; i < count_points; ++i) {
+    PointXYZITRH point;
+    point.x = distribution_coordinate(generator);
+    point.y = distribution_coordinate(generator);
+    point.z = distribution_coordinate(generator);
+    point.intensity = static_cast<std::uint32_t>(i % 256U);
+    point.stamp_unix_nanoseconds = 1710000000000000000U + distribution_nanoseconds(generator);
+    point.ring = static_cast<std::uint32_t>(i % 128U + 1U);
+    point.horizontal_angle = distribution_angle(generator);
+    points.push_back(point);
+  }
+  return points;
+}
+}  // namespace
+
+TEST(CompactScan, RoundTripIsWithinTheQuantizationSteps)
+{
+  const PointColumnsXYZITRH points = make_scan(50000, 100000000U);
+  ASSERT_TRUE(CompactScan::is_encodable(points));
+  const CompactScan scan = CompactScan::encode(points);
+  ASSERT_EQ(scan.size(), points.size());
+  EXPECT_LT(scan.get_size_bytes(), points.size() * 15U);
+
+  PointColumnsXYZITRH points_decoded;
+  scan.decode(points_decoded);
+  ASSERT_EQ(points_decoded.size(), points.size());
+  // Half a step, and the float rounding of the coordinates around 65 m
+  constexpr float meters_error_max = CompactScan::meters_per_step / 2.0F + 1.0e-5F;
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    EXPECT_NEAR(points_decoded.x[i], points.x[i], meters_error_max) << "point " << i;
+    EXPECT_NEAR(points_decoded.y[i], points.y[i], meters_error_max) << "point " << i;
+    EXPECT_NEAR(points_decoded.z[i], points.z[i], meters_error_max) << "point " << i;
+    EXPECT_NEAR(points_decoded.horizontal_angle[i], points.horizontal_angle[i], 0.005F + 1.0e-4F)
+      << "point " << i;
+    EXPECT_EQ(points_decoded.intensity[i], points.intensity[i]) << "point " << i;
+    EXPECT_EQ(points_decoded.ring[i], points.ring[i]) << "point " << i;
+    EXPECT_EQ(points_decoded.stamp_unix_nanoseconds[i], points.stamp_unix_nanoseconds[i])
+      << "point " << i;
+  }
+}
+
+TEST(CompactScan, SaturatesCoordinatesOutOfRange)
+{
+  PointColumnsXYZITRH points = make_scan(2, 0U);
+  points.x[0] = 100.0F;
+  points.x[1] = -100.0F;
+  PointColumnsXYZITRH points_decoded;
+  CompactScan::encode(points).decode(points_decoded);
+  EXPECT_FLOAT_EQ(points_decoded.x[0], 32767.0F * CompactScan::meters_per_step);
+  EXPECT_FLOAT_EQ(points_decoded.x[1], -32768.0F * CompactScan::meters_per_step);
+}
+
+TEST(CompactScan, RejectsScansLongerThanTheTimeOffsets)
+{
+  const PointColumnsXYZITRH points = make_scan(2, 0U);
+  PointColumnsXYZITRH points_too_long = points;
+  points_too_long.stamp_unix_nanoseconds[1] =
+    points_too_long.stamp_unix_nanoseconds[0] + 5000000000U;
+  EXPECT_FALSE(CompactScan::is_encodable(points_too_long));
+  EXPECT_THROW(CompactScan::encode(points_too_long), std::range_error);
+
+  PointColumnsXYZITRH points_limit = points;
+  points_limit.stamp_unix_nanoseconds[1] =
+    points_limit.stamp_unix_nanoseconds[0] + std::numeric_limits<std::uint32_t>::max();
+  EXPECT_TRUE(CompactScan::is_encodable(points_limit));
+  PointColumnsXYZITRH points_decoded;
+  CompactScan::encode(points_limit).decode(points_decoded);
+  EXPECT_EQ(points_decoded.stamp_unix_nanoseconds[1], points_limit.stamp_unix_nanoseconds[1]);
+
+  EXPECT_TRUE(CompactScan::is_encodable(PointColumnsXYZITRH()));
+  EXPECT_TRUE(CompactScan::encode(PointColumnsXYZITRH()).empty());
+}
+}  // namespace loam_mapper::point_types
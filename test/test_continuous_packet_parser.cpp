@@ -0,0 +1,272 @@
+#include "loam_mapper/continuous_packet_parser.hpp"
+#include "velodyne_packets.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace loam_mapper::points_provider::continuous_packet_parser
+{
+namespace
+{
+using test::velodyne_packets::Block;
+using test::velodyne_packets::Frame;
+using ScanLease = ContinuousPacketParser::ScanLease;
+
+using CountsIntensities = std::map<std::uint32_t, size_t>;
+
+// Reflectivities of the returns of each kind of firing, they tell the returns apart in the scan.
+constexpr std::uint8_t reflectivity_single = 10U;
+constexpr std::uint8_t reflectivity_last_strongest = 201U;
+constexpr std::uint8_t reflectivity_second_strongest = 101U;
+constexpr std::uint8_t reflectivity_last_weak = 51U;
+constexpr std::uint8_t reflectivity_strongest = 151U;
+constexpr std::uint8_t reflectivity_strongest_without_last = 120U;
+
+// Dual return packets whose block pairs cycle through four kinds of firings by channel:
+//   0: a single return, reported identically in both blocks
+//   1: the last return is the strongest, the strongest block has the second strongest
+//   2: the strongest return comes before a weaker last one
+//   3: the last return is out of range, only the strongest one is valid
+std::vector<Frame> make_frames_dual_return(size_t count_packets)
+{
+  constexpr double deg_per_microsecond = 600.0 * 360.0 / 60.0e6;
+  constexpr double microseconds_toh_start = 1000.0e6;
+  constexpr double microseconds_packet =
+    test::velodyne_packets::count_blocks / 2 * test::velodyne_packets::microseconds_block;
+  std::vector<Frame> frames{test::velodyne_packets::make_frame_position(
+    11, static_cast<std::uint32_t>(microseconds_toh_start))};
+  for (size_t ind_packet = 0; ind_packet < count_packets; ++ind_packet) {
+    std::array<Block, test::velodyne_packets::count_blocks> blocks{};
+    for (size_t ind_firing = 0; ind_firing < blocks.size() / 2; ++ind_firing) {
+      const double microseconds = static_cast<double>(ind_packet) * microseconds_packet +
+                                  static_cast<double>(ind_firing) *
+                                    test::velodyne_packets::microseconds_block;
+      const auto azimuth_multiplied_by_100_deg = static_cast<std::uint16_t>(
+        std::lround((10.0 + deg_per_microsecond * microseconds) * 100.0));
+      auto & block_last = blocks[2 * ind_firing];
+      auto & block_strongest = blocks[2 * ind_firing + 1];
+      block_last.azimuth_multiplied_by_100_deg = azimuth_multiplied_by_100_deg;
+      block_strongest.azimuth_multiplied_by_100_deg = azimuth_multiplied_by_100_deg;
+      for (size_t i = 0; i < test::velodyne_packets::count_channels; ++i) {
+        auto & distance_last = block_last.distances_divided_by_2mm[i];
+        auto & distance_strongest = block_strongest.distances_divided_by_2mm[i];
+        auto & reflectivity_last = block_last.reflectivities[i];
+        auto & reflectivity_strongest_block = block_strongest.reflectivities[i];
+        switch (i % 4) {
+          case 0:
+            distance_last = distance_strongest = 5000U;
+            reflectivity_last = reflectivity_strongest_block = reflectivity_single;
+            break;
+          case 1:
+            distance_last = 6000U;
+            reflectivity_last = reflectivity_last_strongest;
+            distance_strongest = 4000U;
+            reflectivity_strongest_block = reflectivity_second_strongest;
+            break;
+          case 2:
+            distance_last = 7000U;
+            reflectivity_last = reflectivity_last_weak;
+            distance_strongest = 3000U;
+            reflectivity_strongest_block = reflectivity_strongest;
+            break;
+          default:
+            distance_last = 0U;
+            reflectivity_last = 0U;
+            distance_strongest = 5500U;
+            reflectivity_strongest_block = reflectivity_strongest_without_last;
+            break;
+        }
+      }
+    }
+    frames.push_back(test::velodyne_packets::make_frame_data(
+      blocks, static_cast<std::uint32_t>(microseconds_toh_start + ind_packet * microseconds_packet),
+      test::velodyne_packets::byte_return_mode_dual));
+  }
+  return frames;
+}
+
+std::function<void(ScanLease)> get_callback_collect(std::vector<ScanLease> & scans)
+{
+  return [&scans](ScanLease scan) { scans.push_back(std::move(scan)); };
+}
+
+// Appends the scans completed by the frames.
+void decode(
+  ContinuousPacketParser & parser, const std::vector<Frame> & frames,
+  std::vector<ScanLease> & scans)
+{
+  const auto callback_collect = get_callback_collect(scans);
+  for (const auto & frame : frames) {
+    parser.process_packet_into_cloud(frame.data(), frame.size(), callback_collect);
+  }
+}
+
+// Azimuth past the cut azimuth, in [0, 360) degrees
+float get_angle_deg_relative(float angle_deg, float angle_deg_cut)
+{
+  return std::fmod(angle_deg - angle_deg_cut + 360.0F, 360.0F);
+}
+
+// Decodes the frames into one scan and counts its points by intensity.
+CountsIntensities decode_counting_intensities(
+  const std::vector<Frame> & frames, ContinuousPacketParser::DualReturnPolicy dual_return_policy)
+{
+  ContinuousPacketParser parser;
+  parser.set_dual_return_policy(dual_return_policy);
+  parser.set_is_emitting_partial_scan_last(true);
+  std::vector<ScanLease> scans;
+  decode(parser, frames, scans);
+  parser.finish(get_callback_collect(scans));
+
+  CountsIntensities counts_intensities;
+  EXPECT_EQ(scans.size(), 1U);
+  for (const auto & scan : scans) {
+    for (const std::uint32_t intensity : scan->intensity) {
+      counts_intensities[intensity]++;
+    }
+  }
+  return counts_intensities;
+}
+}  // namespace
+
+// The first data packet only sets the rotation speed, the others have 6 firings with 8 channels of
+// each kind.
+TEST(ContinuousPacketParser, DualReturnPolicies)
+{
+  const auto frames = make_frames_dual_return(4);
+  constexpr size_t count = 3 * 6 * 8;
+
+  EXPECT_EQ(
+    decode_counting_intensities(frames, ContinuousPacketParser::DualReturnPolicy::Strongest),
+    (CountsIntensities{
+      {reflectivity_single, count},
+      {reflectivity_last_strongest, count},
+      {reflectivity_strongest, count},
+      {reflectivity_strongest_without_last, count}}));
+  EXPECT_EQ(
+    decode_counting_intensities(frames, ContinuousPacketParser::DualReturnPolicy::Last),
+    (CountsIntensities{
+      {reflectivity_single, count},
+      {reflectivity_last_strongest, count},
+      {reflectivity_last_weak, count}}));
+  // The single returns are decoded once
+  EXPECT_EQ(
+    decode_counting_intensities(frames, ContinuousPacketParser::DualReturnPolicy::Both),
+    (CountsIntensities{
+      {reflectivity_single, count},
+      {reflectivity_last_strongest, count},
+      {reflectivity_second_strongest, count},
+      {reflectivity_last_weak, count},
+      {reflectivity_strongest, count},
+      {reflectivity_strongest_without_last, count}}));
+}
+
+// 40 revolutions cut at an azimuth that no block starts at, so the cut is within blocks.
+TEST(ContinuousPacketParser, CutsAtTheFirstFiringPastTheCutAzimuth)
+{
+  constexpr float angle_deg_cut = 137.5F;
+  constexpr size_t count_packets = 3000;
+  const auto frames = test::velodyne_packets::make_frames_rotating(count_packets, 1000);
+  ContinuousPacketParser parser;
+  parser.set_angle_deg_cut(angle_deg_cut);
+  parser.set_is_emitting_partial_scan_last(true);
+  std::vector<ScanLease> scans;
+  decode(parser, frames, scans);
+  parser.finish(get_callback_collect(scans));
+  ASSERT_GE(scans.size(), 40U);
+
+  size_t count_points = 0;
+  std::uint64_t stamp_unix_nanoseconds_last = 0U;
+  for (size_t i = 0; i < scans.size(); ++i) {
+    const auto & scan = *scans[i];
+    ASSERT_FALSE(scan.empty()) << "scan " << i;
+    count_points += scan.size();
+    // Every point is in exactly one scan, in firing order
+    const auto & stamps = scan.stamp_unix_nanoseconds;
+    EXPECT_LT(stamp_unix_nanoseconds_last, stamps.front()) << "scan " << i;
+    EXPECT_TRUE(std::is_sorted(stamps.begin(), stamps.end())) << "scan " << i;
+    stamp_unix_nanoseconds_last = stamps.back();
+    if (i == 0) {
+      continue;
+    }
+    // The scan starts with the first firing past the cut azimuth, the previous one ends with the
+    // last firing before it. Consecutive firings are at most 18.432 us apart, 0.066 degrees, plus
+    // the hundredths of a degree of the block azimuths.
+    const float angle_deg_relative_last =
+      get_angle_deg_relative(scans[i - 1]->horizontal_angle.back(), angle_deg_cut);
+    const float angle_deg_relative_first =
+      get_angle_deg_relative(scan.horizontal_angle.front(), angle_deg_cut);
+    EXPECT_GT(angle_deg_relative_last, 270.0F) << "scan " << i;
+    EXPECT_LT(angle_deg_relative_first, 90.0F) << "scan " << i;
+    EXPECT_LT(angle_deg_relative_first + 360.0F - angle_deg_relative_last, 0.1F) << "scan " << i;
+  }
+  // The first data packet only sets the rotation speed.
+  EXPECT_EQ(
+    count_points,
+    (count_packets - 1) * test::velodyne_packets::count_blocks *
+      test::velodyne_packets::count_channels);
+}
+
+// A sensor stalled at the cut azimuth, whose blocks jitter a hundredth of a degree to either side
+// of it, cuts once. The next cut comes once it turns again.
+TEST(ContinuousPacketParser, CutsOnceWhileJitteringAroundTheCut)
+{
+  constexpr double microseconds_toh_start = 1000.0e6;
+  constexpr double deg_per_microsecond = 600.0 * 360.0 / 60.0e6;
+  constexpr size_t count_packets_stalled = 20;
+  // 1.6 revolutions
+  constexpr size_t count_packets_turning = 120;
+  std::vector<Frame> frames{test::velodyne_packets::make_frame_position(
+    11, static_cast<std::uint32_t>(microseconds_toh_start))};
+  for (size_t ind_packet = 0; ind_packet < count_packets_stalled + count_packets_turning;
+       ++ind_packet) {
+    const double microseconds_packet =
+      static_cast<double>(ind_packet) * test::velodyne_packets::microseconds_packet_single;
+    std::array<Block, test::velodyne_packets::count_blocks> blocks{};
+    for (size_t ind_block = 0; ind_block < blocks.size(); ++ind_block) {
+      double angle_deg = ind_block % 2 == 0 ? 0.01 : 359.99;
+      if (ind_packet >= count_packets_stalled) {
+        const double microseconds_turning =
+          static_cast<double>(ind_packet - count_packets_stalled + 1) *
+            test::velodyne_packets::microseconds_packet_single +
+          static_cast<double>(ind_block) * test::velodyne_packets::microseconds_block;
+        angle_deg = std::fmod(0.01 + deg_per_microsecond * microseconds_turning, 360.0);
+      }
+      auto & block = blocks[ind_block];
+      block.azimuth_multiplied_by_100_deg =
+        static_cast<std::uint16_t>(std::lround(angle_deg * 100.0) % 36000);
+      block.distances_divided_by_2mm.fill(5000U);
+      block.reflectivities.fill(100U);
+    }
+    frames.push_back(test::velodyne_packets::make_frame_data(
+      blocks, static_cast<std::uint32_t>(microseconds_toh_start + microseconds_packet)));
+  }
+
+  ContinuousPacketParser parser;
+  parser.set_angle_deg_cut(0.0F);
+  parser.set_is_emitting_partial_scan_last(true);
+  std::vector<ScanLease> scans;
+  decode(parser, frames, scans);
+  ASSERT_EQ(scans.size(), 2U);
+  // The first cut is at the first block jittering back past the cut, the first one after the
+  // packet that only sets the rotation speed.
+  EXPECT_EQ(scans[0]->size(), 2 * test::velodyne_packets::count_channels);
+  EXPECT_GT(get_angle_deg_relative(scans[1]->horizontal_angle.back(), 0.0F), 359.9F);
+
+  parser.finish(get_callback_collect(scans));
+  size_t count_points = 0;
+  for (const auto & scan : scans) {
+    count_points += scan->size();
+  }
+  EXPECT_EQ(
+    count_points,
+    (count_packets_stalled + count_packets_turning - 1) * test::velodyne_packets::count_blocks *
+      test::velodyne_packets::count_channels);
+}
+}  // namespace loam_mapper::points_provider::continuous_packet_parser
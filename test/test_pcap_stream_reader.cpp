@@ -0,0 +1,363 @@
+#include "loam_mapper/mapped_pcap_reader.hpp"
+#include "loam_mapper/pcap_stream_reader.hpp"
+#include "velodyne_packets.hpp"
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace loam_mapper::points_provider::pcap_stream_reader
+{
+namespace
+{
+using mapped_pcap_reader::MappedPcapReader;
+using mapped_pcap_reader::PacketView;
+using test::velodyne_packets::Frame;
+using test::velodyne_packets::TemporaryDirectory;
+
+constexpr std::size_t size_chunk = 4UL * 1024UL * 1024UL;
+
+struct Packet
+{
+  std::vector<std::uint8_t> data;
+  std::uint32_t length_original;
+  std::uint32_t stamp_seconds;
+  std::uint32_t stamp_microseconds;
+  std::size_t offset_record;
+};
+
+Packet copy_packet(const PacketView & packet)
+{
+  return {
+    {packet.data, packet.data + packet.length_captured}, packet.length_original,
+    packet.stamp_seconds, packet.stamp_microseconds, packet.offset_record};
+}
+
+std::vector<Packet> read_mapped(const fs::path & path_pcap)
+{
+  MappedPcapReader reader(path_pcap);
+  std::vector<Packet> packets;
+  PacketView packet;
+  while (reader.get_next_packet(packet)) {
+    packets.push_back(copy_packet(packet));
+  }
+  return packets;
+}
+
+std::vector<Packet> read_streamed(const fs::path & path_capture)
+{
+  PcapStreamReader reader(path_capture);
+  std::vector<Packet> packets;
+  PacketView packet;
+  while (reader.get_next_packet(packet)) {
+    packets.push_back(copy_packet(packet));
+  }
+  return packets;
+}
+
+std::vector<std::uint8_t> read_file(const fs::path & path)
+{
+  std::ifstream file(path.string(), std::ios::binary);
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void write_file(const fs::path & path, const std::vector<std::uint8_t> & bytes)
+{
+  std::ofstream file(path.string(), std::ios::binary);
+  file.write(
+    reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+void write_gzip(const fs::path & path, const std::vector<std::uint8_t> & bytes)
+{
+  gzFile file = gzopen(path.c_str(), "wb1");
+  ASSERT_NE(file, nullptr);
+  const int count_written = gzwrite(file, bytes.data(), static_cast<unsigned int>(bytes.size()));
+  ASSERT_EQ(static_cast<std::size_t>(count_written), bytes.size());
+  gzclose(file);
+}
+
+// Compresses the bytes before and after offset_split as two concatenated frames.
+void write_zstd(
+  const fs::path & path, const std::vector<std::uint8_t> & bytes, std::size_t offset_split = 0U)
+{
+  std::vector<std::uint8_t> bytes_compressed;
+  const std::array<std::size_t, 3> offsets{0U, offset_split, bytes.size()};
+  for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+    const std::size_t offset_begin = offsets[i];
+    const std::size_t offset_end = offsets[i + 1];
+    if (offset_begin == offset_end) {
+      continue;
+    }
+    const std::size_t size_before = bytes_compressed.size();
+    bytes_compressed.resize(size_before + ZSTD_compressBound(offset_end - offset_begin));
+    const std::size_t size_compressed = ZSTD_compress(
+      bytes_compressed.data() + size_before, bytes_compressed.size() - size_before,
+      bytes.data() + offset_begin, offset_end - offset_begin, 1);
+    ASSERT_FALSE(ZSTD_isError(size_compressed));
+    bytes_compressed.resize(size_before + size_compressed);
+  }
+  write_file(path, bytes_compressed);
+}
+
+// Appends pcapng blocks in either byte order.
+class PcapngWriter
+{
+public:
+  explicit PcapngWriter(std::vector<std::uint8_t> & bytes) : bytes_{bytes} {}
+
+  void add_section_header(bool is_big_endian)
+  {
+    is_big_endian_ = is_big_endian;
+    begin_block(0x0a0d0d0aU);
+    add_u32(0x1a2b3c4dU);
+    add_u16(1U);
+    add_u16(0U);
+    // Unknown section length
+    add_u32(0xffffffffU);
+    add_u32(0xffffffffU);
+    end_block();
+  }
+
+  // A resolution of 0 leaves if_tsresol out, for the default of microseconds.
+  void add_interface_description(std::uint8_t resolution)
+  {
+    begin_block(1U);
+    add_u16(1U);
+    add_u16(0U);
+    add_u32(65535U);
+    if (resolution != 0U) {
+      add_u16(9U);
+      add_u16(1U);
+      bytes_.insert(bytes_.end(), {resolution, 0U, 0U, 0U});
+      add_u16(0U);
+      add_u16(0U);
+    }
+    end_block();
+  }
+
+  void add_enhanced_packet(std::uint64_t stamp, const Frame & frame, std::uint32_t length_captured)
+  {
+    begin_block(6U);
+    add_u32(0U);
+    add_u32(static_cast<std::uint32_t>(stamp >> 32U));
+    add_u32(static_cast<std::uint32_t>(stamp));
+    add_u32(length_captured);
+    add_u32(static_cast<std::uint32_t>(frame.size()));
+    add_data(frame);
+    end_block();
+  }
+
+  void add_simple_packet(const Frame & frame)
+  {
+    begin_block(3U);
+    add_u32(static_cast<std::uint32_t>(frame.size()));
+    add_data(frame);
+    end_block();
+  }
+
+  void add_unknown_block()
+  {
+    begin_block(0x00000badU);
+    add_u32(0xdeadbeefU);
+    end_block();
+  }
+
+private:
+  std::vector<std::uint8_t> & bytes_;
+  bool is_big_endian_{false};
+  std::size_t offset_block_{0U};
+
+  void add_u16(std::uint16_t value)
+  {
+    for (std::size_t i = 0; i < 2; ++i) {
+      const std::size_t shift = 8U * (is_big_endian_ ? 1U - i : i);
+      bytes_.push_back(static_cast<std::uint8_t>((value >> shift) & 0xFFU));
+    }
+  }
+
+  void add_u32(std::uint32_t value)
+  {
+    for (std::size_t i = 0; i < 4; ++i) {
+      const std::size_t shift = 8U * (is_big_endian_ ? 3U - i : i);
+      bytes_.push_back(static_cast<std::uint8_t>((value >> shift) & 0xFFU));
+    }
+  }
+
+  void add_data(const Frame & frame)
+  {
+    bytes_.insert(bytes_.end(), frame.begin(), frame.end());
+    bytes_.resize((bytes_.size() + 3U) & ~std::size_t{3U}, 0U);
+  }
+
+  void begin_block(std::uint32_t type_block)
+  {
+    offset_block_ = bytes_.size();
+    add_u32(type_block);
+    add_u32(0U);
+  }
+
+  // Fills in the leading block length and appends the trailing copy.
+  void end_block()
+  {
+    const auto length_block = static_cast<std::uint32_t>(bytes_.size() + 4U - offset_block_);
+    add_u32(length_block);
+    const std::vector<std::uint8_t> bytes_length(bytes_.end() - 4, bytes_.end());
+    std::copy(
+      bytes_length.begin(), bytes_length.end(),
+      bytes_.begin() + static_cast<std::ptrdiff_t>(offset_block_ + 4U));
+  }
+};
+
+void expect_packets_equal(
+  const std::vector<Packet> & packets, const std::vector<Packet> & packets_expected,
+  bool is_offset_compared)
+{
+  ASSERT_EQ(packets.size(), packets_expected.size());
+  for (std::size_t i = 0; i < packets.size(); ++i) {
+    SCOPED_TRACE("packet " + std::to_string(i));
+    EXPECT_EQ(packets[i].data, packets_expected[i].data);
+    EXPECT_EQ(packets[i].length_original, packets_expected[i].length_original);
+    EXPECT_EQ(packets[i].stamp_seconds, packets_expected[i].stamp_seconds);
+    EXPECT_EQ(packets[i].stamp_microseconds, packets_expected[i].stamp_microseconds);
+    if (is_offset_compared) {
+      EXPECT_EQ(packets[i].offset_record, packets_expected[i].offset_record);
+    }
+  }
+}
+}  // namespace
+
+// About 10 MiB of records, so that some of them straddle the 4 MiB chunks of the stream.
+class PcapStreamReaderTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    frames_ = test::velodyne_packets::make_frames_rotating(8000, 1000);
+    path_pcap_ = directory_.get_path() / "capture.pcap";
+    test::velodyne_packets::write_pcap(path_pcap_, frames_);
+    packets_expected_ = read_mapped(path_pcap_);
+    ASSERT_EQ(packets_expected_.size(), frames_.size());
+  }
+
+  TemporaryDirectory directory_;
+  std::vector<Frame> frames_;
+  fs::path path_pcap_;
+  std::vector<Packet> packets_expected_;
+};
+
+TEST_F(PcapStreamReaderTest, PcapMatchesMappedReader)
+{
+  bool is_chunk_straddled = false;
+  for (const auto & packet : packets_expected_) {
+    const std::size_t offset_end =
+      packet.offset_record + MappedPcapReader::size_record_header + packet.data.size();
+    for (std::size_t offset_chunk = size_chunk; offset_chunk < offset_end;
+         offset_chunk += size_chunk) {
+      is_chunk_straddled = is_chunk_straddled || packet.offset_record < offset_chunk;
+    }
+  }
+  ASSERT_TRUE(is_chunk_straddled);
+
+  expect_packets_equal(read_streamed(path_pcap_), packets_expected_, true);
+}
+
+TEST_F(PcapStreamReaderTest, CompressedPcapMatchesMappedReader)
+{
+  const std::vector<std::uint8_t> bytes_pcap = read_file(path_pcap_);
+  const fs::path path_gzip = directory_.get_path() / "capture.pcap.gz";
+  const fs::path path_zstd = directory_.get_path() / "capture.pcap.zst";
+  write_gzip(path_gzip, bytes_pcap);
+  write_zstd(path_zstd, bytes_pcap);
+
+  {
+    SCOPED_TRACE("gzip");
+    expect_packets_equal(read_streamed(path_gzip), packets_expected_, true);
+  }
+  {
+    SCOPED_TRACE("zstd");
+    expect_packets_equal(read_streamed(path_zstd), packets_expected_, true);
+  }
+}
+
+// The capture ends with the record straddling the second chunk boundary, compressed as a frame of
+// its own, so the end of the last frame is flushed into a chunk after the input is all read.
+TEST_F(PcapStreamReaderTest, ZstdFlushesTheLastFrameIntoTheNextChunk)
+{
+  std::size_t count_packets = 0;
+  std::size_t offset_end = 0;
+  while (offset_end <= 2 * size_chunk) {
+    const Packet & packet = packets_expected_.at(count_packets++);
+    offset_end = packet.offset_record + MappedPcapReader::size_record_header + packet.data.size();
+  }
+  const std::vector<Packet> packets_expected(
+    packets_expected_.begin(),
+    packets_expected_.begin() + static_cast<std::ptrdiff_t>(count_packets));
+
+  std::vector<std::uint8_t> bytes_pcap = read_file(path_pcap_);
+  bytes_pcap.resize(offset_end);
+  const fs::path path_zstd = directory_.get_path() / "capture_cut.pcap.zst";
+  write_zstd(path_zstd, bytes_pcap, packets_expected.back().offset_record);
+
+  expect_packets_equal(read_streamed(path_zstd), packets_expected, true);
+}
+
+// A little endian section with nanosecond stamps, then a big endian one with the default
+// microsecond stamps. Blocks the reader can't use are skipped, and a trailing simple packet block
+// comes without a stamp.
+TEST_F(PcapStreamReaderTest, PcapngMatchesMappedReader)
+{
+  std::vector<std::uint8_t> bytes_pcapng;
+  PcapngWriter writer(bytes_pcapng);
+  const std::size_t count_first_section = frames_.size() / 2;
+  for (std::size_t i = 0; i < frames_.size(); ++i) {
+    const Packet & packet = packets_expected_[i];
+    const std::uint64_t stamp_microseconds =
+      std::uint64_t{packet.stamp_seconds} * 1000000U + packet.stamp_microseconds;
+    if (i == 0) {
+      writer.add_section_header(false);
+      writer.add_interface_description(9U);
+      writer.add_unknown_block();
+    } else if (i == count_first_section) {
+      writer.add_section_header(true);
+      writer.add_interface_description(0U);
+      // Claims more bytes than the block holds
+      writer.add_enhanced_packet(stamp_microseconds, frames_[i], frames_[i].size() + 4U);
+    }
+    if (i < count_first_section) {
+      writer.add_enhanced_packet(stamp_microseconds * 1000U, frames_[i], frames_[i].size());
+    } else {
+      writer.add_enhanced_packet(stamp_microseconds, frames_[i], frames_[i].size());
+    }
+  }
+  writer.add_simple_packet(frames_.front());
+  ASSERT_GT(bytes_pcapng.size(), 2 * size_chunk);
+
+  std::vector<Packet> packets_expected = packets_expected_;
+  packets_expected.push_back(packets_expected_.front());
+  packets_expected.back().stamp_seconds = 0U;
+  packets_expected.back().stamp_microseconds = 0U;
+
+  const fs::path path_pcapng = directory_.get_path() / "capture.pcapng";
+  const fs::path path_zstd = directory_.get_path() / "capture.pcapng.zst";
+  write_file(path_pcapng, bytes_pcapng);
+  write_zstd(path_zstd, bytes_pcapng);
+
+  {
+    SCOPED_TRACE("uncompressed");
+    expect_packets_equal(read_streamed(path_pcapng), packets_expected, false);
+  }
+  {
+    SCOPED_TRACE("zstd");
+    expect_packets_equal(read_streamed(path_zstd), packets_expected, false);
+  }
+}
+}  // namespace loam_mapper::points_provider::pcap_stream_reader
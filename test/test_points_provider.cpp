@@ -0,0 +1,75 @@
+#include "loam_mapper/points_provider.hpp"
+#include "velodyne_packets.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace loam_mapper::points_provider
+{
+namespace
+{
+using test::velodyne_packets::Frame;
+using test::velodyne_packets::TemporaryDirectory;
+
+template <typename T>
+bool are_bytes_equal(
+  const point_types::AlignedVector<T> & a, const point_types::AlignedVector<T> & b)
+{
+  return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+std::vector<PointsProvider::ScanLease> collect(PointsProvider & points_provider, bool is_parallel)
+{
+  std::vector<PointsProvider::ScanLease> scans;
+  auto callback = [&scans](PointsProvider::ScanLease scan) { scans.push_back(std::move(scan)); };
+  if (is_parallel) {
+    points_provider.process_pcaps_into_clouds_parallel(
+      callback, 0, points_provider.get_count_pcaps(), 3);
+  } else {
+    points_provider.process_pcaps_into_clouds(callback, 0, points_provider.get_count_pcaps());
+  }
+  return scans;
+}
+}  // namespace
+
+// Two captures of 8 MiB ranges each, with position packets further apart than the initial look
+// back window, and a ToH rollover in between.
+TEST(PointsProvider, ParallelDecodeMatchesSerialDecode)
+{
+  TemporaryDirectory directory;
+  const std::vector<Frame> frames = test::velodyne_packets::make_frames_rotating(26000, 4500);
+  const auto middle = frames.begin() + static_cast<std::ptrdiff_t>(frames.size() * 3 / 5);
+  test::velodyne_packets::write_pcap(
+    directory.get_path() / "capture_0.pcap", std::vector<Frame>(frames.begin(), middle));
+  test::velodyne_packets::write_pcap(
+    directory.get_path() / "capture_1.pcap", std::vector<Frame>(middle, frames.end()));
+
+  PointsProvider points_provider(directory.get_path().string());
+  points_provider.size_bytes_prefetch = 0U;
+  points_provider.is_emitting_partial_scan_last = true;
+  points_provider.process();
+  ASSERT_EQ(points_provider.get_count_pcaps(), 2U);
+
+  const auto scans_serial = collect(points_provider, false);
+  const auto scans_parallel = collect(points_provider, true);
+  // 34.5 s at 10 Hz
+  ASSERT_GT(scans_serial.size(), 300U);
+  ASSERT_EQ(scans_parallel.size(), scans_serial.size());
+  for (size_t i = 0; i < scans_serial.size(); ++i) {
+    const auto & serial = *scans_serial[i];
+    const auto & parallel = *scans_parallel[i];
+    ASSERT_GT(serial.size(), 0U) << "scan " << i;
+    EXPECT_TRUE(are_bytes_equal(serial.x, parallel.x)) << "scan " << i;
+    EXPECT_TRUE(are_bytes_equal(serial.y, parallel.y)) << "scan " << i;
+    EXPECT_TRUE(are_bytes_equal(serial.z, parallel.z)) << "scan " << i;
+    EXPECT_TRUE(are_bytes_equal(serial.intensity, parallel.intensity)) << "scan " << i;
+    EXPECT_TRUE(are_bytes_equal(serial.stamp_unix_nanoseconds, parallel.stamp_unix_nanoseconds))
+      << "scan " << i;
+    EXPECT_TRUE(are_bytes_equal(serial.ring, parallel.ring)) << "scan " << i;
+    EXPECT_TRUE(are_bytes_equal(serial.horizontal_angle, parallel.horizontal_angle))
+      << "scan " << i;
+  }
+}
+}  // namespace loam_mapper::points_provider
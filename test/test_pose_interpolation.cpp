@@ -0,0 +1,143 @@
+#include "loam_mapper/pose_interpolation.hpp"
+
+#include <Eigen/Geometry>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace loam_mapper::transform_provider::pose_interpolation
+{
+namespace
+{
+constexpr std::uint64_t stamp_unix_nanoseconds_first = 1710000000000000000U;
+
+// A drive of count_poses poses 5 to 15 ms apart. The orientation turns by up to 2 degrees between
+// most poses and by 40 degrees between some, and is stored as q or -q at random.
+PoseTable make_trajectory(std::size_t count_poses, std::mt19937 & generator)
+{
+  std::uniform_int_distribution<std::uint64_t> distribution_nanoseconds(5000000U, 15000000U);
+  std::uniform_real_distribution<double> distribution_unit(-1.0, 1.0);
+  std::bernoulli_distribution distribution_flip(0.2);
+  PoseTable poses(count_poses);
+  std::uint64_t stamp_unix_nanoseconds = stamp_unix_nanoseconds_first;
+  Eigen::Vector3d position(100.0, -200.0, 30.0);
+  Eigen::Quaterniond orientation = Eigen::Quaterniond::UnitRandom();
+  for (std::size_t i = 0; i < count_poses; ++i) {
+    PoseTable::Values values{};
+    values[PoseTable::column_x] = position.x();
+    values[PoseTable::column_y] = position.y();
+    values[PoseTable::column_z] = position.z();
+    const double sign = distribution_flip(generator) ? -1.0 : 1.0;
+    values[PoseTable::column_orientation_x] = sign * orientation.x();
+    values[PoseTable::column_orientation_y] = sign * orientation.y();
+    values[PoseTable::column_orientation_z] = sign * orientation.z();
+    values[PoseTable::column_orientation_w] = sign * orientation.w();
+    poses.set(i, stamp_unix_nanoseconds, values);
+
+    stamp_unix_nanoseconds += distribution_nanoseconds(generator);
+    position += 0.2 * Eigen::Vector3d(
+                        distribution_unit(generator), distribution_unit(generator),
+                        distribution_unit(generator));
+    // Some poses repeat the orientation of the previous one.
+    double angle_deg = 2.0 * distribution_unit(generator);
+    if (i % 50 == 0) {
+      angle_deg = 40.0;
+    } else if (i % 7 == 0) {
+      angle_deg = 0.0;
+    }
+    const Eigen::Vector3d axis(
+      distribution_unit(generator), distribution_unit(generator), distribution_unit(generator));
+    const Eigen::AngleAxisd rotation(angle_deg * M_PI / 180.0, axis.normalized());
+    orientation = (orientation * Eigen::Quaterniond(rotation)).normalized();
+  }
+  return poses;
+}
+
+Eigen::Quaterniond get_orientation(const PoseTable & poses, std::size_t index)
+{
+  const PoseTable::Values values = poses.get_values(index);
+  return Eigen::Quaterniond(
+    values[PoseTable::column_orientation_w], values[PoseTable::column_orientation_x],
+    values[PoseTable::column_orientation_y], values[PoseTable::column_orientation_z]);
+}
+}  // namespace
+
+// Stamps in random order from a second before the trajectory to a second after it, and the
+// stamps of the poses themselves.
+TEST(PoseInterpolation, MatchesEigenSlerp)
+{
+  std::mt19937 generator(3U);
+  const PoseTable poses = make_trajectory(5000, generator);
+  const pose_lookup::PoseLookup lookup(poses);
+  const std::uint64_t * stamps_poses = poses.get_stamps_unix_nanoseconds();
+  const std::uint64_t stamp_unix_nanoseconds_last = stamps_poses[poses.size() - 1];
+
+  std::uniform_int_distribution<std::uint64_t> distribution_stamp(
+    stamp_unix_nanoseconds_first - 1000000000U, stamp_unix_nanoseconds_last + 1000000000U);
+  std::vector<std::uint64_t> stamps(stamps_poses, stamps_poses + poses.size());
+  for (std::size_t i = 0; i < 45000; ++i) {
+    stamps.push_back(distribution_stamp(generator));
+  }
+  std::shuffle(stamps.begin(), stamps.end(), generator);
+  PoseColumns poses_interpolated;
+  interpolate(poses, lookup, stamps.data(), stamps.size(), poses_interpolated);
+  ASSERT_EQ(poses_interpolated.size(), stamps.size());
+
+  size_t count_before_first = 0;
+  size_t count_after_last = 0;
+  double error_orientation_max = 0.0;
+  for (std::size_t i = 0; i < stamps.size(); ++i) {
+    const std::uint64_t stamp = stamps[i];
+    // Bracketing poses, the first or the last one for stamps outside of the trajectory
+    const auto index_after = static_cast<std::size_t>(
+      std::lower_bound(stamps_poses, stamps_poses + poses.size(), stamp) - stamps_poses);
+    std::size_t index_before = index_after == 0 ? 0 : index_after - 1;
+    std::size_t index_blend = index_after;
+    double ratio = 0.0;
+    if (index_after == 0) {
+      count_before_first++;
+      index_blend = 0;
+    } else if (index_after == poses.size()) {
+      count_after_last++;
+      index_blend = index_before;
+    } else {
+      ratio = static_cast<double>(stamp - stamps_poses[index_before]) /
+              static_cast<double>(stamps_poses[index_after] - stamps_poses[index_before]);
+    }
+
+    const PoseTable::Values values_before = poses.get_values(index_before);
+    const PoseTable::Values values_after = poses.get_values(index_blend);
+    const Eigen::Vector3d position_expected =
+      Eigen::Vector3d(
+        values_before[PoseTable::column_x], values_before[PoseTable::column_y],
+        values_before[PoseTable::column_z]) +
+      ratio * (Eigen::Vector3d(
+                 values_after[PoseTable::column_x], values_after[PoseTable::column_y],
+                 values_after[PoseTable::column_z]) -
+               Eigen::Vector3d(
+                 values_before[PoseTable::column_x], values_before[PoseTable::column_y],
+                 values_before[PoseTable::column_z]));
+    EXPECT_NEAR(poses_interpolated.x[i], position_expected.x(), 1.0e-12) << "stamp " << i;
+    EXPECT_NEAR(poses_interpolated.y[i], position_expected.y(), 1.0e-12) << "stamp " << i;
+    EXPECT_NEAR(poses_interpolated.z[i], position_expected.z(), 1.0e-12) << "stamp " << i;
+
+    const Eigen::Quaterniond orientation_expected =
+      get_orientation(poses, index_before).slerp(ratio, get_orientation(poses, index_blend));
+    const Eigen::Vector4d error(
+      poses_interpolated.orientation_x[i] - orientation_expected.x(),
+      poses_interpolated.orientation_y[i] - orientation_expected.y(),
+      poses_interpolated.orientation_z[i] - orientation_expected.z(),
+      poses_interpolated.orientation_w[i] - orientation_expected.w());
+    error_orientation_max = std::max(error_orientation_max, error.cwiseAbs().maxCoeff());
+  }
+  // A few units in the last place of the quaternion components
+  EXPECT_LT(error_orientation_max, 1.0e-15);
+  // Roughly a fiftieth of the random stamps on each side
+  EXPECT_GT(count_before_first, 500U);
+  EXPECT_GT(count_after_last, 500U);
+}
+}  // namespace loam_mapper::transform_provider::pose_interpolation
@@ -0,0 +1,141 @@
+#include "loam_mapper/pose_lookup.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace loam_mapper::transform_provider::pose_lookup
+{
+namespace
+{
+constexpr std::uint64_t stamp_unix_nanoseconds_first = 1710000000000000000U;
+
+// Poses 1 to 20 ms apart with a gap of a second, some of them sharing a stamp.
+PoseTable make_poses(std::size_t count_poses, std::mt19937 & generator)
+{
+  std::uniform_int_distribution<std::uint64_t> distribution_nanoseconds(1000000U, 20000000U);
+  std::bernoulli_distribution distribution_repeat(0.05);
+  PoseTable poses(count_poses);
+  std::uint64_t stamp_unix_nanoseconds = stamp_unix_nanoseconds_first;
+  for (std::size_t i = 0; i < count_poses; ++i) {
+    poses.set(i, stamp_unix_nanoseconds, PoseTable::Values{});
+    if (i == count_poses / 2) {
+      stamp_unix_nanoseconds += 1000000000U;
+    } else if (!distribution_repeat(generator)) {
+      stamp_unix_nanoseconds += distribution_nanoseconds(generator);
+    }
+  }
+  return poses;
+}
+
+// Sorted stamps from before the first pose to after the last one, every pose stamp among them,
+// some stamps twice and runs of close stamps like the points of a scan.
+std::vector<std::uint64_t> make_stamps(const PoseTable & poses, std::mt19937 & generator)
+{
+  const std::uint64_t * stamps_poses = poses.get_stamps_unix_nanoseconds();
+  const std::uint64_t stamp_first = stamps_poses[0];
+  const std::uint64_t stamp_last = stamps_poses[poses.size() - 1];
+  std::vector<std::uint64_t> stamps(stamps_poses, stamps_poses + poses.size());
+  stamps.insert(stamps.end(), {0U, stamp_first - 1000000000U, stamp_first - 1U});
+  stamps.insert(stamps.end(), {stamp_last + 1U, stamp_last + 1000000000U, UINT64_MAX});
+
+  std::uniform_int_distribution<std::uint64_t> distribution_stamp(
+    stamp_first - 50000000U, stamp_last + 50000000U);
+  std::uniform_int_distribution<std::uint64_t> distribution_step(0U, 100000U);
+  std::bernoulli_distribution distribution_repeat(0.1);
+  for (std::size_t i = 0; i < 2000; ++i) {
+    std::uint64_t stamp = distribution_stamp(generator);
+    for (std::size_t j = 0; j < 50; ++j) {
+      stamps.push_back(stamp);
+      if (distribution_repeat(generator)) {
+        stamps.push_back(stamp);
+      }
+      stamp += distribution_step(generator);
+    }
+  }
+  std::sort(stamps.begin(), stamps.end());
+  return stamps;
+}
+
+void expect_lower_bound(
+  const PoseTable & poses, const PoseLookup & lookup, const std::vector<std::uint64_t> & stamps,
+  PoseLookup::Mode mode)
+{
+  const std::uint64_t * stamps_poses = poses.get_stamps_unix_nanoseconds();
+  PoseLookup::Cursor cursor{mode};
+  for (const std::uint64_t stamp : stamps) {
+    const auto index_expected = static_cast<std::size_t>(
+      std::lower_bound(stamps_poses, stamps_poses + poses.size(), stamp) - stamps_poses);
+    ASSERT_EQ(lookup.find_index_at_or_after(stamp, cursor), index_expected)
+      << "stamp " << stamp;
+  }
+}
+}  // namespace
+
+TEST(PoseLookup, SortedStampsMatchLowerBound)
+{
+  std::mt19937 generator(7U);
+  const PoseTable poses = make_poses(5000, generator);
+  const PoseLookup lookup(poses);
+  const std::vector<std::uint64_t> stamps = make_stamps(poses, generator);
+
+  for (const auto mode : {PoseLookup::Mode::Sequential, PoseLookup::Mode::Random}) {
+    SCOPED_TRACE(mode == PoseLookup::Mode::Sequential ? "Sequential" : "Random");
+    expect_lower_bound(poses, lookup, stamps, mode);
+  }
+}
+
+// A sequential cursor left ahead of the stamp has to fall back to the buckets.
+TEST(PoseLookup, ShuffledStampsMatchLowerBound)
+{
+  std::mt19937 generator(11U);
+  const PoseTable poses = make_poses(5000, generator);
+  const PoseLookup lookup(poses);
+  std::vector<std::uint64_t> stamps = make_stamps(poses, generator);
+  std::shuffle(stamps.begin(), stamps.end(), generator);
+
+  for (const auto mode : {PoseLookup::Mode::Sequential, PoseLookup::Mode::Random}) {
+    SCOPED_TRACE(mode == PoseLookup::Mode::Sequential ? "Sequential" : "Random");
+    expect_lower_bound(poses, lookup, stamps, mode);
+  }
+}
+
+// Each pose stamp right after a stamp just past it, so the cursor is one pose ahead.
+TEST(PoseLookup, StampsSteppingBackMatchLowerBound)
+{
+  std::mt19937 generator(13U);
+  const PoseTable poses = make_poses(5000, generator);
+  const PoseLookup lookup(poses);
+  std::vector<std::uint64_t> stamps;
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    const std::uint64_t stamp_pose = poses.get_stamps_unix_nanoseconds()[i];
+    stamps.insert(stamps.end(), {stamp_pose + 1U, stamp_pose, stamp_pose - 1U});
+  }
+
+  for (const auto mode : {PoseLookup::Mode::Sequential, PoseLookup::Mode::Random}) {
+    SCOPED_TRACE(mode == PoseLookup::Mode::Sequential ? "Sequential" : "Random");
+    expect_lower_bound(poses, lookup, stamps, mode);
+  }
+}
+
+TEST(PoseLookup, SinglePoseAndNoPoses)
+{
+  PoseTable poses_single(1);
+  poses_single.set(0, stamp_unix_nanoseconds_first, PoseTable::Values{});
+  const PoseLookup lookup_single(poses_single);
+  const PoseTable poses_none;
+  const PoseLookup lookup_none(poses_none);
+  const std::vector<std::uint64_t> stamps{
+    0U, stamp_unix_nanoseconds_first - 1U, stamp_unix_nanoseconds_first,
+    stamp_unix_nanoseconds_first, stamp_unix_nanoseconds_first + 1U, UINT64_MAX};
+
+  for (const auto mode : {PoseLookup::Mode::Sequential, PoseLookup::Mode::Random}) {
+    SCOPED_TRACE(mode == PoseLookup::Mode::Sequential ? "Sequential" : "Random");
+    expect_lower_bound(poses_single, lookup_single, stamps, mode);
+    expect_lower_bound(poses_none, lookup_none, stamps, mode);
+  }
+}
+}  // namespace loam_mapper::transform_provider::pose_lookup
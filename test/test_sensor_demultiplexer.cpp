@@ -0,0 +1,71 @@
+#include "loam_mapper/points_provider.hpp"
+#include "velodyne_packets.hpp"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+namespace loam_mapper::points_provider
+{
+namespace
+{
+using test::velodyne_packets::Frame;
+using test::velodyne_packets::TemporaryDirectory;
+
+void set_port_destination(Frame & frame, std::uint16_t port)
+{
+  frame[36] = static_cast<std::uint8_t>(port >> 8U);
+  frame[37] = static_cast<std::uint8_t>(port & 0xFFU);
+}
+}  // namespace
+
+// The second sensor's packets stop for 20 s mid scan, longer than the scans buffered before a
+// sensor stops holding back the others.
+TEST(SensorDemultiplexer, EmitsScansOrderedAcrossASilentSensor)
+{
+  TemporaryDirectory directory;
+  const auto frames_first = test::velodyne_packets::make_frames_rotating(30000, 700);
+  auto frames_second =
+    test::velodyne_packets::make_frames_rotating(30000, 700, 600.0, 123.0, 11, 3590.0e6 + 500.0);
+  for (auto & frame : frames_second) {
+    set_port_destination(frame, frame.size() == 1248 ? 2369U : 8309U);
+  }
+  std::vector<Frame> frames;
+  for (size_t i = 0; i < frames_first.size() || i < frames_second.size(); ++i) {
+    if (i < frames_first.size()) {
+      frames.push_back(frames_first[i]);
+    }
+    if (i < frames_second.size() && (i < 8000 || i >= 23000)) {
+      frames.push_back(frames_second[i]);
+    }
+  }
+  test::velodyne_packets::write_pcap(directory.get_path() / "capture.pcap", frames);
+
+  PointsProvider points_provider(directory.get_path().string());
+  points_provider.size_bytes_prefetch = 0U;
+  points_provider.process();
+  packet_filter::PacketFilter packet_filter_second;
+  packet_filter_second.port_data = 2369U;
+  packet_filter_second.port_position = 8309U;
+
+  std::vector<std::pair<std::uint64_t, size_t>> stamps_sensors;
+  points_provider.process_pcaps_into_clouds_multi_sensor(
+    [&stamps_sensors](PointsProvider::ScanLease scan, size_t index_sensor) {
+      ASSERT_FALSE(scan->empty());
+      stamps_sensors.emplace_back(scan->stamp_unix_nanoseconds.front(), index_sensor);
+    },
+    0, 1, {packet_filter::PacketFilter(), packet_filter_second});
+
+  size_t count_scans_second = 0;
+  for (size_t i = 0; i < stamps_sensors.size(); ++i) {
+    count_scans_second += stamps_sensors[i].second;
+    if (i > 0) {
+      EXPECT_LE(stamps_sensors[i - 1].first, stamps_sensors[i].first) << "scan " << i;
+    }
+  }
+  // 39.8 s and 19.9 s at 10 Hz
+  EXPECT_GT(stamps_sensors.size() - count_scans_second, 390U);
+  EXPECT_GT(count_scans_second, 190U);
+}
+}  // namespace loam_mapper::points_provider
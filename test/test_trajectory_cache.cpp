@@ -0,0 +1,154 @@
+#include "loam_mapper/trajectory_cache.hpp"
+#include "velodyne_packets.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+namespace loam_mapper::transform_provider::trajectory_cache
+{
+namespace
+{
+using test::velodyne_packets::TemporaryDirectory;
+
+constexpr double origin_x = 712345.5;
+constexpr double origin_y = 4312345.25;
+constexpr double origin_z = 42.0;
+
+// Longer than the two 64 KiB ends the key hashes, the last line optionally changed in place.
+void write_source(const fs::path & path_source, bool is_end_changed = false)
+{
+  constexpr std::size_t count_lines = 10000;
+  std::ofstream file(path_source.string(), std::ios::binary | std::ios::trunc);
+  for (std::size_t i = 0; i < count_lines; ++i) {
+    file << (is_end_changed && i + 1 == count_lines ? "changed" : "pose_at")
+         << " 1710000000.000000000 0.0 0.0 0.0 0.0 0.0 0.0 1.0\n";
+  }
+}
+
+PoseTable make_poses(std::size_t count_poses)
+{
+  PoseTable poses(count_poses);
+  for (std::size_t i = 0; i < count_poses; ++i) {
+    PoseTable::Values values;
+    for (std::size_t j = 0; j < PoseTable::count_columns; ++j) {
+      values[j] = static_cast<double>(i) * 0.25 + static_cast<double>(j) * 1000.0 - 3.0;
+    }
+    poses.set(i, 1710000000000000000ULL + i * 10000000ULL, values);
+  }
+  return poses;
+}
+
+class TrajectoryCacheTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    path_source_ = directory_.get_path() / "trajectory.txt";
+    write_source(path_source_);
+    path_cache_ = TrajectoryCache::get_path_cache(path_source_);
+    key_ = CacheKey::make(path_source_, origin_x, origin_y, origin_z);
+    TrajectoryCache::save(path_cache_, key_, poses_);
+  }
+
+  TemporaryDirectory directory_;
+  fs::path path_source_;
+  fs::path path_cache_;
+  CacheKey key_;
+  PoseTable poses_{make_poses(1000)};
+};
+}  // namespace
+
+TEST_F(TrajectoryCacheTest, SavedTableLoadsBack)
+{
+  PoseTable poses;
+  ASSERT_TRUE(TrajectoryCache::load(path_cache_, key_, poses));
+  EXPECT_TRUE(poses.is_mapped());
+  ASSERT_EQ(poses.size(), poses_.size());
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    SCOPED_TRACE("pose " + std::to_string(i));
+    EXPECT_EQ(poses.get_stamps_unix_nanoseconds()[i], poses_.get_stamps_unix_nanoseconds()[i]);
+    for (std::size_t j = 0; j < PoseTable::count_columns; ++j) {
+      const auto column = static_cast<PoseTable::Column>(j);
+      EXPECT_EQ(poses.get_column(column)[i], poses_.get_column(column)[i]);
+    }
+  }
+}
+
+TEST_F(TrajectoryCacheTest, EmptyTableLoadsBack)
+{
+  TrajectoryCache::save(path_cache_, key_, PoseTable());
+  PoseTable poses = make_poses(3);
+  ASSERT_TRUE(TrajectoryCache::load(path_cache_, key_, poses));
+  EXPECT_TRUE(poses.empty());
+}
+
+TEST_F(TrajectoryCacheTest, MissingCacheIsNotLoaded)
+{
+  PoseTable poses;
+  EXPECT_FALSE(TrajectoryCache::load(directory_.get_path() / "missing.cache", key_, poses));
+}
+
+TEST_F(TrajectoryCacheTest, ChangedOriginIsNotLoaded)
+{
+  PoseTable poses;
+  for (const auto & key :
+       {CacheKey::make(path_source_, origin_x + 1.0, origin_y, origin_z),
+        CacheKey::make(path_source_, origin_x, origin_y - 0.5, origin_z),
+        CacheKey::make(path_source_, origin_x, origin_y, origin_z + 1e-3)}) {
+    EXPECT_FALSE(TrajectoryCache::load(path_cache_, key, poses));
+  }
+  EXPECT_TRUE(poses.empty());
+}
+
+TEST_F(TrajectoryCacheTest, TruncatedCacheIsNotLoaded)
+{
+  PoseTable poses;
+  const std::uintmax_t size_cache = fs::file_size(path_cache_);
+  fs::resize_file(path_cache_, size_cache - sizeof(double));
+  EXPECT_FALSE(TrajectoryCache::load(path_cache_, key_, poses));
+  // Shorter than the header
+  fs::resize_file(path_cache_, 16U);
+  EXPECT_FALSE(TrajectoryCache::load(path_cache_, key_, poses));
+  fs::resize_file(path_cache_, 0U);
+  EXPECT_FALSE(TrajectoryCache::load(path_cache_, key_, poses));
+}
+
+TEST_F(TrajectoryCacheTest, ChangedSourceIsNotLoaded)
+{
+  PoseTable poses;
+  const std::time_t time_last_write = fs::last_write_time(path_source_);
+
+  // Same size and modification time, a different end
+  write_source(path_source_, true);
+  fs::last_write_time(path_source_, time_last_write);
+  const CacheKey key_changed_end = CacheKey::make(path_source_, origin_x, origin_y, origin_z);
+  EXPECT_EQ(key_changed_end.size_source, key_.size_source);
+  EXPECT_EQ(key_changed_end.time_last_write_source, key_.time_last_write_source);
+  EXPECT_FALSE(TrajectoryCache::load(path_cache_, key_changed_end, poses));
+
+  // Same contents, touched later
+  write_source(path_source_);
+  fs::last_write_time(path_source_, time_last_write + 1);
+  EXPECT_FALSE(TrajectoryCache::load(
+    path_cache_, CacheKey::make(path_source_, origin_x, origin_y, origin_z), poses));
+
+  // Appended to, with the modification time set back
+  {
+    std::ofstream file(path_source_.string(), std::ios::binary | std::ios::app);
+    file << "\n";
+  }
+  fs::last_write_time(path_source_, time_last_write);
+  EXPECT_FALSE(TrajectoryCache::load(
+    path_cache_, CacheKey::make(path_source_, origin_x, origin_y, origin_z), poses));
+
+  // Restored
+  write_source(path_source_);
+  fs::last_write_time(path_source_, time_last_write);
+  EXPECT_TRUE(TrajectoryCache::load(
+    path_cache_, CacheKey::make(path_source_, origin_x, origin_y, origin_z), poses));
+}
+}  // namespace loam_mapper::transform_provider::trajectory_cache
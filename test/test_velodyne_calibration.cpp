@@ -0,0 +1,117 @@
+#include "loam_mapper/velodyne_calibration.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace loam_mapper::points_provider::velodyne_calibration
+{
+namespace
+{
+// Trimmed VeloView export of two lasers, listed out of id order
+constexpr const char * db_xml = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes" ?>
+<!DOCTYPE boost_serialization>
+<boost_serialization signature="serialization::archive" version="4">
+<DB class_id="0" tracking_level="0" version="0">
+  <distLSB_>0.2</distLSB_>
+  <points_ class_id="1" tracking_level="0" version="0">
+    <count>2</count>
+    <item_version>1</item_version>
+    <item class_id="2" tracking_level="0" version="1">
+      <px class_id="3" tracking_level="1" version="1" object_id="_0">
+        <id_>1</id_>
+        <rotCorrection_>-1.5</rotCorrection_>
+        <vertCorrection_>1.25</vertCorrection_>
+        <distCorrection_>120</distCorrection_>
+        <vertOffsetCorrection_>11.2</vertOffsetCorrection_>
+        <horizOffsetCorrection_>2.6</horizOffsetCorrection_>
+      </px>
+    </item>
+    <item>
+      <px class_id_reference="3" object_id="_1">
+        <id_>0</id_>
+        <rotCorrection_>0.5</rotCorrection_>
+        <vertCorrection_>-15</vertCorrection_>
+      </px>
+    </item>
+  </points_>
+</DB>
+</boost_serialization>
+)";
+
+// Same lasers as the velodyne_pointcloud driver has them
+constexpr const char * yaml = R"(lasers:
+- {dist_correction: 1.2, horiz_offset_correction: 0.026, laser_id: 1,
+   rot_correction: 0.02617993877991494, vert_correction: 0.021816615649929118,
+   vert_offset_correction: 0.112}
+- {laser_id: 0, rot_correction: -0.008726646259971648, vert_correction: -0.2617993877991494}
+num_lasers: 2
+)";
+
+Calibration parse_db_xml(const std::string & text)
+{
+  std::istringstream stream(text);
+  return Calibration::parse_db_xml(stream);
+}
+
+Calibration parse_yaml(const std::string & text)
+{
+  std::istringstream stream(text);
+  return Calibration::parse_yaml(stream);
+}
+}  // namespace
+
+TEST(VelodyneCalibration, ParsesDbXmlInCentimeters)
+{
+  const Calibration calibration = parse_db_xml(db_xml);
+  ASSERT_EQ(calibration.get_count_lasers(), 2U);
+
+  const auto & laser_0 = calibration.get_laser(0);
+  EXPECT_FLOAT_EQ(laser_0.angle_deg_vertical, -15.0F);
+  EXPECT_FLOAT_EQ(laser_0.angle_deg_azimuth_offset, -0.5F);
+  EXPECT_FLOAT_EQ(laser_0.meters_distance_offset, 0.0F);
+  EXPECT_FLOAT_EQ(laser_0.meters_vertical_offset, 0.0F);
+  EXPECT_FLOAT_EQ(laser_0.meters_horizontal_offset, 0.0F);
+
+  const auto & laser_1 = calibration.get_laser(1);
+  EXPECT_FLOAT_EQ(laser_1.angle_deg_vertical, 1.25F);
+  EXPECT_FLOAT_EQ(laser_1.angle_deg_azimuth_offset, 1.5F);
+  EXPECT_FLOAT_EQ(laser_1.meters_distance_offset, 1.2F);
+  EXPECT_FLOAT_EQ(laser_1.meters_vertical_offset, 0.112F);
+  EXPECT_FLOAT_EQ(laser_1.meters_horizontal_offset, 0.026F);
+}
+
+TEST(VelodyneCalibration, ParsesYamlInRadians)
+{
+  const Calibration calibration = parse_yaml(yaml);
+  ASSERT_EQ(calibration.get_count_lasers(), 2U);
+
+  const auto & laser_0 = calibration.get_laser(0);
+  EXPECT_FLOAT_EQ(laser_0.angle_deg_vertical, -15.0F);
+  EXPECT_FLOAT_EQ(laser_0.angle_deg_azimuth_offset, 0.5F);
+  EXPECT_FLOAT_EQ(laser_0.meters_distance_offset, 0.0F);
+
+  const auto & laser_1 = calibration.get_laser(1);
+  EXPECT_FLOAT_EQ(laser_1.angle_deg_vertical, 1.25F);
+  EXPECT_FLOAT_EQ(laser_1.angle_deg_azimuth_offset, -1.5F);
+  EXPECT_FLOAT_EQ(laser_1.meters_distance_offset, 1.2F);
+  EXPECT_FLOAT_EQ(laser_1.meters_vertical_offset, 0.112F);
+  EXPECT_FLOAT_EQ(laser_1.meters_horizontal_offset, 0.026F);
+}
+
+TEST(VelodyneCalibration, RejectsMissingAndRepeatedLaserIds)
+{
+  EXPECT_THROW(
+    parse_yaml("lasers:\n- {laser_id: 0, vert_correction: 0.1}\n- {laser_id: 2, "
+               "vert_correction: 0.2}\n"),
+    std::runtime_error);
+  EXPECT_THROW(
+    parse_yaml("lasers:\n- {laser_id: 0, vert_correction: 0.1}\n- {laser_id: 0, "
+               "vert_correction: 0.2}\n"),
+    std::runtime_error);
+  EXPECT_THROW(parse_yaml("num_lasers: 0\n"), std::length_error);
+}
+}  // namespace loam_mapper::points_provider::velodyne_calibration
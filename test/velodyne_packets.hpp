@@ -0,0 +1,198 @@
+#ifndef VELODYNE_PACKETS_HPP_
+#define VELODYNE_PACKETS_HPP_
+
+#include <boost/filesystem.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Builds Velodyne VLP-16 frames and pcap files for the tests.
+namespace loam_mapper::test::velodyne_packets
+{
+namespace fs = boost::filesystem;
+using Frame = std::vector<std::uint8_t>;
+
+constexpr std::uint8_t byte_return_mode_strongest = 55U;
+constexpr std::uint8_t byte_return_mode_last = 56U;
+constexpr std::uint8_t byte_return_mode_dual = 57U;
+constexpr std::uint8_t byte_product_id_vlp16 = 34U;
+
+constexpr std::size_t count_blocks = 12;
+constexpr std::size_t count_channels = 32;
+// VLP-16 timing: 16 lasers firing every 2.304 us, a firing sequence every 55.296 us and two
+// sequences per block
+constexpr double microseconds_block = 110.592;
+constexpr double microseconds_packet_single = count_blocks * microseconds_block;
+
+struct Block
+{
+  std::uint16_t azimuth_multiplied_by_100_deg{0U};
+  std::array<std::uint16_t, count_channels> distances_divided_by_2mm{};
+  std::array<std::uint8_t, count_channels> reflectivities{};
+};
+
+inline void write_u16_little_endian(std::uint8_t * bytes, std::uint16_t value)
+{
+  bytes[0] = static_cast<std::uint8_t>(value & 0xFFU);
+  bytes[1] = static_cast<std::uint8_t>(value >> 8U);
+}
+
+inline void write_u32_little_endian(std::uint8_t * bytes, std::uint32_t value)
+{
+  for (std::size_t i = 0; i < 4; ++i) {
+    bytes[i] = static_cast<std::uint8_t>((value >> (8U * i)) & 0xFFU);
+  }
+}
+
+// Untagged Ethernet II, IPv4 and UDP headers addressed to port_destination
+inline Frame make_frame(std::size_t length_frame, std::uint16_t port_destination)
+{
+  Frame frame(length_frame, 0U);
+  frame[12] = 0x08U;
+  frame[13] = 0x00U;
+  frame[14] = 0x45U;
+  frame[23] = 17U;
+  // 192.168.1.201
+  frame[26] = 192U;
+  frame[27] = 168U;
+  frame[28] = 1U;
+  frame[29] = 201U;
+  frame[36] = static_cast<std::uint8_t>(port_destination >> 8U);
+  frame[37] = static_cast<std::uint8_t>(port_destination & 0xFFU);
+  return frame;
+}
+
+inline Frame make_frame_data(
+  const std::array<Block, count_blocks> & blocks, std::uint32_t microseconds_toh,
+  std::uint8_t byte_return_mode = byte_return_mode_strongest, std::uint16_t port = 2368U)
+{
+  Frame frame = make_frame(1248, port);
+  std::uint8_t * block_bytes = frame.data() + 42;
+  for (const auto & block : blocks) {
+    block_bytes[0] = 0xFFU;
+    block_bytes[1] = 0xEEU;
+    write_u16_little_endian(block_bytes + 2, block.azimuth_multiplied_by_100_deg);
+    for (std::size_t i = 0; i < count_channels; ++i) {
+      write_u16_little_endian(block_bytes + 4 + 3 * i, block.distances_divided_by_2mm[i]);
+      block_bytes[4 + 3 * i + 2] = block.reflectivities[i];
+    }
+    block_bytes += 100;
+  }
+  write_u32_little_endian(frame.data() + 1242, microseconds_toh);
+  frame[1246] = byte_return_mode;
+  frame[1247] = byte_product_id_vlp16;
+  return frame;
+}
+
+// GPRMC sentence dated 2024-03-16 at hour, receiver status A or V
+inline Frame make_frame_position(
+  int hour, std::uint32_t microseconds_toh, bool is_active = true, std::uint16_t port = 8308U)
+{
+  Frame frame = make_frame(554, port);
+  write_u32_little_endian(frame.data() + 238, microseconds_toh);
+  const unsigned seconds_toh = microseconds_toh / 1000000U;
+  char nmea_sentence[128] = {};
+  std::snprintf(
+    nmea_sentence, sizeof(nmea_sentence),
+    "$GPRMC,%02d%02u%02u,%c,4807.038,N,01131.000,E,022.4,084.4,160324,003.1,W,A*6A\r\n", hour,
+    seconds_toh / 60U, seconds_toh % 60U, is_active ? 'A' : 'V');
+  std::copy(nmea_sentence, nmea_sentence + sizeof(nmea_sentence), frame.begin() + 246);
+  return frame;
+}
+
+// Data packets of a VLP-16 spinning at rpm in strongest return mode, from azimuth_deg_start and
+// microseconds_toh_start within hour_start, with a position packet before every
+// stride_position'th one. Distances and reflectivities follow from the packet index, so every
+// return is within the range gate.
+inline std::vector<Frame> make_frames_rotating(
+  std::size_t count_packets, std::size_t stride_position, double rpm = 600.0,
+  double azimuth_deg_start = 0.0, int hour_start = 11,
+  double microseconds_toh_start = 3590.0e6)
+{
+  const double deg_per_microsecond = rpm * 360.0 / 60.0e6;
+  std::vector<Frame> frames;
+  for (std::size_t ind_packet = 0; ind_packet < count_packets; ++ind_packet) {
+    const double microseconds =
+      microseconds_toh_start + static_cast<double>(ind_packet) * microseconds_packet_single;
+    const int hour = hour_start + static_cast<int>(microseconds / 3600.0e6);
+    const auto microseconds_toh =
+      static_cast<std::uint32_t>(std::llround(std::fmod(microseconds, 3600.0e6)));
+    if (ind_packet % stride_position == 0) {
+      frames.push_back(make_frame_position(hour, microseconds_toh));
+    }
+    std::array<Block, count_blocks> blocks{};
+    for (std::size_t ind_block = 0; ind_block < count_blocks; ++ind_block) {
+      const double azimuth_deg = std::fmod(
+        azimuth_deg_start +
+          deg_per_microsecond * (microseconds - microseconds_toh_start +
+                                 static_cast<double>(ind_block) * microseconds_block),
+        360.0);
+      auto & block = blocks[ind_block];
+      block.azimuth_multiplied_by_100_deg =
+        static_cast<std::uint16_t>(std::lround(azimuth_deg * 100.0) % 36000);
+      for (std::size_t i = 0; i < count_channels; ++i) {
+        block.distances_divided_by_2mm[i] =
+          static_cast<std::uint16_t>(1000U + (ind_packet * 7U + ind_block * 3U + i * 11U) % 20000U);
+        block.reflectivities[i] = static_cast<std::uint8_t>((ind_packet + i) % 256U);
+      }
+    }
+    frames.push_back(make_frame_data(blocks, microseconds_toh));
+  }
+  return frames;
+}
+
+// Classic little endian pcap with microsecond stamps, one record per frame
+inline void write_pcap(const fs::path & path_pcap, const std::vector<Frame> & frames)
+{
+  std::ofstream file(path_pcap.string(), std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("cannot write " + path_pcap.string());
+  }
+  std::uint8_t header_global[24] = {};
+  write_u32_little_endian(header_global, 0xA1B2C3D4U);
+  write_u16_little_endian(header_global + 4, 2U);
+  write_u16_little_endian(header_global + 6, 4U);
+  write_u32_little_endian(header_global + 16, 65535U);
+  write_u32_little_endian(header_global + 20, 1U);
+  file.write(reinterpret_cast<const char *>(header_global), sizeof(header_global));
+  std::uint32_t stamp_microseconds = 0U;
+  for (const auto & frame : frames) {
+    std::uint8_t header_record[16] = {};
+    write_u32_little_endian(header_record, 1710000000U + stamp_microseconds / 1000000U);
+    write_u32_little_endian(header_record + 4, stamp_microseconds % 1000000U);
+    write_u32_little_endian(header_record + 8, static_cast<std::uint32_t>(frame.size()));
+    write_u32_little_endian(header_record + 12, static_cast<std::uint32_t>(frame.size()));
+    file.write(reinterpret_cast<const char *>(header_record), sizeof(header_record));
+    file.write(
+      reinterpret_cast<const char *>(frame.data()), static_cast<std::streamsize>(frame.size()));
+    stamp_microseconds += 663U;
+  }
+}
+
+// Fresh directory under the system temporary directory, removed with the object
+class TemporaryDirectory
+{
+public:
+  TemporaryDirectory()
+  : path_{fs::temp_directory_path() / fs::unique_path("loam_mapper_test_%%%%-%%%%-%%%%")}
+  {
+    fs::create_directories(path_);
+  }
+  ~TemporaryDirectory() { fs::remove_all(path_); }
+  TemporaryDirectory(const TemporaryDirectory &) = delete;
+  TemporaryDirectory & operator=(const TemporaryDirectory &) = delete;
+
+  [[nodiscard]] const fs::path & get_path() const { return path_; }
+
+private:
+  fs::path path_;
+};
+}  // namespace loam_mapper::test::velodyne_packets
+
+#endif  // VELODYNE_PACKETS_HPP_